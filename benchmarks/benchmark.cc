@@ -0,0 +1,109 @@
+// Copyright (c) 2015, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#include "benchmark.hh"
+
+#include <cstdlib>
+#include <new>
+#include <iomanip>
+#include <boost/atomic.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+namespace {
+  boost::atomic < std::size_t > allocationCount (0);
+
+  void* allocate (std::size_t size)
+  {
+    ++allocationCount;
+    void* p = std::malloc (size == 0 ? 1 : size);
+    if (!p) throw std::bad_alloc ();
+    return p;
+  }
+}
+
+void* operator new (std::size_t size)
+{
+  return allocate (size);
+}
+
+void* operator new[] (std::size_t size)
+{
+  return allocate (size);
+}
+
+void operator delete (void* p) throw ()
+{
+  std::free (p);
+}
+
+void operator delete[] (void* p) throw ()
+{
+  std::free (p);
+}
+
+namespace hpp_benchmark {
+  std::size_t allocations ()
+  {
+    return allocationCount;
+  }
+
+  double now ()
+  {
+    static const boost::posix_time::ptime origin =
+      boost::posix_time::microsec_clock::universal_time ();
+    return 1e-6 * (double) (boost::posix_time::microsec_clock::universal_time ()
+        - origin).total_microseconds ();
+  }
+
+  Result run (const std::string& name, const Operation_t& operation,
+      const double& minTime)
+  {
+    operation ();
+    Result result;
+    result.name = name;
+    for (std::size_t n = 1;; n *= 2) {
+      const std::size_t allocationsBefore = allocations ();
+      const double start = now ();
+      for (std::size_t i = 0; i < n; ++i) operation ();
+      const double duration = now () - start;
+      const std::size_t nbAllocations = allocations () - allocationsBefore;
+      if (duration >= minTime || n >= ((std::size_t) 1 << 30)) {
+        result.iterations = n;
+        result.nsPerOp = 1e9 * duration / (double) n;
+        result.allocationsPerOp = (double) nbAllocations / (double) n;
+        return result;
+      }
+    }
+  }
+
+  std::ostream& printHeader (std::ostream& os)
+  {
+    return os << std::left << std::setw (40) << "Operation"
+      << std::right << std::setw (12) << "Iterations"
+      << std::setw (14) << "ns/op" << std::setw (14) << "allocs/op"
+      << std::endl;
+  }
+
+  std::ostream& print (std::ostream& os, const Result& result)
+  {
+    return os << std::left << std::setw (40) << result.name
+      << std::right << std::setw (12) << result.iterations
+      << std::fixed << std::setprecision (1)
+      << std::setw (14) << result.nsPerOp
+      << std::setprecision (2)
+      << std::setw (14) << result.allocationsPerOp << std::endl;
+  }
+} // namespace hpp_benchmark
@@ -0,0 +1,62 @@
+// Copyright (c) 2015, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_BENCHMARKS_BENCHMARK_HH
+# define HPP_MANIPULATION_BENCHMARKS_BENCHMARK_HH
+
+# include <string>
+# include <ostream>
+# include <boost/function.hpp>
+
+namespace hpp_benchmark {
+  /// Operation whose duration is measured.
+  typedef boost::function < void () > Operation_t;
+
+  /// Number of calls to operator new since the start of the program.
+  /// Allocations are counted by the replacement of operator new linked in
+  /// each benchmark.
+  std::size_t allocations ();
+
+  /// Current time, in seconds.
+  double now ();
+
+  /// Measurement of an operation.
+  struct Result {
+    std::string name;
+    /// Number of calls of the measured batch.
+    std::size_t iterations;
+    /// Mean duration of a call, in nanoseconds.
+    double nsPerOp;
+    /// Mean number of allocations of a call.
+    double allocationsPerOp;
+  };
+
+  /// Measure the mean duration and number of allocations of an operation.
+  ///
+  /// The operation is called once to warm the caches, then in batches
+  /// whose size doubles until a batch lasts at least minTime.
+  /// \param minTime minimal duration of the measured batch, in seconds.
+  Result run (const std::string& name, const Operation_t& operation,
+      const double& minTime = .2);
+
+  /// Print the header of the table of results.
+  std::ostream& printHeader (std::ostream& os);
+
+  /// Print a result as a row of the table.
+  std::ostream& print (std::ostream& os, const Result& result);
+} // namespace hpp_benchmark
+
+#endif // HPP_MANIPULATION_BENCHMARKS_BENCHMARK_HH
@@ -0,0 +1,187 @@
+// Copyright (c) 2015, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+/// \file
+/// Micro-benchmarks of the hot paths of the constraint graph, on the
+/// planar arm of the tests.
+///
+/// Usage: constraint-graph [number of grasp states] [minimal time per
+/// benchmark, in seconds]
+///
+/// For each operation, prints the mean duration of a call in nanoseconds
+/// and the mean number of calls to operator new.
+
+#include <cstdlib>
+#include <iostream>
+#include <boost/bind.hpp>
+
+#include <hpp/core/weighed-distance.hh>
+#include <hpp/core/discretized-collision-checking.hh>
+
+#include "hpp/manipulation/roadmap.hh"
+#include "hpp/manipulation/graph-steering-method.hh"
+#include "hpp/manipulation/graph-path-validation.hh"
+
+#include "benchmark.hh"
+#include "synthetic-graph.hh"
+
+using hpp::manipulation::Configuration_t;
+using hpp::manipulation::ConfigurationPtr_t;
+using hpp::manipulation::Roadmap;
+using hpp::manipulation::RoadmapPtr_t;
+using hpp::manipulation::GraphSteeringMethod;
+using hpp::manipulation::GraphSteeringMethodPtr_t;
+using hpp::manipulation::GraphPathValidation;
+using hpp::manipulation::GraphPathValidationPtr_t;
+using hpp::core::PathPtr_t;
+using hpp::core::WeighedDistance;
+using hpp::core::WeighedDistancePtr_t;
+
+namespace hpp_benchmark {
+  /// Objects used by the benchmarks.
+  struct Fixture {
+    SyntheticGraph g;
+    WeighedDistancePtr_t distance;
+    RoadmapPtr_t roadmap;
+    GraphSteeringMethodPtr_t steeringMethod;
+    GraphPathValidationPtr_t pathValidation;
+    /// A configuration of the free state.
+    Configuration_t qFree;
+    /// A configuration of the first grasp state.
+    Configuration_t qGrasp;
+    /// A path from qFree to qGrasp.
+    PathPtr_t path;
+    /// Buffers of the benchmarks.
+    Configuration_t q;
+    PathPtr_t result;
+    hpp::core::NodePtr_t node;
+  };
+
+  void getNode (Fixture& f)
+  {
+    f.g.graph->getNode (f.qFree);
+  }
+
+  void chooseEdge (Fixture& f)
+  {
+    f.g.graph->nodeSelector ()->chooseEdge (f.g.free);
+  }
+
+  void applyConstraints (Fixture& f)
+  {
+    f.q = f.qFree;
+    f.g.edge->applyConstraints (f.qFree, f.q);
+  }
+
+  void build (Fixture& f)
+  {
+    f.g.edge->build (f.result, f.qFree, f.qGrasp, *f.distance);
+  }
+
+  void buildWaypoint (Fixture& f)
+  {
+    f.g.waypointEdge->build (f.result, f.qFree, f.qGrasp, *f.distance);
+  }
+
+  void applyLevelSetConstraints (Fixture& f)
+  {
+    f.q = f.qFree;
+    f.g.levelSetEdge->applyConstraints (f.node, f.q);
+  }
+
+  void steer (Fixture& f)
+  {
+    f.result = (*f.steeringMethod) (f.qFree, f.qGrasp);
+  }
+
+  void validate (Fixture& f)
+  {
+    f.pathValidation->validate (f.path, false, f.result);
+  }
+
+  /// Add to the roadmap configurations of the free state in several
+  /// leaves of the level set.
+  void fillRoadmap (Fixture& f, const std::size_t& nbNodes)
+  {
+    for (std::size_t i = 0; i < nbNodes; ++i) {
+      ConfigurationPtr_t q (new Configuration_t (f.qFree));
+      (*q) [0] = -1 + 2 * (value_type) i / (value_type) nbNodes;
+      hpp::core::NodePtr_t n = f.roadmap->addNode (q);
+      if (i == 0) f.node = n;
+    }
+  }
+} // namespace hpp_benchmark
+
+int main (int argc, char** argv)
+{
+  using namespace hpp_benchmark;
+  const std::size_t nbGrasps = argc > 1 ? std::atoi (argv [1]) : 8;
+  const double minTime = argc > 2 ? std::atof (argv [2]) : .2;
+  if (nbGrasps == 0) {
+    std::cerr << "The number of grasp states must be positive." << std::endl;
+    return 1;
+  }
+
+  Fixture f;
+  f.g = createGraph (nbGrasps);
+  f.distance = WeighedDistance::create (f.g.robot);
+  f.roadmap = Roadmap::create (f.distance, f.g.robot);
+  f.roadmap->constraintGraph (f.g.graph);
+  f.roadmap->insertHistogram (f.g.histogram);
+  f.steeringMethod = GraphSteeringMethod::create (f.g.robot);
+  f.steeringMethod->constraintGraph (f.g.graph);
+  f.pathValidation = GraphPathValidation::create <
+    hpp::core::DiscretizedCollisionChecking > (f.g.robot, 0.05);
+  f.pathValidation->constraintGraph (f.g.graph);
+  f.g.graph->initialize ();
+
+  // In the zero configuration, the tip is above all the grasps.
+  f.qFree = Configuration_t::Zero (f.g.robot->configSize ());
+  f.qGrasp = f.qFree;
+  if (!f.g.edge->applyConstraints (f.qFree, f.qGrasp)) {
+    std::cerr << "Could not project onto " << f.g.grasps [0]->name ()
+      << std::endl;
+    return 1;
+  }
+  if (!f.g.edge->build (f.path, f.qFree, f.qGrasp, *f.distance)) {
+    std::cerr << "Could not build " << f.g.edge->name () << std::endl;
+    return 1;
+  }
+  fillRoadmap (f, 16);
+  f.q = f.qFree;
+
+  std::cout << nbGrasps << " grasp states, "
+    << f.g.graph->nodeSelector ()->getNodes ().size () << " states."
+    << std::endl;
+  printHeader (std::cout);
+  print (std::cout, run ("Graph::getNode",
+        boost::bind (&getNode, boost::ref (f)), minTime));
+  print (std::cout, run ("NodeSelector::chooseEdge",
+        boost::bind (&chooseEdge, boost::ref (f)), minTime));
+  print (std::cout, run ("Edge::applyConstraints",
+        boost::bind (&applyConstraints, boost::ref (f)), minTime));
+  print (std::cout, run ("Edge::build",
+        boost::bind (&build, boost::ref (f)), minTime));
+  print (std::cout, run ("WaypointEdge::build",
+        boost::bind (&buildWaypoint, boost::ref (f)), minTime));
+  print (std::cout, run ("LevelSetEdge::applyConstraints",
+        boost::bind (&applyLevelSetConstraints, boost::ref (f)), minTime));
+  print (std::cout, run ("GraphSteeringMethod::impl_compute",
+        boost::bind (&steer, boost::ref (f)), minTime));
+  print (std::cout, run ("GraphPathValidation::validate",
+        boost::bind (&validate, boost::ref (f)), minTime));
+  return 0;
+}
@@ -0,0 +1,155 @@
+// Copyright (c) 2015, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+/// \file
+/// Scaling of the constraint graph with its number of states, on the
+/// planar arm of the tests.
+///
+/// Usage: graph-scaling [edges per state] [planning time, in seconds]
+/// [number of grasp states...]
+///
+/// For each number of grasp states, 10, 100, 1000 and 10000 by default, a
+/// synthetic graph is built (see createGraph) and a CSV row is printed
+/// with:
+/// \li states, edges: size of the graph,
+/// \li components: size of the registry of graph::GraphComponent, which
+///     keeps the components of the previous graphs,
+/// \li construction, initialization: time to create the graph and to
+///     build its constraints (graph::Graph::initialize), in seconds,
+/// \li classificationNs, classificationAllocs: duration and number of
+///     allocations of graph::Graph::getNode, for a configuration of the
+///     free state, which is the last state tried,
+/// \li iterationsPerSecond, roadmapNodes: number of steps per second of
+///     the ManipulationPlanner and size of the roadmap at the end of the
+///     planning time.
+
+#include <cstdlib>
+#include <vector>
+#include <iostream>
+#include <boost/bind.hpp>
+
+#include <hpp/core/discretized-collision-checking.hh>
+
+#include "hpp/manipulation/problem.hh"
+#include "hpp/manipulation/roadmap.hh"
+#include "hpp/manipulation/manipulation-planner.hh"
+#include "hpp/manipulation/graph-path-validation.hh"
+
+#include "benchmark.hh"
+#include "synthetic-graph.hh"
+
+using hpp::manipulation::Configuration_t;
+using hpp::manipulation::ConfigurationPtr_t;
+using hpp::manipulation::Problem;
+using hpp::manipulation::Roadmap;
+using hpp::manipulation::RoadmapPtr_t;
+using hpp::manipulation::ManipulationPlanner;
+using hpp::manipulation::ManipulationPlannerPtr_t;
+using hpp::manipulation::GraphPathValidation;
+
+namespace hpp_benchmark {
+  void getNode (const SyntheticGraph& g, const Configuration_t& q)
+  {
+    g.graph->getNode (q);
+  }
+
+  std::ostream& printCSVHeader (std::ostream& os)
+  {
+    return os << "states,edgesPerState,edges,components,construction,"
+      "initialization,classificationNs,classificationAllocs,"
+      "iterationsPerSecond,roadmapNodes" << std::endl;
+  }
+
+  /// Build a graph, measure it and print a CSV row.
+  void measure (const std::size_t& nbGrasps, const std::size_t& edgesPerState,
+      const double& planningTime)
+  {
+    double start = now ();
+    SyntheticGraph g = createGraph (nbGrasps, edgesPerState);
+    const double construction = now () - start;
+
+    start = now ();
+    g.graph->initialize ();
+    const double initialization = now () - start;
+
+    // In the zero configuration, the tip is above all the grasps.
+    const Configuration_t qFree =
+      Configuration_t::Zero (g.robot->configSize ());
+    const Result classification = run ("Graph::getNode", boost::bind
+        (&getNode, boost::cref (g), boost::cref (qFree)), .1);
+
+    // Plan from the free state to the last grasp.
+    Problem problem (g.robot);
+    problem.pathValidation (GraphPathValidation::create <
+        hpp::core::DiscretizedCollisionChecking > (g.robot, .05));
+    problem.constraintGraph (g.graph);
+    ConfigurationPtr_t qInit (new Configuration_t (qFree)),
+                       qGoal (new Configuration_t (qFree));
+    const graph::Edges_t toGoal =
+      g.graph->getEdges (g.free, g.grasps.back ());
+    if (toGoal.empty () || !toGoal [0]->applyConstraints (qFree, *qGoal)) {
+      std::cerr << "Could not project onto " << g.grasps.back ()->name ()
+        << std::endl;
+      return;
+    }
+    problem.initConfig (qInit);
+    problem.addGoalConfig (qGoal);
+    RoadmapPtr_t roadmap = Roadmap::create (problem.distance (), g.robot);
+    roadmap->constraintGraph (g.graph);
+    roadmap->insertHistogram (g.histogram);
+    ManipulationPlannerPtr_t planner =
+      ManipulationPlanner::create (problem, roadmap);
+    planner->seed (0);
+    planner->startSolve ();
+    std::size_t iterations = 0;
+    start = now ();
+    double duration = 0;
+    while (duration < planningTime) {
+      planner->oneStep ();
+      ++iterations;
+      duration = now () - start;
+    }
+
+    std::cout << g.graph->nodeSelector ()->getNodes ().size () << ","
+      << edgesPerState << "," << g.nbEdges << ","
+      << g.levelSetEdge->id () + 1 << ","
+      << construction << "," << initialization << ","
+      << classification.nsPerOp << "," << classification.allocationsPerOp
+      << "," << (double) iterations / duration << ","
+      << roadmap->nodes ().size () << std::endl;
+  }
+} // namespace hpp_benchmark
+
+int main (int argc, char** argv)
+{
+  using namespace hpp_benchmark;
+  const std::size_t edgesPerState = argc > 1 ? std::atoi (argv [1]) : 4;
+  const double planningTime = argc > 2 ? std::atof (argv [2]) : 1;
+  std::vector < std::size_t > sizes;
+  for (int i = 3; i < argc; ++i) sizes.push_back (std::atoi (argv [i]));
+  if (sizes.empty ())
+    for (std::size_t n = 10; n <= 10000; n *= 10) sizes.push_back (n);
+
+  printCSVHeader (std::cout);
+  for (std::size_t i = 0; i < sizes.size (); ++i) {
+    if (sizes [i] == 0) {
+      std::cerr << "The number of grasp states must be positive." << std::endl;
+      return 1;
+    }
+    measure (sizes [i], edgesPerState, planningTime);
+  }
+  return 0;
+}
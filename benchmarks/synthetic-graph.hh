@@ -0,0 +1,194 @@
+// Copyright (c) 2015, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_BENCHMARKS_SYNTHETIC_GRAPH_HH
+# define HPP_MANIPULATION_BENCHMARKS_SYNTHETIC_GRAPH_HH
+
+# include <sstream>
+# include <boost/assign/list_of.hpp>
+
+# include <hpp/util/pointer.hh>
+
+# include <hpp/core/steering-method-straight.hh>
+# include <hpp/core/numerical-constraint.hh>
+# include <hpp/core/comparison-type.hh>
+# include <hpp/core/config-projector.hh>
+
+# include <hpp/constraints/position.hh>
+
+# include "hpp/manipulation/device.hh"
+# include "hpp/manipulation/graph/graph.hh"
+# include "hpp/manipulation/graph/node-selector.hh"
+# include "hpp/manipulation/graph/node.hh"
+# include "hpp/manipulation/graph/edge.hh"
+# include "hpp/manipulation/graph/statistics.hh"
+
+# include "toy-robot.hh"
+
+namespace hpp_benchmark {
+  namespace graph = hpp::manipulation::graph;
+  using hpp::manipulation::DevicePtr_t;
+  using hpp::manipulation::value_type;
+
+  /// Constraint graph of the planar arm of hpp_test::addArm.
+  ///
+  /// The graph has one state per grasp, in which the y coordinate of the
+  /// tip of the arm has a fixed value, and a state free, which contains
+  /// the other configurations. The grasp states are created first, so that
+  /// the free state is the last one tried by graph::Graph::getNode. Each
+  /// grasp state is linked to and from the free state. The free state also
+  /// has a loop, a graph::WaypointEdge and a graph::LevelSetEdge toward the
+  /// first grasp. The leaves of the level set are the values of the x
+  /// coordinate of the tip.
+  ///
+  /// Optionally, each grasp state is linked to the next grasp states by
+  /// edges whose type cycles through graph::Edge, graph::WaypointEdge and
+  /// graph::LevelSetEdge.
+  struct SyntheticGraph {
+    DevicePtr_t robot;
+    graph::GraphPtr_t graph;
+    graph::NodePtr_t free;
+    graph::Nodes_t grasps;
+    /// Edge from the free state to the first grasp.
+    graph::EdgePtr_t edge;
+    /// Edge from the free state to the first grasp through a waypoint.
+    graph::WaypointEdgePtr_t waypointEdge;
+    /// Edge from the free state to a leaf of the first grasp.
+    /// It is the last created component.
+    graph::LevelSetEdgePtr_t levelSetEdge;
+    /// Histogram of the leaves used by the level set edges.
+    graph::LeafHistogramPtr_t histogram;
+    /// Number of edges between the states, not counting the inner edges
+    /// of the waypoint edges.
+    std::size_t nbEdges;
+  };
+
+  /// Constraint on the position of the tip of the arm.
+  /// \param mask the constrained coordinates.
+  inline hpp::core::NumericalConstraintPtr_t tipConstraint
+  (const DevicePtr_t& robot, const value_type& x, const value_type& y,
+   const std::vector <bool>& mask,
+   const hpp::core::ComparisonTypePtr_t& comparison =
+   hpp::core::EqualToZero::create ())
+  {
+    hpp::constraints::matrix3_t R; R.setIdentity ();
+    const hpp::constraints::vector3_t origin (0, FOREARM_LENGTH, 0),
+          target (x, y, 0);
+    return hpp::core::NumericalConstraint::create
+      (hpp::constraints::Position::create (robot,
+          robot->getJointByName ("FOREARM"), origin, target, R, mask),
+       comparison);
+  }
+
+  /// y coordinate of the tip of the arm in the grasp states.
+  inline value_type graspHeight (const std::size_t& i,
+      const std::size_t& nbGrasps)
+  {
+    return -(ARM_LENGTH + FOREARM_LENGTH) * .9 +
+      (ARM_LENGTH + FOREARM_LENGTH) * 1.8 * (value_type) (i + 1) /
+      (value_type) (nbGrasps + 1);
+  }
+
+  /// Create an edge of a given type and count it.
+  /// \param type 0 for graph::Edge, 1 for graph::WaypointEdge, 2 for
+  ///        graph::LevelSetEdge.
+  inline graph::EdgePtr_t link (SyntheticGraph& g, const std::string& name,
+      const graph::NodePtr_t& from, const graph::NodePtr_t& to,
+      const std::size_t& type)
+  {
+    ++g.nbEdges;
+    switch (type) {
+      case 1: {
+        graph::WaypointEdgePtr_t e = HPP_DYNAMIC_PTR_CAST
+          (graph::WaypointEdge, from->linkTo (name, to, 1, false,
+                                              graph::WaypointEdge::create));
+        e->createWaypoint (0, name);
+        return e;
+      }
+      case 2: {
+        graph::LevelSetEdgePtr_t e = HPP_DYNAMIC_PTR_CAST
+          (graph::LevelSetEdge, from->linkTo (name, to, 1, false,
+                                              graph::LevelSetEdge::create));
+        e->histogram (g.histogram);
+        return e;
+      }
+      default:
+        return from->linkTo (name, to);
+    }
+  }
+
+  /// Create the robot and the constraint graph.
+  /// \param nbGrasps number of grasp states,
+  /// \param edgesPerState number of edges from each grasp state to the
+  ///        next grasp states.
+  inline SyntheticGraph createGraph (const std::size_t& nbGrasps,
+      const std::size_t& edgesPerState = 0)
+  {
+    using boost::assign::list_of;
+    SyntheticGraph g;
+    g.nbEdges = 0;
+    g.robot = hpp::manipulation::Device::create ("toy-arm");
+    hpp_test::addArm (g.robot);
+    g.graph = graph::Graph::create ("synthetic", g.robot,
+        hpp::core::SteeringMethodStraight::create (g.robot));
+    g.graph->maxIterations (20);
+    g.graph->errorThreshold (1e-4);
+    graph::NodeSelectorPtr_t ns = g.graph->createNodeSelector ("selector");
+
+    // The leaves are the values of the x coordinate of the tip.
+    graph::Foliation f;
+    f.condition (hpp::core::ConfigProjector::create (g.robot, "free",
+          1e-4, 20));
+    hpp::core::ConfigProjectorPtr_t param =
+      hpp::core::ConfigProjector::create (g.robot, "tip-x", 1e-4, 20);
+    param->add (tipConstraint (g.robot, 0, 0, list_of (true)(false)(false),
+          hpp::core::Equality::create ()));
+    f.parametrizer (param);
+    g.histogram = graph::LeafHistogram::create (f);
+
+    for (std::size_t i = 0; i < nbGrasps; ++i) {
+      std::ostringstream name; name << "grasp_" << i;
+      graph::NodePtr_t grasp = ns->createNode (name.str ());
+      grasp->addNumericalConstraint (tipConstraint (g.robot, 0,
+            graspHeight (i, nbGrasps), list_of (false)(true)(false)));
+      g.grasps.push_back (grasp);
+    }
+    g.free = ns->createNode ("free");
+
+    link (g, "loop", g.free, g.free, 0);
+    for (std::size_t i = 0; i < nbGrasps; ++i) {
+      const std::string name = g.grasps [i]->name ();
+      graph::EdgePtr_t e = link (g, "free-" + name, g.free, g.grasps [i], 0);
+      if (i == 0) g.edge = e;
+      link (g, name + "-free", g.grasps [i], g.free, 0);
+      for (std::size_t k = 1; k <= edgesPerState; ++k) {
+        const graph::NodePtr_t& to = g.grasps [(i + k) % nbGrasps];
+        std::ostringstream edgeName;
+        edgeName << name << "-" << to->name () << "_" << k;
+        link (g, edgeName.str (), g.grasps [i], to, k % 3);
+      }
+    }
+    if (nbGrasps == 0) return g;
+
+    g.waypointEdge = HPP_DYNAMIC_PTR_CAST (graph::WaypointEdge, link
+        (g, "free-grasp_0-waypoint", g.free, g.grasps [0], 1));
+    g.levelSetEdge = HPP_DYNAMIC_PTR_CAST (graph::LevelSetEdge, link
+        (g, "free-grasp_0-levelset", g.free, g.grasps [0], 2));
+    return g;
+  }
+} // namespace hpp_benchmark
+
+#endif // HPP_MANIPULATION_BENCHMARKS_SYNTHETIC_GRAPH_HH
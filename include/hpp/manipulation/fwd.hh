@@ -51,6 +51,10 @@ namespace hpp {
     typedef Problem* ProblemPtr_t;
     HPP_PREDEF_CLASS (Roadmap);
     typedef boost::shared_ptr <Roadmap> RoadmapPtr_t;
+    HPP_PREDEF_CLASS (RoadmapNode);
+    typedef RoadmapNode* RoadmapNodePtr_t;
+    HPP_PREDEF_CLASS (RoadmapNodeArena);
+    typedef boost::shared_ptr < RoadmapNodeArena > RoadmapNodeArenaPtr_t;
     typedef constraints::RelativeOrientation RelativeOrientation;
     typedef constraints::RelativePosition RelativePosition;
     typedef constraints::RelativeOrientationPtr_t RelativeOrientationPtr_t;
@@ -72,6 +76,11 @@ namespace hpp {
     HPP_PREDEF_CLASS (GraphSteeringMethod);
     typedef boost::shared_ptr < GraphSteeringMethod > GraphSteeringMethodPtr_t;
     typedef core::PathProjectorPtr_t PathProjectorPtr_t;
+    HPP_PREDEF_CLASS (SeededConfigurationShooter);
+    typedef boost::shared_ptr < SeededConfigurationShooter >
+      SeededConfigurationShooterPtr_t;
+    HPP_PREDEF_CLASS (ThreadPool);
+    typedef boost::shared_ptr < ThreadPool > ThreadPoolPtr_t;
 
     typedef std::vector <model::DevicePtr_t> Devices_t;
     typedef std::vector <ObjectPtr_t> Objects_t;
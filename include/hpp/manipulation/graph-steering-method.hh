@@ -66,6 +66,15 @@ namespace hpp {
 
         const core::WeighedDistancePtr_t& distance () const;
 
+        /// Compute a path between two configurations whose states are
+        /// already known.
+        /// \param q1, q2 the configurations,
+        /// \param n1, n2 the states of q1 and q2.
+        /// \return a path built by one of the edges from n1 to n2, or a NULL
+        ///         pointer if no such edge exists or all of them failed.
+        PathPtr_t compute (ConfigurationIn_t q1, const graph::NodePtr_t& n1,
+            ConfigurationIn_t q2, const graph::NodePtr_t& n2) const;
+
       protected:
         /// Constructor
         GraphSteeringMethod (const model::DevicePtr_t& robot);
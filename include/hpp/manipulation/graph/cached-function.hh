@@ -0,0 +1,93 @@
+// Copyright (c) 2015, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_GRAPH_CACHED_FUNCTION_HH
+# define HPP_MANIPULATION_GRAPH_CACHED_FUNCTION_HH
+
+# include <hpp/constraints/differentiable-function.hh>
+
+# include "hpp/manipulation/config.hh"
+# include "hpp/manipulation/fwd.hh"
+# include "hpp/manipulation/graph/fwd.hh"
+# include "hpp/manipulation/graph/per-thread.hh"
+
+namespace hpp {
+  namespace manipulation {
+    namespace graph {
+      /// \addtogroup constraint_graph
+      /// \{
+
+      /// Differentiable function storing the value and the Jacobian of
+      /// another function at the last configuration they were computed at.
+      ///
+      /// When the same function is inserted in several ConfigProjector, as
+      /// the grasp of a state and of all its edges, evaluating all of them
+      /// at one configuration computes the function only once.
+      /// The values are stored per thread, in a PerThread sized at
+      /// creation for the thread slots of the graph.
+      /// \sa Graph::shareConstraintEvaluation
+      class HPP_MANIPULATION_DLLAPI CachedFunction :
+        public constraints::DifferentiableFunction
+      {
+        public:
+          /// Create an instance caching the results of function.
+          /// \param nbSlots number of thread slots using the instance.
+          static CachedFunctionPtr_t create
+            (const DifferentiableFunctionPtr_t& function,
+             const std::size_t& nbSlots);
+
+          /// Create the storage of the slots lower than nbSlots and forbid
+          /// it to grow afterwards.
+          /// \sa PerThread::fix
+          void fixSlots (const std::size_t& nbSlots) const;
+
+          /// Get the function whose results are cached.
+          const DifferentiableFunctionPtr_t& function () const
+          {
+            return function_;
+          }
+
+        protected:
+          /// Constructor
+          CachedFunction (const DifferentiableFunctionPtr_t& function,
+              const std::size_t& nbSlots);
+
+          virtual void impl_compute (constraints::vectorOut_t result,
+              ConfigurationIn_t argument) const;
+
+          virtual void impl_jacobian (constraints::matrixOut_t jacobian,
+              ConfigurationIn_t argument) const;
+
+        private:
+          struct Results {
+            Configuration_t valueArgument, jacobianArgument;
+            constraints::vector_t value;
+            constraints::matrix_t jacobian;
+            bool hasValue, hasJacobian;
+
+            Results () : hasValue (false), hasJacobian (false) {}
+          };
+
+          DifferentiableFunctionPtr_t function_;
+          PerThread < Results > results_;
+      }; // class CachedFunction
+
+      /// \}
+    } // namespace graph
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_GRAPH_CACHED_FUNCTION_HH
@@ -23,35 +23,13 @@
 
 #include "hpp/manipulation/config.hh"
 #include "hpp/manipulation/fwd.hh"
+#include "hpp/manipulation/random.hh"
 #include "hpp/manipulation/graph/graph.hh"
+#include "hpp/manipulation/graph/per-thread.hh"
 
 namespace hpp {
   namespace manipulation {
     namespace graph {
-      /// Cache mechanism that enable const-correctness of member functions.
-      template <typename C>
-        class HPP_MANIPULATION_LOCAL Cache
-      {
-        public:
-          void set (const C& c)
-          {
-            c_ = c;
-          }
-
-          operator bool() const
-          {
-            return (bool)c_;
-          }
-
-          const C& get () const
-          {
-            return c_;
-          }
-
-        private:
-          C c_;
-      };
-
       /// \addtogroup constraint_graph
       /// \{
 
@@ -74,6 +52,29 @@ namespace hpp {
 
           virtual bool applyConstraints (ConfigurationIn_t qoffset, ConfigurationOut_t q) const;
 
+          /// Same as applyConstraints (core::NodePtr_t, ConfigurationOut_t),
+          /// with random choices drawn from rng.
+          virtual bool applyConstraints (core::NodePtr_t nnear, ConfigurationOut_t q,
+              RandomGenerator_t& rng) const;
+
+          /// Draw the random choices of applyConstraints that depend on the
+          /// roadmap.
+          ///
+          /// Together with applyConstraints (ConfigurationIn_t,
+          /// const ConfigurationPtr_t&, ConfigurationOut_t), this splits
+          /// applyConstraints (core::NodePtr_t, ConfigurationOut_t,
+          /// RandomGenerator_t&) so that only this function reads the
+          /// roadmap.
+          /// \return the configuration defining the leaf to project onto,
+          ///         for a LevelSetEdge. NULL for the other edges.
+          virtual ConfigurationPtr_t sampleTarget (const core::NodePtr_t& nnear,
+              RandomGenerator_t& rng) const;
+
+          /// Apply the constraints with the choices of sampleTarget.
+          /// This does not read the roadmap.
+          virtual bool applyConstraints (ConfigurationIn_t qoffset,
+              const ConfigurationPtr_t& target, ConfigurationOut_t q) const;
+
           virtual bool build (core::PathPtr_t& path, ConfigurationIn_t q1, ConfigurationIn_t q2, const core::WeighedDistance& d) const;
 
           /// Get the destination
@@ -95,10 +96,21 @@ namespace hpp {
             return isInNodeFrom_;
           }
 	  /// Get steering method associated to the edge.
-	  const core::SteeringMethodPtr_t& steeringMethod () const
-	  {
-	    return steeringMethod_;
-	  }
+          /// \return the instance of the calling thread, whose constraints
+          ///         are the path constraints of the edge.
+	  core::SteeringMethodPtr_t steeringMethod () const;
+
+          /// Build configConstraint, pathConstraint and the steering method
+          /// using the path constraints for a thread.
+          virtual void buildConstraints (const std::size_t& slot) const;
+
+          /// Create the constraints of a thread and remove the constraint
+          /// sets it built before.
+          virtual void instantiateConstraints (const std::size_t& slot,
+              const core::DevicePtr_t& robot) const;
+
+          virtual void fixSlots (const std::size_t& nbSlots) const;
+
           /// Print the object in a stream.
           virtual std::ostream& dotPrint (std::ostream& os, dot::DrawingAttributes da = dot::DrawingAttributes ()) const;
 
@@ -113,25 +125,47 @@ namespace hpp {
 
           /// Constraint to project onto the same leaf as config.
           /// \return The initialized projector.
+          /// \note Each thread builds and uses its own instance.
           ConstraintSetPtr_t configConstraint() const;
 
           /// Constraint to project a path.
           /// \return The initialized constraint.
+          /// \note Each thread builds and uses its own instance.
           ConstraintSetPtr_t pathConstraint() const;
 
-          virtual ConstraintSetPtr_t buildConfigConstraint() const;
+          /// Build the constraint of configConstraint for a thread, with
+          /// the constraints and the robot of the thread.
+          virtual ConstraintSetPtr_t buildConfigConstraint
+            (const std::size_t& slot) const;
+
+          /// Build the constraint of pathConstraint for a thread.
+          virtual ConstraintSetPtr_t buildPathConstraint
+            (const std::size_t& slot) const;
 
-          virtual ConstraintSetPtr_t buildPathConstraint() const;
+          /// Get the steering method given at construction, without
+          /// constraints.
+          const core::SteeringMethodPtr_t& unconstrainedSteeringMethod () const
+          {
+            return steeringMethod_;
+          }
 
           /// Print the object in a stream.
           virtual std::ostream& print (std::ostream& os) const;
 
         private:
           typedef Cache < ConstraintSetPtr_t > Constraint_t;
+          typedef Cache < core::SteeringMethodPtr_t > SteeringMethod_t;
+
+          /// Build the path constraints and the steering method of a thread.
+          void setPathConstraint (const std::size_t& slot) const;
 
           /// See pathConstraint member function.
           Constraint_t* pathConstraints_;
 
+          /// Copies of steeringMethod_ using the path constraints of each
+          /// thread.
+          SteeringMethod_t* steeringMethods_;
+
           /// Constraint ensuring that a q_proj will be in to_ and in the
           /// same leaf of to_ as the configuration used for initialization.
           Constraint_t* configConstraints_;
@@ -191,6 +225,11 @@ namespace hpp {
 
           virtual bool applyConstraints (ConfigurationIn_t qoffset, ConfigurationOut_t q) const;
 
+          /// Build the constraints of Edge and the buffers of a thread.
+          virtual void buildConstraints (const std::size_t& slot) const;
+
+          virtual void fixSlots (const std::size_t& nbSlots) const;
+
           /// Return the inner waypoint.
           /// \param EdgeType is either Edge or WaypointEdge
           template <class EdgeType>
@@ -226,8 +265,16 @@ namespace hpp {
         private:
           typedef std::pair < EdgePtr_t, NodePtr_t > Waypoint;
 
+          /// Configurations used by build and applyConstraints.
+          struct Buffers {
+            Configuration_t config, result;
+
+            Buffers (const size_type& size = 0) : config (size), result (size)
+            {}
+          };
+
           Waypoint waypoint_;
-          mutable Configuration_t config_, result_;
+          PerThread < Buffers > buffers_;
       }; // class WaypointEdge
 
       /// Edge that find intersection of level set.
@@ -247,10 +294,36 @@ namespace hpp {
 
           virtual bool applyConstraints (core::NodePtr_t n_offset, ConfigurationOut_t q) const;
 
+          /// The leaf is sampled with rng.
+          virtual bool applyConstraints (core::NodePtr_t n_offset, ConfigurationOut_t q,
+              RandomGenerator_t& rng) const;
+
+          /// Sample, with rng, a leaf out of the connected component of
+          /// n_offset.
+          virtual ConfigurationPtr_t sampleTarget (const core::NodePtr_t& n_offset,
+              RandomGenerator_t& rng) const;
+
+          /// Project q onto the leaf of target.
+          virtual bool applyConstraints (ConfigurationIn_t qoffset,
+              const ConfigurationPtr_t& target, ConfigurationOut_t q) const;
+
           void histogram (LeafHistogramPtr_t hist);
 
           LeafHistogramPtr_t histogram () const;
 
+          /// Build the constraints of Edge and the extra constraints
+          /// projecting onto the level set, if the histogram is set.
+          virtual void buildConstraints (const std::size_t& slot) const;
+
+          /// Create the constraints of Edge and, if the histogram is set,
+          /// the parametrizer of the foliation for a thread.
+          /// \throw std::logic_error if the foliation has no factory of
+          ///        parametrizer and robot is not NULL.
+          virtual void instantiateConstraints (const std::size_t& slot,
+              const core::DevicePtr_t& robot) const;
+
+          virtual void fixSlots (const std::size_t& nbSlots) const;
+
           /// Print the object in a stream.
           virtual std::ostream& dotPrint (std::ostream& os, dot::DrawingAttributes da = dot::DrawingAttributes ()) const;
 
@@ -274,7 +347,23 @@ namespace hpp {
           /// See pathConstraint member function.
           Constraint_t* extraConstraints_;
           ConstraintSetPtr_t extraConfigConstraint () const;
-          void buildExtraConfigConstraint () const;
+          ConstraintSetPtr_t buildExtraConfigConstraint
+            (const std::size_t& slot) const;
+
+          /// Parametrizer of the foliation of a thread.
+          ConfigProjectorPtr_t parametrizer (const std::size_t& slot) const;
+          /// Copies of the parametrizer for the threads using a copy of the
+          /// robot. NULL for the threads using Graph::robot ().
+          PerThread < ConfigProjectorPtr_t > parametrizers_;
+
+          /// Numerical constraints of the parametrizer in the projector of
+          /// extraConfigConstraint, as returned by Graph::sharedConstraint.
+          /// Their right hand side defines the leaf.
+          PerThread < NumericalConstraints_t > extraNumericalConstraints_;
+
+          /// Project q onto the leaf of levelsetTarget.
+          bool projectOnLeaf (ConfigurationIn_t q_offset,
+              ConfigurationIn_t levelsetTarget, ConfigurationOut_t q) const;
 
           /// This histogram will be used to find a good level set.
           LeafHistogramPtr_t hist_;
@@ -31,6 +31,8 @@ namespace hpp {
       HPP_PREDEF_CLASS (LevelSetEdge);
       HPP_PREDEF_CLASS (NodeSelector);
       HPP_PREDEF_CLASS (GraphComponent);
+      HPP_PREDEF_CLASS (NodeCache);
+      HPP_PREDEF_CLASS (CachedFunction);
       typedef boost::shared_ptr < Graph > GraphPtr_t;
       typedef boost::shared_ptr < Node > NodePtr_t;
       typedef boost::shared_ptr < Edge > EdgePtr_t;
@@ -38,6 +40,8 @@ namespace hpp {
       typedef boost::shared_ptr < LevelSetEdge > LevelSetEdgePtr_t;
       typedef boost::shared_ptr < NodeSelector > NodeSelectorPtr_t;
       typedef boost::shared_ptr < GraphComponent > GraphComponentPtr_t;
+      typedef boost::shared_ptr < NodeCache > NodeCachePtr_t;
+      typedef boost::shared_ptr < CachedFunction > CachedFunctionPtr_t;
       typedef std::vector < NodePtr_t > Nodes_t;
       typedef std::vector < EdgePtr_t > Edges_t;
       typedef ::hpp::statistics::DiscreteDistribution< EdgePtr_t >::Weight_t Weight_t;
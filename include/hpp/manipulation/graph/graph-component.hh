@@ -19,6 +19,7 @@
 
 # include <string>
 # include <ostream>
+# include <boost/function.hpp>
 # include <hpp/util/exception.hh>
 
 # include "hpp/manipulation/config.hh"
@@ -26,6 +27,7 @@
 # include "hpp/manipulation/fwd.hh"
 # include "hpp/manipulation/graph/fwd.hh"
 # include "hpp/manipulation/graph/dot.hh"
+# include "hpp/manipulation/graph/per-thread.hh"
 
 namespace hpp {
   namespace manipulation {
@@ -41,6 +43,10 @@ namespace hpp {
       class HPP_MANIPULATION_DLLAPI GraphComponent
       {
         public:
+          /// Function creating a numerical constraint for a robot.
+          typedef boost::function < NumericalConstraintPtr_t
+            (const core::DevicePtr_t&) > NumericalConstraintFactory_t;
+
           /// Get the component name.
           const std::string& name() const;
 
@@ -61,6 +67,19 @@ namespace hpp {
               const NumericalConstraintPtr_t& numConstraint,
               const SizeIntervals_t& passiveDofs = SizeIntervals_t ());
 
+          /// Add a numerical constraint created by a factory.
+          ///
+          /// The constraint is created for Graph::robot () and, by
+          /// Graph::initialize, for the copy of the robot of each thread,
+          /// so that the threads do not evaluate the same function.
+          /// Constraints added without factory can only be used by the
+          /// thread calling Graph::initialize.
+          /// \param passiveDofs see ConfigProjector::addNumericalConstraint
+          //         for more information.
+          virtual void addNumericalConstraint (
+              const NumericalConstraintFactory_t& factory,
+              const SizeIntervals_t& passiveDofs = SizeIntervals_t ());
+
           /// Add core::DifferentiableFunction to the component.
           virtual void addNumericalConstraint
             (const DifferentiableFunctionPtr_t& function, const ComparisonTypePtr_t& ineq)
@@ -74,22 +93,74 @@ namespace hpp {
           /// \return true is at least one NumericalConstraintPtr_t was inserted.
           bool insertNumericalConstraints (ConfigProjectorPtr_t& proj) const;
 
+          /// Insert the numerical constraints of a thread in a
+          /// ConfigProjector.
+          /// \param slot the slot of the thread (see ThreadPool::threadSlot).
+          /// \sa numericalConstraints (const std::size_t&) const
+          bool insertNumericalConstraints (ConfigProjectorPtr_t& proj,
+              const std::size_t& slot) const;
+
           /// Insert the LockedJoint constraints in a ConstraintSet
           /// \return true is at least one LockedJointPtr_t was inserted.
           bool insertLockedJoints (ConfigProjectorPtr_t& cs) const;
 
+          /// Insert the LockedJoint constraints of a thread in a
+          /// ConfigProjector.
+          bool insertLockedJoints (ConfigProjectorPtr_t& cs,
+              const std::size_t& slot) const;
+
           /// Get a reference to the NumericalConstraints_t
           const NumericalConstraints_t& numericalConstraints() const;
 
+          /// Get the numerical constraints evaluated by a thread.
+          /// \return the instances created for the copy of the robot of the
+          ///         thread by instantiateConstraints, numericalConstraints ()
+          ///         if the thread uses Graph::robot ().
+          const NumericalConstraints_t& numericalConstraints
+            (const std::size_t& slot) const;
+
           /// Get a reference to the NumericalConstraints_t
           const std::vector <SizeIntervals_t>& passiveDofs() const;
 
           /// Get a reference to the LockedJoints_t
           const LockedJoints_t& lockedJoints () const;
 
+          /// Get the LockedJoint constraints used by a thread.
+          /// \sa numericalConstraints (const std::size_t&) const
+          const LockedJoints_t& lockedJoints (const std::size_t& slot) const;
+
           /// Set the parent graph.
           void parentGraph(const GraphWkPtr_t& parent);
 
+          /// Declare that the constraints of the component changed.
+          /// Called by addNumericalConstraint and addLockedJointConstraint.
+          virtual void invalidate ()
+          {}
+
+          /// Build the constraint sets of the component used by a thread.
+          /// Constraint sets that are already built are kept.
+          /// \param slot the slot of the thread (see ThreadPool::threadSlot).
+          /// \sa Graph::initialize
+          virtual void buildConstraints (const std::size_t& /* slot */) const
+          {}
+
+          /// Create the instances of the constraints used by a thread.
+          /// Called by Graph::initialize, for all the threads, before
+          /// buildConstraints.
+          /// \param robot the copy of the robot of the thread, or NULL if
+          ///        the thread uses Graph::robot ().
+          /// \throw std::logic_error if a numerical constraint was added
+          ///        without factory and robot is not NULL.
+          virtual void instantiateConstraints (const std::size_t& slot,
+              const core::DevicePtr_t& robot) const;
+
+          /// Create the per thread storage of the component for the slots
+          /// lower than nbSlots. Afterwards, a thread with another slot
+          /// using the component gets a std::logic_error.
+          /// Called by Graph::initialize, before instantiateConstraints.
+          /// \sa PerThread::fix
+          virtual void fixSlots (const std::size_t& nbSlots) const;
+
           /// Print the component in DOT language.
           virtual std::ostream& dotPrint (std::ostream& os, dot::DrawingAttributes da = dot::DrawingAttributes ()) const;
 
@@ -104,6 +175,9 @@ namespace hpp {
           NumericalConstraints_t numericalConstraints_;
           /// Stores the passive dofs for each numerical constraints.
           std::vector <SizeIntervals_t> passiveDofs_;
+          /// Factories of the numerical constraints. Empty for the
+          /// constraints added without factory.
+          std::vector <NumericalConstraintFactory_t> factories_;
           /// List of LockedJoint constraints
           LockedJoints_t lockedJoints_;
           /// A weak pointer to the parent graph.
@@ -116,11 +190,32 @@ namespace hpp {
           /// Populate DrawingAttributes tooltip
           virtual void populateTooltip (dot::Tooltip& tp) const;
 
+          /// \throw std::logic_error if the parent graph is initialized.
+          void checkNotFrozen () const;
+
+          /// Create a constraint for a robot with its factory.
+          /// \throw std::logic_error if factory is empty.
+          NumericalConstraintPtr_t instantiate
+            (const NumericalConstraintFactory_t& factory,
+             const NumericalConstraintPtr_t& constraint,
+             const core::DevicePtr_t& robot) const;
+
         private:
+          /// Constraints of a thread using a copy of the robot.
+          struct Instances {
+            bool set;
+            NumericalConstraints_t numericalConstraints;
+            LockedJoints_t lockedJoints;
+
+            Instances () : set (false) {}
+          };
+
           /// Keep track of the created components in order to retrieve them
           /// easily.
           static std::vector < GraphComponentWkPtr_t > components;
 
+          PerThread <Instances> instances_;
+
           /// Name of the component.
           std::string name_;
           /// Weak pointer to itself.
@@ -17,8 +17,14 @@
 #ifndef HPP_MANIPULATION_GRAPH_GRAPH_HH
 # define HPP_MANIPULATION_GRAPH_GRAPH_HH
 
+# include <map>
+# include <vector>
+# include <boost/function.hpp>
+# include <boost/thread/mutex.hpp>
+
 # include "hpp/manipulation/config.hh"
 # include "hpp/manipulation/fwd.hh"
+# include "hpp/manipulation/random.hh"
 # include "hpp/manipulation/graph/fwd.hh"
 # include "hpp/manipulation/graph/graph-component.hh"
 
@@ -52,15 +58,47 @@ namespace hpp {
           /// Create and insert a NodeSelector inside the graph.
           NodeSelectorPtr_t createNodeSelector (const std::string& name);
 
+          /// Get the NodeSelector of the graph.
+          const NodeSelectorPtr_t& nodeSelector () const
+          {
+            return nodeSelector_;
+          }
+
           /// Returns the states of a configuration.
+          /// If a NodeCache is set, it is used before classifying the
+          /// configuration.
           NodePtr_t getNode (ConfigurationIn_t config) const;
 
+          /// Returns the state of a roadmap node.
+          /// The state is computed only if it is not cached in the node yet.
+          NodePtr_t getNode (const RoadmapNodePtr_t& node) const;
+
           /// Get possible edges between two nodes.
           Edges_t getEdges (const NodePtr_t& from, const NodePtr_t& to) const;
 
+          /// Cost of a transition, non negative. Edges of infinite cost are
+          /// not used.
+          typedef boost::function < value_type (const EdgePtr_t&) >
+            EdgeCost_t;
+          typedef std::map < NodePtr_t, value_type > StateCosts_t;
+
+          /// Cost of the cheapest sequence of transitions from each state
+          /// to a set of target states (Dijkstra algorithm).
+          /// Edges of weight 0 are not used.
+          /// \param targets the target states,
+          /// \param cost the cost of the edges.
+          /// \return the cost of the states from which a target state can
+          ///         be reached. The other states are not in the map.
+          StateCosts_t costsTo (const Nodes_t& targets,
+              const EdgeCost_t& cost) const;
+
           /// Select randomly outgoing edge of the given node.
           EdgePtr_t chooseEdge(const NodePtr_t& node) const;
 
+          /// Same as chooseEdge (const NodePtr_t&), drawing from rng.
+          EdgePtr_t chooseEdge(const NodePtr_t& node,
+              RandomGenerator_t& rng) const;
+
           /// Constraint to project onto the Node.
           /// \param the Node_t on which to project.
           /// \return The initialized projector.
@@ -103,12 +141,121 @@ namespace hpp {
           /// Get the robot.
           const DevicePtr_t& robot () const;
 
+          /// Get the robot used by the constraints of a thread.
+          /// \param slot the slot of the thread (see ThreadPool::threadSlot).
+          /// \return the copy of the robot created by initialize for the
+          ///         thread, robot () if there is none.
+          core::DevicePtr_t robot (const std::size_t& slot) const;
+
 	  /// Get the steering Method
 	  const core::SteeringMethodPtr_t& steeringMethod () const;
 
+          /// \name Cache of the states of configurations
+          /// \{
+
+          /// Set the cache used by getNode (ConfigurationIn_t).
+          /// \param cache the cache, or a NULL pointer to disable caching.
+          void nodeCache (const NodeCachePtr_t& cache);
+
+          /// Get the cache used by getNode (ConfigurationIn_t).
+          const NodeCachePtr_t& nodeCache () const;
+
+          /// Reset the decision tree of the NodeSelector and clear the
+          /// NodeCache, if any.
+          /// Called when the constraints of the graph, of the states or the
+          /// parameters of the projectors change.
+          virtual void invalidate ();
+          /// \}
+
+          /// \name Shared evaluation of the numerical constraints
+          /// \{
+
+          /// Enable or disable the sharing of the numerical constraints
+          /// between the projectors of the components.
+          ///
+          /// When enabled, the numerical constraints of the projectors
+          /// built by the components evaluate one CachedFunction per
+          /// function. A constraint used by several states and edges is
+          /// then evaluated once per configuration and per thread.
+          /// Disabled by default.
+          /// \note Projectors built before the call are not modified. This
+          ///       must be set before the first planning query.
+          void shareConstraintEvaluation (const bool& share);
+
+          /// Whether the numerical constraints are shared.
+          bool shareConstraintEvaluation () const
+          {
+            return shareConstraintEvaluation_;
+          }
+
+          /// Get the instance of a numerical constraint to insert in a
+          /// projector.
+          /// \return nc if the sharing is disabled. Otherwise, a new
+          ///         constraint whose function is the CachedFunction of the
+          ///         function of nc, with the comparison type and the right
+          ///         hand side of nc. Each projector thus sets the right
+          ///         hand side of its own instance.
+          NumericalConstraintPtr_t sharedConstraint
+            (const NumericalConstraintPtr_t& nc) const;
+          /// \}
+
           /// Print the component in DOT language.
           virtual std::ostream& dotPrint (std::ostream& os, dot::DrawingAttributes da = dot::DrawingAttributes ()) const;
 
+          /// \name Initialization
+          /// \{
+
+          /// Build the constraint sets of every component and freeze the
+          /// graph.
+          ///
+          /// Constraint sets are otherwise built on first use, which makes
+          /// the first planning query slow. The components are built
+          /// concurrently. Since constraint sets are stored per thread, they
+          /// are built for the calling thread and for the given threads.
+          /// After this call, adding states, edges or constraints throws.
+          ///
+          /// Evaluating a constraint computes the forward kinematics of its
+          /// robot. So that the threads never evaluate the same robot, each
+          /// of the given threads gets a copy of the robot, on which its
+          /// constraints are created again by their factories (see
+          /// GraphComponent::addNumericalConstraint). The calling thread
+          /// uses robot (). Threads whose slot is not given must not use
+          /// the graph.
+          ///
+          /// Calling it again on an initialized graph builds the constraint
+          /// sets of the threads that were not initialized yet, each one on
+          /// a copy of the robot, and keeps the others. It must not be
+          /// called while other threads use the graph.
+          /// \param slots slots of the other threads using the graph (see
+          ///        ThreadPool::threadSlot and ThreadPool::slots),
+          /// \param nbThreads number of threads building the constraint
+          ///        sets. If 0, the number of cores is used.
+          /// \throw std::logic_error if slots is not empty and a constraint
+          ///        has no factory.
+          void initialize (const std::vector < std::size_t >& slots =
+              std::vector < std::size_t > (), const std::size_t& nbThreads = 0);
+
+          /// Slots of the threads for which initialize built the
+          /// constraints, including the calling thread.
+          const std::vector < std::size_t >& threadSlots () const
+          {
+            return slots_;
+          }
+
+          /// Whether initialize was called.
+          bool frozen () const
+          {
+            return frozen_;
+          }
+
+          /// Time spent by initialize to build each component, in seconds,
+          /// indexed by the id of the component.
+          const std::map < int, value_type >& initializationTimes () const
+          {
+            return initializationTimes_;
+          }
+          /// \}
+
         protected:
           /// Initialization of the object.
           void init (const GraphWkPtr_t& weak, DevicePtr_t robot);
@@ -116,7 +263,9 @@ namespace hpp {
           /// Constructor
 	  /// \param sm a steering method to create paths from edges
           Graph (const std::string& name, const core::SteeringMethodPtr_t& sm) :
-	    GraphComponent (name), steeringMethod_ (sm)
+	    GraphComponent (name), steeringMethod_ (sm), nodeCache_ (),
+            frozen_ (false), initializationTimes_ (),
+            shareConstraintEvaluation_ (false)
           {}
 
           /// Print the object in a stream.
@@ -133,6 +282,11 @@ namespace hpp {
           /// Keep a pointer to the composite robot.
           DevicePtr_t robot_;
 
+          /// Copies of the robot, indexed by thread slot. NULL for the
+          /// threads using robot_.
+          std::vector < core::DevicePtr_t > robots_;
+          std::vector < std::size_t > slots_;
+
           /// Weak pointer to itself.
           GraphWkPtr_t wkPtr_;
 
@@ -148,6 +302,18 @@ namespace hpp {
 	  core::SteeringMethodPtr_t steeringMethod_;
           value_type errorThreshold_;
           size_type maxIterations_;
+          /// Cache of getNode. NULL if disabled.
+          NodeCachePtr_t nodeCache_;
+          bool frozen_;
+          std::map < int, value_type > initializationTimes_;
+
+          bool shareConstraintEvaluation_;
+          /// Shared instances of the functions of the numerical
+          /// constraints.
+          typedef std::map < DifferentiableFunctionPtr_t,
+                  CachedFunctionPtr_t > SharedFunctions_t;
+          mutable SharedFunctions_t sharedFunctions_;
+          mutable boost::mutex sharedConstraintsMutex_;
       }; // Class Graph
 
       /// \}
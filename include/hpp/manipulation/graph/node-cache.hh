@@ -0,0 +1,156 @@
+// Copyright (c) 2015, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_GRAPH_NODE_CACHE_HH
+# define HPP_MANIPULATION_GRAPH_NODE_CACHE_HH
+
+# include <list>
+# include <vector>
+# include <boost/unordered_map.hpp>
+# include <boost/thread/mutex.hpp>
+
+# include "hpp/manipulation/config.hh"
+# include "hpp/manipulation/fwd.hh"
+# include "hpp/manipulation/graph/fwd.hh"
+
+namespace hpp {
+  namespace manipulation {
+    namespace graph {
+      /// \addtogroup constraint_graph
+      /// \{
+
+      /// Bounded cache of the states of configurations.
+      ///
+      /// Configurations are hashed by the cell of a grid containing them,
+      /// whose size is a multiple of the tolerance. A lookup searches the
+      /// cell of the configuration and, along the coordinates close to its
+      /// border, the neighbouring cells, for a cached configuration whose
+      /// coordinates are within the tolerance. The state of such a
+      /// configuration is returned only if it contains the looked up one
+      /// and no state before it in its NodeSelector does, as two close
+      /// configurations may be on both sides of the border of a state and
+      /// the states overlap. Such a check is cheap for the states with the
+      /// highest priority. With a tolerance of 0, only equal configurations
+      /// match.
+      /// When the cache is full, the least recently used entry is removed.
+      class HPP_MANIPULATION_DLLAPI NodeCache
+      {
+        public:
+          /// Create a cache.
+          /// \param capacity maximal number of entries,
+          /// \param tolerance maximal difference between the coordinates of
+          ///        two configurations considered equal.
+          static NodeCachePtr_t create (const std::size_t& capacity,
+              const value_type& tolerance = 0);
+
+          /// Get the state of a configuration.
+          /// \retval node the cached state, if any.
+          /// \return whether the configuration was found and is in the
+          ///         cached state.
+          bool get (ConfigurationIn_t config, NodePtr_t& node);
+
+          /// Insert the state of a configuration. It replaces the state
+          /// of an equal configuration only.
+          void insert (ConfigurationIn_t config, const NodePtr_t& node);
+
+          /// Remove all the entries. The counters are not reset.
+          void clear ();
+
+          /// Number of entries.
+          std::size_t size () const;
+
+          /// Maximal number of entries.
+          std::size_t capacity () const
+          {
+            return capacity_;
+          }
+
+          /// Tolerance used to compare configurations.
+          value_type tolerance () const
+          {
+            return tolerance_;
+          }
+
+          /// Number of successful calls to get.
+          std::size_t hits () const
+          {
+            return hits_;
+          }
+
+          /// Number of unsuccessful calls to get.
+          std::size_t misses () const
+          {
+            return misses_;
+          }
+
+          /// Reset the hit and miss counters.
+          void resetCounters ();
+
+        protected:
+          /// Constructor
+          NodeCache (const std::size_t& capacity, const value_type& tolerance);
+
+        private:
+          struct Entry {
+            Configuration_t config;
+            NodePtr_t node;
+            std::size_t hash;
+          };
+          typedef std::list < Entry > Entries_t;
+          typedef boost::unordered_multimap < std::size_t,
+                  Entries_t::iterator > Index_t;
+          typedef std::vector < long > Cell_t;
+
+          /// Cell of the grid containing a configuration.
+          Cell_t cell (ConfigurationIn_t config) const;
+
+          static std::size_t hash (const Cell_t& cell);
+
+          /// Hash of the cell of a configuration, or of the configuration
+          /// itself if the tolerance is 0.
+          std::size_t hash (ConfigurationIn_t config) const;
+
+          /// Find an entry among the ones of a hash. Must be called with
+          /// mutex_ locked.
+          /// \param exact whether the configuration of the entry must be
+          ///        equal to config, instead of within the tolerance.
+          Entries_t::iterator find (ConfigurationIn_t config,
+              const std::size_t& h, const bool& exact);
+
+          /// Find an entry within the tolerance, in the cell of a
+          /// configuration or in the neighbouring ones. Must be called with
+          /// mutex_ locked.
+          Entries_t::iterator find (ConfigurationIn_t config);
+
+          std::size_t capacity_;
+          value_type tolerance_;
+          /// Size of the cells of the grid. It is larger than the
+          /// tolerance so that most configurations are far from the border
+          /// of their cell on most coordinates.
+          value_type cellSize_;
+          /// Entries, the most recently used first.
+          Entries_t entries_;
+          Index_t index_;
+          std::size_t hits_, misses_;
+          mutable boost::mutex mutex_;
+      }; // class NodeCache
+
+      /// \}
+    } // namespace graph
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_GRAPH_NODE_CACHE_HH
@@ -17,6 +17,7 @@
 #ifndef HPP_MANIPULATION_GRAPH_NODE_SELECTOR_HH
 # define HPP_MANIPULATION_GRAPH_NODE_SELECTOR_HH
 
+
 #include "hpp/manipulation/config.hh"
 #include "hpp/manipulation/fwd.hh"
 #include "hpp/manipulation/graph/graph.hh"
@@ -36,12 +37,46 @@ namespace hpp {
           /// Create an empty node
           NodePtr_t createNode (const std::string& name);
 
+          /// Get the states, ordered by priority.
+          const Nodes_t& getNodes () const
+          {
+            return orderedStates_;
+          }
+
           /// Returns the state of a configuration.
+          ///
+          /// The result is the first state, in the order of creation, that
+          /// contains the configuration. Candidate states are selected by
+          /// a decision tree whose tests are the distinct constraints of
+          /// the states and of the graph, so that each of them is evaluated
+          /// at most once. The candidate is then checked as Node::contains
+          /// does, from the errors of the tests, and the following states
+          /// are checked likewise if it is rejected.
+          /// The decision tree is built by Graph::initialize, so that the
+          /// threads call getNode without locking. If the graph is not
+          /// initialized, it is built on the first call, which is then not
+          /// thread safe, and rebuilt after invalidate is called.
           NodePtr_t getNode(ConfigurationIn_t config) const;
 
+          /// Set the maximal number of vertices of the decision tree of
+          /// getNode. Beyond it, getNode checks the states following the
+          /// candidate of a leaf one by one. The default is 65536.
+          /// \throw std::invalid_argument if size is 0.
+          void classifierMaxSize (const std::size_t& size);
+
+          /// Get the maximal number of vertices of the decision tree.
+          const std::size_t& classifierMaxSize () const
+          {
+            return classifierMaxSize_;
+          }
+
           /// Select randomly an outgoing edge of the given node.
           virtual EdgePtr_t chooseEdge(const NodePtr_t& node) const;
 
+          /// Same as chooseEdge (const NodePtr_t&), drawing from rng.
+          virtual EdgePtr_t chooseEdge(const NodePtr_t& node,
+              RandomGenerator_t& rng) const;
+
           /// Should never be called.
           void addNumericalConstraint (
               const core::NumericalConstraintPtr_t& /* function */,
@@ -60,21 +95,50 @@ namespace hpp {
           /// Print the object in a stream.
           std::ostream& dotPrint (std::ostream& os, dot::DrawingAttributes da = dot::DrawingAttributes ()) const;
 
+          /// Reset the decision tree used by getNode and clear the NodeCache
+          /// of the parent Graph.
+          /// Called when a state is created or its constraints change.
+          virtual void invalidate ();
+
+          /// Build the decision tree used by getNode and its constraints for
+          /// a thread.
+          virtual void buildConstraints (const std::size_t& slot) const;
+
+          /// Build the decision tree used by getNode, if needed, and remove
+          /// its projectors built for a thread.
+          virtual void instantiateConstraints (const std::size_t& slot,
+              const core::DevicePtr_t& robot) const;
+
+          /// Build the decision tree used by getNode, if needed, and fix the
+          /// storage of its projectors.
+          virtual void fixSlots (const std::size_t& nbSlots) const;
+
         protected:
           /// Initialization of the object.
           void init (const NodeSelectorPtr_t& weak);
 
           /// Constructor
-          NodeSelector (const std::string& name) : GraphComponent (name)
+          NodeSelector (const std::string& name) : GraphComponent (name),
+            orderedStates_ (), classifier_ (), classifierMaxSize_ (1 << 16)
           {}
 
           /// Print the object in a stream.
           std::ostream& print (std::ostream& os) const;
 
         private:
+          struct Classifier;
+          typedef boost::shared_ptr <const Classifier> ClassifierPtr_t;
+
+          /// Get the decision tree, building it if necessary.
+          const ClassifierPtr_t& classifier () const;
+
           /// List of the states of one end-effector, ordered by priority.
           Nodes_t orderedStates_;
 
+          /// Decision tree used by getNode. NULL until it is built.
+          mutable ClassifierPtr_t classifier_;
+          std::size_t classifierMaxSize_;
+
           /// Weak pointer to itself.
           NodeSelectorPtr_t wkPtr_;
       }; // Class NodeSelector
@@ -90,37 +90,66 @@ namespace hpp {
 
           void updateWeight (const EdgePtr_t&edge, const Weight_t& w);
 
+          /// Select randomly an outgoing edge, with a probability
+          /// proportional to its weight.
+          /// Sampling uses an alias table (Walker's method), rebuilt by
+          /// linkTo and updateWeight, and takes constant time.
+          /// \return the edge, or a NULL pointer if the total weight is 0.
+          EdgePtr_t chooseEdge () const;
+
+          /// Same as chooseEdge (), drawing from rng.
+          EdgePtr_t chooseEdge (RandomGenerator_t& rng) const;
+
           /// Constraint to project onto this node.
           ConstraintSetPtr_t configConstraint() const;
 
+          /// Reset the classifier of the parent NodeSelector.
+          virtual void invalidate ();
+
+          /// Build configConstraint for a thread.
+          virtual void buildConstraints (const std::size_t& slot) const;
+
+          /// Create the constraints of the component and the constraints
+          /// for path of a thread, and remove the constraint set it built
+          /// before.
+          virtual void instantiateConstraints (const std::size_t& slot,
+              const core::DevicePtr_t& robot) const;
+
+          virtual void fixSlots (const std::size_t& nbSlots) const;
+
           /// Add core::NumericalConstraint to the component.
           virtual void addNumericalConstraintForPath (const NumericalConstraintPtr_t& nm,
               const SizeIntervals_t& passiveDofs = SizeIntervals_t ())
           {
+            checkNotFrozen ();
             numericalConstraintsForPath_.push_back (nm);
             passiveDofsForPath_.push_back (passiveDofs);
+            factoriesForPath_.push_back (NumericalConstraintFactory_t ());
           }
 
+          /// Add a numerical constraint for path created by a factory.
+          /// \sa GraphComponent::addNumericalConstraint (const NumericalConstraintFactory_t&, const SizeIntervals_t&)
+          virtual void addNumericalConstraintForPath
+            (const NumericalConstraintFactory_t& factory,
+             const SizeIntervals_t& passiveDofs = SizeIntervals_t ());
+
           /// Add core::DifferentiableFunction to the component.
           virtual void addNumericalConstraintForPath (const DifferentiableFunctionPtr_t& function, const ComparisonTypePtr_t& ineq)
             HPP_MANIPULATION_DEPRECATED
           {
-            numericalConstraintsForPath_.push_back (NumericalConstraint::create (function,ineq));
+            addNumericalConstraintForPath
+              (NumericalConstraint::create (function,ineq));
           }
 
           /// Insert the numerical constraints in a ConfigProjector
           /// \return true is at least one NumericalConstraintPtr_t was inserted.
-          bool insertNumericalConstraintsForPath (ConfigProjectorPtr_t& proj) const
-          {
-            assert (numericalConstraintsForPath_.size () == passiveDofsForPath_.size ());
-            IntervalsContainer_t::const_iterator itpdofs = passiveDofsForPath_.begin ();
-            for (NumericalConstraints_t::const_iterator it = numericalConstraintsForPath_.begin();
-                it != numericalConstraintsForPath_.end(); it++) {
-              proj->add (*it, *itpdofs);
-              itpdofs++;
-            }
-            return !numericalConstraintsForPath_.empty ();
-          }
+          bool insertNumericalConstraintsForPath (ConfigProjectorPtr_t& proj) const;
+
+          /// Insert the numerical constraints for path of a thread in a
+          /// ConfigProjector.
+          /// \sa GraphComponent::numericalConstraints (const std::size_t&) const
+          bool insertNumericalConstraintsForPath (ConfigProjectorPtr_t& proj,
+              const std::size_t& slot) const;
 
           /// Get a reference to the NumericalConstraints_t
           const NumericalConstraints_t& numericalConstraintsForPath () const
@@ -144,10 +173,22 @@ namespace hpp {
           virtual void populateTooltip (dot::Tooltip& tp) const;
 
         private:
+          ConstraintSetPtr_t buildConfigConstraint (const std::size_t& slot) const;
+
+          /// Rebuild the alias table from neighbors_.
+          void updateAliasTable ();
+
           /// List of possible motions from this state (i.e. the outgoing
           /// vertices).
           Neighbors_t neighbors_;
 
+          /// Alias table of neighbors_.
+          /// Edge i is chosen with probability aliasProbabilities_[i] when
+          /// column i is drawn, and edge aliases_[i] otherwise.
+          Edges_t aliasEdges_;
+          std::vector < value_type > aliasProbabilities_;
+          std::vector < std::size_t > aliases_;
+
           /// Set of constraints to be statisfied.
           typedef Cache < ConstraintSetPtr_t > Constraint_t;
           Constraint_t* configConstraints_;
@@ -155,6 +196,17 @@ namespace hpp {
           /// Stores the numerical constraints for path.
           NumericalConstraints_t numericalConstraintsForPath_;
           IntervalsContainer_t passiveDofsForPath_;
+          std::vector <NumericalConstraintFactory_t> factoriesForPath_;
+
+          /// Numerical constraints for path of the threads using a copy of
+          /// the robot. Empty for the threads using Graph::robot ().
+          struct PathInstances {
+            bool set;
+            NumericalConstraints_t constraints;
+
+            PathInstances () : set (false) {}
+          };
+          PerThread <PathInstances> pathInstances_;
 
           /// A selector that will implement the selection of the next state.
           NodeSelectorWkPtr_t selector_;
@@ -0,0 +1,154 @@
+// Copyright (c) 2015, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_GRAPH_PER_THREAD_HH
+# define HPP_MANIPULATION_GRAPH_PER_THREAD_HH
+
+# include <vector>
+# include <sstream>
+# include <stdexcept>
+
+# include "hpp/manipulation/config.hh"
+# include "hpp/manipulation/thread-pool.hh"
+
+namespace hpp {
+  namespace manipulation {
+    namespace graph {
+      /// Storage of one instance of T per thread.
+      ///
+      /// The instances are the elements of a vector indexed by
+      /// ThreadPool::threadSlot, so that accessing them does not lock.
+      /// The vector grows when a slot beyond its end is accessed, which is
+      /// not thread safe. Graph::initialize calls fix with the slots of all
+      /// the threads using the graph, before they start: afterwards, the
+      /// vector never grows and a thread with another slot gets an
+      /// exception instead of a data race.
+      template <typename T>
+        class HPP_MANIPULATION_LOCAL PerThread
+      {
+        public:
+          PerThread (const T& init = T ()) :
+            init_ (init), values_ (), fixed_ (false)
+          {}
+
+          /// Get the instance of the calling thread.
+          T& local () const
+          {
+            return at (ThreadPool::threadSlot ());
+          }
+
+          /// Get the instance of a given thread.
+          /// \note The reference is invalidated when the vector grows.
+          /// \throw std::logic_error if the storage is fixed and slot is
+          ///        beyond its end.
+          T& at (const std::size_t& slot) const
+          {
+            if (slot >= values_.size ()) {
+              if (fixed_) {
+                std::ostringstream oss;
+                oss << "Thread slot " << slot << " was not given to "
+                  "Graph::initialize. Only " << values_.size ()
+                  << " slots have an instance.";
+                throw std::logic_error (oss.str ());
+              }
+              values_.resize (slot + 1, init_);
+            }
+            return values_ [slot];
+          }
+
+          /// Create the instances of the slots lower than nbSlots and
+          /// forbid the storage to grow afterwards.
+          /// Calling it again with more slots adds their instances.
+          /// \note Not thread safe.
+          void fix (const std::size_t& nbSlots) const
+          {
+            if (nbSlots > values_.size ()) values_.resize (nbSlots, init_);
+            fixed_ = true;
+          }
+
+          /// Remove all the instances and set the reference value.
+          /// If the storage is fixed, the instances of its slots are
+          /// replaced by the reference value.
+          void reset (const T& init = T ())
+          {
+            init_ = init;
+            values_.assign (fixed_ ? values_.size () : 0, init_);
+          }
+
+        private:
+          T init_;
+          mutable std::vector <T> values_;
+          mutable bool fixed_;
+      };
+
+      /// Cache mechanism that enable const-correctness of member functions.
+      ///
+      /// One value is cached per thread, so that several threads can build
+      /// and use their own instance.
+      template <typename C>
+        class HPP_MANIPULATION_LOCAL Cache
+      {
+        public:
+          void set (const C& c)
+          {
+            c_.local () = c;
+          }
+
+          void set (const std::size_t& slot, const C& c)
+          {
+            c_.at (slot) = c;
+          }
+
+          operator bool() const
+          {
+            return (bool)c_.local ();
+          }
+
+          bool isSet (const std::size_t& slot) const
+          {
+            return (bool)c_.at (slot);
+          }
+
+          const C& get () const
+          {
+            return c_.local ();
+          }
+
+          const C& get (const std::size_t& slot) const
+          {
+            return c_.at (slot);
+          }
+
+          /// Remove the value of every thread.
+          void clear ()
+          {
+            c_.reset ();
+          }
+
+          /// \copydoc PerThread::fix
+          void fix (const std::size_t& nbSlots) const
+          {
+            c_.fix (nbSlots);
+          }
+
+        private:
+          PerThread <C> c_;
+      };
+    } // namespace graph
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_GRAPH_PER_THREAD_HH
@@ -18,6 +18,10 @@
 #ifndef HPP_MANIPULATION_GRAPH_STATISTICS_HH
 # define HPP_MANIPULATION_GRAPH_STATISTICS_HH
 
+# include <vector>
+# include <boost/function.hpp>
+# include <boost/thread/mutex.hpp>
+
 # include <hpp/util/debug.hh>
 
 # include <hpp/core/node.hh>
@@ -26,8 +30,10 @@
 
 # include "hpp/manipulation/config.hh"
 # include "hpp/manipulation/fwd.hh"
+# include "hpp/manipulation/random.hh"
 # include "hpp/manipulation/graph/graph.hh"
 # include "hpp/manipulation/graph/node.hh"
+# include "hpp/manipulation/roadmap-node.hh"
 
 namespace hpp {
   namespace manipulation {
@@ -38,31 +44,54 @@ namespace hpp {
       {
         public :
           typedef ::hpp::statistics::Bin Parent;
-          typedef std::list <core::NodePtr_t> RoadmapNodes_t;
+          typedef RoadmapNodeArena::Range RoadmapNodes_t;
 
-          LeafBin(const vector_t& v, value_type* threshold_);
+          /// Constructor
+          /// \param arena storage of the roadmap nodes of the bin.
+          LeafBin(const vector_t& v, value_type* threshold_,
+              const RoadmapNodeArena* arena);
+
+          /// Index of the leaf in the LeafHistogram.
+          std::size_t index () const
+          {
+            return index_;
+          }
 
-          void push_back(const core::NodePtr_t& n);
+          /// Set the index of the leaf in the LeafHistogram.
+          void index (const std::size_t& i)
+          {
+            index_ = i;
+          }
 
-          bool operator<(const LeafBin& rhs) const;
+          void push_back(const RoadmapNodeArena::Index_t& n);
 
+          /// Whether the values differ by less than the threshold on each
+          /// coordinate.
           bool operator==(const LeafBin& rhs) const;
 
+          /// Whether the value of the bin matches v.
+          /// \sa operator==
+          bool contains (const vector_t& v) const;
+
           const vector_t& value () const;
 
           std::ostream& print (std::ostream& os) const;
 
           unsigned int numberOfObsOutOfConnectedComponent (const core::ConnectedComponentPtr_t& cc) const;
 
-          const RoadmapNodes_t& nodes () const;
+          RoadmapNodes_t nodes () const;
 
         private:
           vector_t value_;
 
-          RoadmapNodes_t nodes_;
+          /// Indexes of the roadmap nodes in arena_.
+          RoadmapNodeArena::Indexes_t nodes_;
+          const RoadmapNodeArena* arena_;
 
           value_type* thr_;
 
+          std::size_t index_;
+
           std::ostream& printValue (std::ostream& os) const;
       };
 
@@ -72,9 +101,13 @@ namespace hpp {
       {
         public :
           typedef ::hpp::statistics::Bin Parent;
-          NodeBin(const NodePtr_t& n);
+          typedef RoadmapNodeArena::Range RoadmapNodes_t;
 
-          void push_back(const core::NodePtr_t& n);
+          /// Constructor
+          /// \param arena storage of the roadmap nodes of the bin.
+          NodeBin(const NodePtr_t& n, const RoadmapNodeArena* arena);
+
+          void push_back(const RoadmapNodeArena::Index_t& n);
 
           bool operator<(const NodeBin& rhs) const;
 
@@ -82,13 +115,16 @@ namespace hpp {
 
           const NodePtr_t& node () const;
 
+          RoadmapNodes_t nodes () const;
+
           std::ostream& print (std::ostream& os) const;
 
         private:
           NodePtr_t node_;
 
-          typedef std::list <core::NodePtr_t> RoadmapNodes_t;
-          RoadmapNodes_t roadmapNodes_;
+          /// Indexes of the roadmap nodes in arena_.
+          RoadmapNodeArena::Indexes_t roadmapNodes_;
+          const RoadmapNodeArena* arena_;
 
           std::ostream& printValue (std::ostream& os) const;
       };
@@ -98,7 +134,55 @@ namespace hpp {
         public:
           virtual void add (const core::NodePtr_t& node) = 0;
 
+          /// Compute what add needs from the configuration of a node.
+          ///
+          /// Together with add (const core::NodePtr_t&, const vector_t&),
+          /// this splits add so that only classify evaluates functions of
+          /// the robot. Roadmap calls classify on the thread inserting the
+          /// node, or a classifier in its statistics thread, if any.
+          /// \retval value the value to pass to add.
+          /// \return whether the node is to be added.
+          virtual bool classify (const core::NodePtr_t& node,
+              vector_t& value) const;
+
+          /// Function computing what classify computes.
+          typedef boost::function < bool (const core::NodePtr_t&, vector_t&) >
+            Classifier_t;
+
+          /// Create a function computing what classify computes, evaluating
+          /// the functions of another robot.
+          ///
+          /// The statistics thread of Roadmap classifies the nodes with it,
+          /// on its own copy of the robot. The default calls classify, which
+          /// then must not evaluate functions of the robot.
+          /// The function must not outlive the histogram.
+          virtual Classifier_t classifier (const core::DevicePtr_t& robot) const;
+
+          /// Insert a node with the value computed by classify.
+          virtual void add (const core::NodePtr_t& node, const vector_t& value);
+
           virtual HistogramPtr_t clone () const = 0;
+
+          /// Set the storage of the roadmap nodes.
+          /// Called by Roadmap::insertHistogram.
+          void nodeArena (const RoadmapNodeArenaPtr_t& arena)
+          {
+            arena_ = arena;
+          }
+
+          /// Get the storage of the roadmap nodes.
+          const RoadmapNodeArenaPtr_t& nodeArena () const
+          {
+            return arena_;
+          }
+
+        protected:
+          /// Index of a node in the arena.
+          /// \throw std::logic_error if the histogram is not inserted in a
+          ///        Roadmap.
+          RoadmapNodeArena::Index_t index (const core::NodePtr_t& node) const;
+
+          RoadmapNodeArenaPtr_t arena_;
       };
 
       /// This class represents a foliation of a submanifold of the configuration
@@ -111,16 +195,68 @@ namespace hpp {
       class HPP_MANIPULATION_DLLAPI Foliation
       {
         public:
+          /// Function creating a projector for a robot.
+          typedef boost::function < ConfigProjectorPtr_t
+            (const core::DevicePtr_t&) > ProjectorFactory_t;
+
           /// Whether the configuration is the submanifold $\mathcal{M}$
           bool contains (ConfigurationIn_t q) const;
           /// Whether the configuration is the submanifold $\mathcal{M}$
           vector_t parameter (ConfigurationIn_t q) const;
 
+          /// Whether the configuration is in the submanifold and, if so,
+          /// the parameter of its leaf.
+          ///
+          /// This evaluates the condition once, whereas calling contains
+          /// then parameter evaluates it twice.
+          /// \retval parameter the parameter of the leaf. Not modified if
+          ///         q is not in the submanifold.
+          /// \return whether q is in the submanifold.
+          bool classify (ConfigurationIn_t q, vector_t& parameter) const;
+
+          /// Classify several configurations.
+          /// \param configs the configurations, in the columns,
+          /// \retval contains whether each configuration is in the
+          ///         submanifold,
+          /// \retval parameters the parameters of the leaves, in the
+          ///         columns. The columns of the configurations out of the
+          ///         submanifold are not set.
+          /// \sa classify (ConfigurationIn_t, vector_t&) const
+          void classify (const matrix_t& configs, std::vector <bool>& contains,
+              matrix_t& parameters) const;
+
           void condition (const ConfigProjectorPtr_t c);
           ConfigProjectorPtr_t condition () const;
+
+          /// Set the condition with a factory.
+          /// \sa parametrizer (const ProjectorFactory_t&,
+          ///                   const core::DevicePtr_t&)
+          void condition (const ProjectorFactory_t& factory,
+              const core::DevicePtr_t& robot);
+
+          /// Create a condition for another robot.
+          /// \throw std::logic_error if the condition was not set with a
+          ///        factory.
+          ConfigProjectorPtr_t createCondition
+            (const core::DevicePtr_t& robot) const;
+
           void parametrizer (const ConfigProjectorPtr_t p);
           ConfigProjectorPtr_t parametrizer () const;
 
+          /// Set the parametrizer with a factory.
+          ///
+          /// The parametrizer is created for robot. The factory lets
+          /// LevelSetEdge create a parametrizer on the copy of the robot of
+          /// each thread (see Graph::initialize).
+          void parametrizer (const ProjectorFactory_t& factory,
+              const core::DevicePtr_t& robot);
+
+          /// Create a parametrizer for another robot.
+          /// \throw std::logic_error if the parametrizer was not set with a
+          ///        factory.
+          ConfigProjectorPtr_t createParametrizer
+            (const core::DevicePtr_t& robot) const;
+
         private:
           // condition_ contains the constraints defining the submanifold
           // containing all the leaf.
@@ -134,19 +270,42 @@ namespace hpp {
           //  LockedJoints_t lj;
           //} condition_, parametrizer_;
           ConfigProjectorPtr_t condition_, parametrizer_;
+          ProjectorFactory_t conditionFactory_, parametrizerFactory_;
       };
 
-      class HPP_MANIPULATION_DLLAPI LeafHistogram : public ::hpp::statistics::Statistics < LeafBin >
-                                                      , public Histogram
+      /// Histogram of the leaves of a foliation visited by the roadmap.
+      ///
+      /// Two parameters belong to the same leaf if they differ by less than
+      /// the threshold on each coordinate. The bins are found through a
+      /// hashed grid over the parameter space: only the cells neighbouring
+      /// the one of a parameter are searched, along at most 4 coordinates
+      /// close to the border of its cell. The cells are 16 times as large
+      /// as the threshold, so that this rarely misses a matching bin. When
+      /// several bins match a parameter, the one created first is selected.
+      class HPP_MANIPULATION_DLLAPI LeafHistogram : public Histogram
       {
         public:
-          typedef ::hpp::statistics::Statistics < LeafBin > Parent;
+          typedef std::vector < LeafBin > LeafBins_t;
+          typedef LeafBins_t::const_iterator const_iterator;
 
           static LeafHistogramPtr_t create (const Foliation f);
 
           /// Insert an occurence of a value in the histogram
           void add (const core::NodePtr_t& n);
 
+          /// Compute the parameter of the leaf of the node.
+          /// \return whether the node is in the submanifold.
+          bool classify (const core::NodePtr_t& n, vector_t& value) const;
+
+          /// Classify with a copy of the foliation created for robot.
+          /// \throw std::logic_error if the condition or the parametrizer
+          ///        of the foliation was set without factory.
+          Classifier_t classifier (const core::DevicePtr_t& robot) const;
+
+          /// Insert a node in the leaf of parameter value.
+          /// This does not use the foliation.
+          void add (const core::NodePtr_t& n, const vector_t& value);
+
           std::ostream& print (std::ostream& os) const;
 
           virtual HistogramPtr_t clone () const;
@@ -154,10 +313,54 @@ namespace hpp {
           statistics::DiscreteDistribution < core::NodePtr_t > getDistribOutOfConnectedComponent (
               const core::ConnectedComponentPtr_t& cc) const;
 
+          /// Sample a leaf with a probability proportional to its number
+          /// of roadmap nodes out of a connected component.
+          ///
+          /// This gives the same distribution as
+          /// getDistribOutOfConnectedComponent but runs in logarithmic
+          /// time in the number of leaves.
+          /// \return a roadmap node of the leaf, or NULL if all the nodes
+          ///         are in cc.
+          core::NodePtr_t sampleOutOfConnectedComponent
+            (const core::ConnectedComponentPtr_t& cc) const;
+
+          /// Same as sampleOutOfConnectedComponent
+          /// (const core::ConnectedComponentPtr_t&), drawing from rng.
+          core::NodePtr_t sampleOutOfConnectedComponent
+            (const core::ConnectedComponentPtr_t& cc,
+             RandomGenerator_t& rng) const;
+
           const Foliation& foliation () const {
             return f_;
           }
 
+          /// \name Bins
+          /// \{
+
+          /// Bins in the order of their creation.
+          const_iterator begin () const
+          {
+            return bins_.begin ();
+          }
+
+          const_iterator end () const
+          {
+            return bins_.end ();
+          }
+
+          /// Number of inserted values.
+          unsigned int numberOfObservations () const
+          {
+            return numberOfObservations_;
+          }
+
+          /// Number of leaves.
+          unsigned int numberOfBins () const
+          {
+            return (unsigned int) bins_.size ();
+          }
+          /// \}
+
         protected:
           /// Constructor
           /// \param node defines the submanifold containing the foliation.
@@ -166,12 +369,58 @@ namespace hpp {
           LeafHistogram (const Foliation f);
 
         private:
+          /// Entry of the hash table. An entry is empty if bin is
+          /// std::size_t (-1).
+          struct Entry {
+            std::size_t hash;
+            std::size_t bin;
+          };
+          typedef std::vector < Entry > Table_t;
+          typedef std::vector < long > Cell_t;
+
+          /// Index of the bin of a parameter.
+          /// \return the number of bins if none of the bins matches.
+          std::size_t findBin (const vector_t& value) const;
+
+          /// Add a bin in the hash table.
+          void insertInTable (const std::size_t& bin);
+
+          /// Cell of the grid containing a parameter.
+          Cell_t cell (const vector_t& value) const;
+
+          static std::size_t hash (const Cell_t& cell);
+
           Foliation f_;
 
           /// Threshold used for equality between offset values.
           value_type threshold_;
+
+          LeafBins_t bins_;
+          unsigned int numberOfObservations_;
+
+          /// Size of the cells of the grid. It is larger than the
+          /// threshold so that most parameters are far from the border of
+          /// their cell on most coordinates.
+          value_type cellSize_;
+          /// Open addressing table, with linear probing, of the bins
+          /// indexed by the hash of their cell. Its size is a power of two.
+          Table_t table_;
+
+          /// Number of roadmap nodes per leaf and per connected component.
+          struct Counts;
+          boost::shared_ptr < Counts > counts_;
+          /// Protect the bins and counts_, which is updated by add and by
+          /// sampleOutOfConnectedComponent after merges of connected
+          /// components.
+          mutable boost::mutex mutex_;
       };
 
+      inline std::ostream& operator<< (std::ostream& os,
+          const LeafHistogram& h)
+      {
+        return h.print (os);
+      }
+
       class HPP_MANIPULATION_DLLLOCAL NodeHistogram : public ::hpp::statistics::Statistics < NodeBin >
                                                       , public Histogram
       {
@@ -0,0 +1,104 @@
+// Copyright (c) 2015, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_LATENCY_HISTOGRAM_HH
+# define HPP_MANIPULATION_LATENCY_HISTOGRAM_HH
+
+# include <ostream>
+
+# include "hpp/manipulation/config.hh"
+# include "hpp/manipulation/fwd.hh"
+
+namespace hpp {
+  namespace manipulation {
+    /// \addtogroup path_planning
+    /// \{
+
+    /// Durations of the executions of a task.
+    ///
+    /// Besides the cumulated duration, the durations are counted in
+    /// buckets of logarithmic width: bucket 0 contains the durations below
+    /// 2 microseconds and bucket i > 0 those in
+    /// \f$[2^i, 2^{i+1}[\f$ microseconds. The last bucket contains all the
+    /// longer durations.
+    class HPP_MANIPULATION_DLLAPI LatencyHistogram
+    {
+      public:
+        static const std::size_t nbBuckets = 32;
+
+        LatencyHistogram ();
+
+        /// Add a duration, in seconds.
+        void add (const value_type& duration);
+
+        /// Add the durations of another histogram.
+        void merge (const LatencyHistogram& other);
+
+        /// Remove all the durations.
+        void clear ();
+
+        /// Number of durations.
+        std::size_t count () const
+        {
+          return count_;
+        }
+
+        /// Sum of the durations, in seconds.
+        value_type total () const
+        {
+          return total_;
+        }
+
+        /// Mean duration, in seconds. 0 if empty.
+        value_type mean () const
+        {
+          return count_ > 0 ? total_ / (value_type) count_ : 0;
+        }
+
+        /// Shortest duration, in seconds. 0 if empty.
+        value_type min () const
+        {
+          return count_ > 0 ? min_ : 0;
+        }
+
+        /// Longest duration, in seconds.
+        value_type max () const
+        {
+          return max_;
+        }
+
+        /// Number of durations in a bucket.
+        std::size_t bucket (const std::size_t& i) const
+        {
+          return buckets_ [i];
+        }
+
+        /// Index of the bucket of a duration, in seconds.
+        static std::size_t bucketIndex (const value_type& duration);
+
+        /// Print as a JSON object.
+        std::ostream& printJSON (std::ostream& os) const;
+
+      private:
+        std::size_t count_;
+        value_type total_, min_, max_;
+        std::size_t buckets_ [nbBuckets];
+    }; // class LatencyHistogram
+    /// \}
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_LATENCY_HISTOGRAM_HH
@@ -17,14 +17,21 @@
 #ifndef HPP_MANIPULATION_MANIPULATION_PLANNER_HH
 # define HPP_MANIPULATION_MANIPULATION_PLANNER_HH
 
+#include <set>
+#include <list>
+#include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
 #include <hpp/model/configuration.hh>
-#include <hpp/core/basic-configuration-shooter.hh>
 #include <hpp/core/path-planner.hh>
 #include <hpp/core/roadmap.hh>
 
 #include <hpp/statistics/success-bin.hh>
 
 #include "hpp/manipulation/graph/statistics.hh"
+#include "hpp/manipulation/latency-histogram.hh"
+#include "hpp/manipulation/random.hh"
 
 #include "hpp/manipulation/config.hh"
 #include "hpp/manipulation/graph/fwd.hh"
@@ -51,6 +58,27 @@ namespace hpp {
         ///
         virtual void oneStep ();
 
+        /// Add the init and goal nodes to the roadmap.
+        ///
+        /// If the roadmap already contains other nodes, for instance when
+        /// it is kept from a previous query, the init and goal nodes are
+        /// first connected to them as the new nodes of oneStep are.
+        /// Sampling then starts only if this does not solve the problem.
+        /// \sa ProblemSolver::multiQuery
+        virtual void startSolve ();
+
+        /// Find a path in the roadmap.
+        ///
+        /// Without time budget, this is core::PathPlanner::solve.
+        /// Otherwise, the resolution stops after the time budget.
+        /// The resolution cannot be resumed: calling solve again starts a
+        /// new one with startSolve, which adds the init and goal nodes
+        /// again and connects them to the nodes kept in the roadmap.
+        /// \throw std::runtime_error if no path was found within the time
+        ///        budget.
+        /// \sa timeBudget
+        virtual core::PathVectorPtr_t solve ();
+
         /// Extend a the configuration q_near toward q_rand.
         /// \param q_near the configuration to be extended.
         /// \param q_rand the configuration toward extension is performed.
@@ -60,6 +88,356 @@ namespace hpp {
         bool extend (const core::NodePtr_t &q_near,
             const ConfigurationPtr_t &q_rand, core::PathPtr_t& validPath);
 
+        /// Set the number of threads extending the connected components.
+        ///
+        /// If greater than 1, the extensions of oneStep are computed
+        /// concurrently by a ThreadPool. The resulting paths are inserted in
+        /// the roadmap afterwards, in the order of the connected components,
+        /// so that the roadmap does not depend on the number of threads.
+        ///
+        /// Each thread evaluates the constraints and validates the paths
+        /// on its own copy of the robot. Before the first step, the
+        /// constraint graph is initialized for the threads (see
+        /// graph::Graph::initialize), so its numerical constraints must be
+        /// added with factories, and a factory of path validation must be
+        /// set (see pathValidationFactory). The number of threads can be
+        /// changed between two steps, and several planners can share the
+        /// graph: the threads that are new to the graph are added to it.
+        void numberOfThreads (const std::size_t& n);
+
+        /// Get the number of threads extending the connected components.
+        std::size_t numberOfThreads () const;
+
+        /// Slots of the threads using the constraint graph: the calling
+        /// thread, the threads extending the connected components and the
+        /// workers of the pipeline.
+        /// \sa graph::Graph::initialize
+        std::vector < std::size_t > threadSlots () const;
+
+        /// Function creating a path validation for a copy of the robot.
+        typedef boost::function < GraphPathValidationPtr_t
+          (const core::DevicePtr_t&) > PathValidationFactory_t;
+
+        /// Set the factory of the path validations of the threads.
+        ///
+        /// Required if several threads extend the roadmap. The constraint
+        /// graph and the obstacles of the problem are set in the created
+        /// path validations. The thread calling oneStep uses the path
+        /// validation of the problem.
+        void pathValidationFactory (const PathValidationFactory_t& factory)
+        {
+          pathValidationFactory_ = factory;
+          threadsInitialized_ = false;
+        }
+
+        /// \name Connection of the new nodes
+        /// After the extensions, each new node is connected to the nodes
+        /// of the other connected components lying in a state reachable by
+        /// one transition of the constraint graph. These nodes are tried by
+        /// increasing distance, until one connection succeeds.
+        /// \{
+
+        /// Set the maximal number of nodes tried per connected component.
+        /// \param k the number of nodes, 0 for no limit (default). With
+        ///        lazyConnection, 0 means 5, since all the candidates are
+        ///        kept.
+        void maxConnectionsPerComponent (const std::size_t& k)
+        {
+          maxConnectionsPerComponent_ = k;
+        }
+
+        /// Get the maximal number of nodes tried per connected component.
+        const std::size_t& maxConnectionsPerComponent () const
+        {
+          return maxConnectionsPerComponent_;
+        }
+
+        /// Set the maximal distance between the connected nodes.
+        /// Default to infinity.
+        void connectionRadius (const value_type& radius)
+        {
+          connectionRadius_ = radius;
+        }
+
+        /// Get the maximal distance between the connected nodes.
+        const value_type& connectionRadius () const
+        {
+          return connectionRadius_;
+        }
+
+        /// Set the maximal number of connections tried at each step.
+        /// \param budget the number of connections, 0 for no limit (default).
+        void connectionBudget (const std::size_t& budget)
+        {
+          connectionBudget_ = budget;
+        }
+
+        /// Get the maximal number of connections tried at each step.
+        const std::size_t& connectionBudget () const
+        {
+          return connectionBudget_;
+        }
+
+        /// Enable or disable the lazy validation of the connections.
+        ///
+        /// When enabled, the connections are projected but not validated,
+        /// and all the candidates of a node are kept, instead of the first
+        /// valid one, within maxConnectionsPerComponent and
+        /// connectionBudget. They are kept aside from the roadmap until the
+        /// init node and a goal node are linked by the roadmap and these
+        /// connections. The
+        /// connections along such a candidate solution are then validated.
+        /// The valid ones are inserted in the roadmap and the others are
+        /// discarded, until a solution is found or no candidate remains.
+        /// The search is done again only when connections or roadmap edges
+        /// were added. Disabled by default.
+        /// \sa maxLazyEdges
+        void lazyConnection (const bool& enable)
+        {
+          lazyConnection_ = enable;
+        }
+
+        /// Whether the connections are validated lazily.
+        const bool& lazyConnection () const
+        {
+          return lazyConnection_;
+        }
+
+        /// Set the maximal number of connections kept by lazyConnection.
+        /// Beyond, the oldest ones are discarded.
+        /// \param n the number of connections, 0 for no limit. Default to
+        ///        10000.
+        void maxLazyEdges (const std::size_t& n)
+        {
+          maxLazyEdges_ = n;
+        }
+
+        /// Get the maximal number of connections kept by lazyConnection.
+        const std::size_t& maxLazyEdges () const
+        {
+          return maxLazyEdges_;
+        }
+        /// \}
+
+        /// \name Adaptive weights of the transitions
+        /// When enabled, the weights of the outgoing edges of the states
+        /// are updated after each step from the extensions done so far.
+        /// The weight of an edge is its initial weight, used as a prior,
+        /// multiplied by an upper confidence bound (UCB) of its rate of
+        /// successful extensions per second:
+        /// \f[
+        /// \frac{\min \left(1, \frac{s+1}{n+2} + c \sqrt{\frac{\log (N+1)}{n+1}}\right)}{t}
+        /// \f]
+        /// where \f$s\f$ and \f$n\f$ are the numbers of successes and
+        /// trials of the edge, \f$N\f$ the number of trials of the edges of
+        /// the state, \f$t\f$ the average duration of a trial and \f$c\f$
+        /// the exploration factor. Edges of initial weight 0 are never
+        /// selected.
+        /// \{
+
+        /// Enable or disable the adaptive weights.
+        /// When disabled, the initial weights are restored.
+        void adaptiveEdgeWeights (const bool& enable);
+
+        /// Whether the adaptive weights are enabled.
+        const bool& adaptiveEdgeWeights () const
+        {
+          return adaptiveEdgeWeights_;
+        }
+
+        /// Set the exploration factor. Default to \f$\sqrt{2}\f$.
+        void explorationFactor (const value_type& c)
+        {
+          explorationFactor_ = c;
+        }
+
+        /// Get the exploration factor.
+        const value_type& explorationFactor () const
+        {
+          return explorationFactor_;
+        }
+        /// \}
+
+        /// \name Pipelined extension
+        /// In pipelined mode, the stages of the extensions are executed by
+        /// three pools of workers: projection (graph::Edge::applyConstraints),
+        /// steering (graph::Edge::build and path projection) and validation.
+        /// The pools are linked by queues on which idle workers block.
+        /// oneStep shoots random configurations and queues the extensions
+        /// of the connected components while the pipeline has room. It then
+        /// inserts in the roadmap the extensions completed so far, waiting
+        /// for at least one.
+        ///
+        /// The roadmap, its connected components and the histograms of the
+        /// leaves are only accessed by the thread calling oneStep: it
+        /// chooses the edge and the target leaf (see
+        /// graph::Edge::sampleTarget) of each extension and queues them with
+        /// a copy of the configuration of the nearest node. The workers
+        /// evaluate the constraints and validate the paths on their own copy
+        /// of the robot, so the requirements of numberOfThreads apply.
+        /// \note An extension starts from the roadmap as it was when the
+        ///       extension was queued.
+        /// \{
+
+        /// Enable or disable the pipelined extension.
+        /// \param projectionThreads, steeringThreads, validationThreads
+        ///        number of workers of each stage. The pipeline is disabled
+        ///        if one of them is 0.
+        /// \param queueSize maximal number of extensions in the pipeline.
+        void pipeline (const std::size_t& projectionThreads,
+            const std::size_t& steeringThreads,
+            const std::size_t& validationThreads,
+            const std::size_t& queueSize = 64);
+
+        /// Whether the extensions are pipelined.
+        bool pipelined () const
+        {
+          return (bool) pipeline_;
+        }
+        /// \}
+
+        /// \name Reproducibility and time budget
+        /// The random choices of the extensions (choice of the edge,
+        /// projection onto a leaf) are drawn from generators seeded from
+        /// the seed, the index of the step and the index of the connected
+        /// component, so that they do not depend on the number of threads
+        /// nor on the thread executing an extension.
+        /// \note In pipelined mode, the extensions are inserted in their
+        ///       order of completion and the roadmap is not reproducible.
+        /// \{
+
+        /// Set the seed of the random choices and restart the sequence.
+        /// The configuration shooter of the planner is seeded as well.
+        void seed (const std::size_t& s);
+
+        /// Get the seed of the random choices.
+        const std::size_t& seed () const
+        {
+          return seed_;
+        }
+
+        /// Set the maximal duration of solve, in seconds. 0 for no limit,
+        /// which is the default.
+        ///
+        /// The deadline is checked between the steps and by the loops of
+        /// the extensions and of the connections, which stop early when
+        /// it is reached. solve then throws std::runtime_error.
+        /// \throw std::invalid_argument if seconds is negative.
+        void timeBudget (const value_type& seconds);
+
+        /// Get the maximal duration of solve, in seconds.
+        const value_type& timeBudget () const
+        {
+          return timeBudget_;
+        }
+        /// \}
+
+        /// \name Goal-directed choice of the edges
+        /// When enabled, the edge along which a node is extended is chosen,
+        /// with probability 1 - explorationRatio, among the outgoing edges
+        /// that reduce the cost to reach the states of the goal
+        /// configurations. The cost of a transition is
+        /// \f$-\log \frac{s+1}{n+2}\f$, where \f$s\f$ and \f$n\f$ are the
+        /// numbers of successful extensions and of trials along the edge.
+        /// Otherwise, or if no edge reduces the cost, the edge is chosen by
+        /// graph::Graph::chooseEdge.
+        /// \{
+
+        /// Enable or disable the goal-directed choice of the edges.
+        /// Disabled by default.
+        void goalDirectedEdgeChoice (const bool& enable)
+        {
+          goalDirectedEdgeChoice_ = enable;
+        }
+
+        /// Whether the goal-directed choice of the edges is enabled.
+        const bool& goalDirectedEdgeChoice () const
+        {
+          return goalDirectedEdgeChoice_;
+        }
+
+        /// Set the probability to choose the edge randomly.
+        /// Default to 0.5.
+        void explorationRatio (const value_type& ratio)
+        {
+          explorationRatio_ = ratio;
+        }
+
+        /// Get the probability to choose the edge randomly.
+        const value_type& explorationRatio () const
+        {
+          return explorationRatio_;
+        }
+
+        /// Cost to reach the goal states from a state.
+        /// The costs are updated at the beginning of the resolution and
+        /// after each step.
+        /// \return the cost, infinite if no goal state can be reached.
+        value_type costToGoal (const graph::NodePtr_t& state) const;
+        /// \}
+
+        /// \name Latency of the stages of a step
+        /// When enabled, the duration of each stage of oneStep is recorded,
+        /// for all the edges and per edge for the stages related to an
+        /// edge. Each thread records its durations apart, and they are
+        /// merged when read.
+        /// \{
+
+        /// Stages of oneStep.
+        enum Stage {
+          /// Random configuration
+          SHOOT,
+          /// Nearest node of each connected component
+          NEAREST_NEIGHBOR,
+          /// Edge along which a node is extended
+          CHOOSE_EDGE,
+          /// graph::Edge::applyConstraints
+          APPLY_CONSTRAINTS,
+          /// graph::Edge::build
+          BUILD_PATH,
+          /// Path projection
+          PROJECT_PATH,
+          /// Path validation
+          VALIDATE_PATH,
+          /// Insertion of the extensions in the roadmap
+          INSERT_IN_ROADMAP,
+          /// Connection of the new nodes
+          CONNECT,
+          NB_STAGES
+        };
+
+        /// Name of a stage.
+        static const char* stageName (const Stage& stage);
+
+        /// Enable or disable the measure of the latencies.
+        /// Disabled by default.
+        void measureLatencies (const bool& enable)
+        {
+          measureLatencies_ = enable;
+        }
+
+        /// Whether the latencies are measured.
+        const bool& measureLatencies () const
+        {
+          return measureLatencies_;
+        }
+
+        /// Durations of a stage, for all the edges.
+        LatencyHistogram latency (const Stage& stage) const;
+
+        /// Durations of a stage for one edge.
+        /// Empty for the stages not related to an edge.
+        LatencyHistogram latency (const Stage& stage,
+            const graph::EdgePtr_t& edge) const;
+
+        /// Remove all the recorded durations.
+        void clearLatencies ();
+
+        /// Print the durations of all the stages and of all the edges as a
+        /// JSON object.
+        std::ostream& printLatenciesJSON (std::ostream& os) const;
+        /// \}
+
       protected:
         /// Protected constructor
         ManipulationPlanner (const Problem& problem,
@@ -69,11 +447,148 @@ namespace hpp {
         void init (const ManipulationPlannerWkPtr_t& weak);
 
       private:
+        class StageTimer;
+
+        typedef std::vector < LatencyHistogram > Latencies_t;
+
+        /// Durations recorded by one thread.
+        struct ThreadLatencies {
+          /// Only contended when the durations are read.
+          boost::mutex mutex;
+          /// Durations of each stage.
+          Latencies_t stages;
+          /// Durations of each stage per edge, indexed by
+          /// graph::GraphComponent::id. Empty for the other components.
+          std::vector < Latencies_t > edges;
+
+          ThreadLatencies () : stages (NB_STAGES), edges () {}
+        };
+        typedef boost::shared_ptr < ThreadLatencies > ThreadLatenciesPtr_t;
+
+        /// Merge the durations of all the threads.
+        void mergeLatencies (Latencies_t& stages,
+            std::vector < Latencies_t >& edges) const;
+
+        /// Record the duration of a stage.
+        /// \param edge the edge of the stage, if any.
+        void addLatency (const Stage& stage, const graph::EdgePtr_t& edge,
+            const value_type& duration);
+
+        /// Result of the extension of one connected component.
+        struct Extension {
+          core::NodePtr_t near;
+          core::PathPtr_t path;
+          bool valid;
+
+          Extension () : near (), path (), valid (false) {}
+        };
+        typedef std::vector < Extension > Extensions_t;
+        typedef std::vector < core::ConnectedComponentPtr_t >
+          ConnectedComponentVector_t;
+
+        /// Extend with a user provided buffer for the projected
+        /// configuration and generator of the random choices.
+        bool extend (const core::NodePtr_t &q_near,
+            const ConfigurationPtr_t &q_rand, core::PathPtr_t& validPath,
+            Configuration_t& qProj, RandomGenerator_t& rng);
+
+        /// Extend along a given edge.
+        bool extendAlongEdge (const graph::EdgePtr_t& edge,
+            const core::NodePtr_t &q_near,
+            const ConfigurationPtr_t &q_rand, core::PathPtr_t& validPath,
+            Configuration_t& qProj, RandomGenerator_t& rng);
+
+        /// \name Stages of extendAlongEdge
+        /// \{
+
+        /// Project a configuration with graph::Edge::applyConstraints.
+        /// \param target see graph::Edge::sampleTarget.
+        bool applyConstraints (const graph::EdgePtr_t& edge,
+            const Configuration_t& q_near, const ConfigurationPtr_t& target,
+            Configuration_t& qProj);
+
+        /// Build the path to the projected configuration and project it.
+        bool buildPath (const graph::EdgePtr_t& edge,
+            const Configuration_t& q_near, const Configuration_t& qProj,
+            core::PathPtr_t& projPath);
+
+        /// Validate the projected path.
+        void validatePath (const graph::EdgePtr_t& edge,
+            const core::PathPtr_t& projPath, core::PathPtr_t& validPath);
+        /// \}
+
+        /// Initialize the constraint graph and create the path validations
+        /// for threadSlots, if needed. The jobs of the pipeline are
+        /// discarded first, since they use both.
+        /// \throw std::logic_error if several threads are used and there
+        ///        is no factory of path validation.
+        void initializeThreads ();
+
+        /// Path validation of the calling thread.
+        core::PathValidationPtr_t pathValidation () const;
+
+        /// Choose the edge along which a node lying in a state is extended.
+        graph::EdgePtr_t chooseEdge (const graph::NodePtr_t& state,
+            RandomGenerator_t& rng);
+
+        /// States of the roadmap nodes that can be extended.
+        graph::Nodes_t extendableStates (const RoadmapPtr_t& r) const;
+
+        /// Nearest node of a connected component.
+        /// \param r the roadmap, if it is a manipulation::Roadmap,
+        /// \param extendableStates the states in which the nearest neighbor
+        ///        is searched, if r is not NULL.
+        core::NodePtr_t nearestNode (const ConfigurationPtr_t& q_rand,
+            const core::ConnectedComponentPtr_t& cc, const RoadmapPtr_t& r,
+            const graph::Nodes_t& extendableStates);
+
+        /// Insert the extensions in the roadmap, in the order of the
+        /// connected components, and connect the new nodes.
+        void insertExtensions (const Extensions_t& extensions);
+
+        /// oneStep in pipelined mode.
+        void pipelinedStep ();
+
+        /// Extend the i-th connected component toward q_rand.
+        /// This is the task executed by the thread pool.
+        /// \param r the roadmap, if it is a manipulation::Roadmap,
+        /// \param extendableStates the states in which the nearest neighbor
+        ///        is searched, if r is not NULL.
+        void extendConnectedComponent (const std::size_t& i,
+            const ConnectedComponentVector_t& ccs,
+            const ConfigurationPtr_t& q_rand, const RoadmapPtr_t& r,
+            const graph::Nodes_t& extendableStates, Extensions_t& extensions);
+
         /// Try to connect configurations in a list.
         void tryConnect (const core::Nodes_t nodes);
 
+        /// Connection whose path is not validated yet.
+        struct LazyEdge {
+          core::NodePtr_t from, to;
+          core::PathPtr_t path;
+        };
+        typedef std::list < LazyEdge > LazyEdges_t;
+
+        /// Validate the lazy edges along the candidate solutions.
+        /// \sa lazyConnection
+        void validateLazyEdges ();
+
+        /// Remove the lazy edges if the roadmap was cleared, since the
+        /// nodes they link were deleted.
+        void discardStaleLazyEdges ();
+
+        /// Whether solve reached the deadline of its time budget.
+        bool deadlineReached () const;
+
+        /// Nodes of a connected component to which tryConnect tries to
+        /// connect a node, in the order they are tried.
+        /// \param targets the states reachable from the state of the node.
+        core::Nodes_t connectionCandidates (const core::NodePtr_t& node,
+            const graph::Nodes_t& targets,
+            const core::ConnectedComponentPtr_t& cc) const;
+
         /// Configuration shooter
-        ConfigurationShooterPtr_t shooter_;
+        SeededConfigurationShooterPtr_t shooter_;
         /// Pointer to the problem
         const Problem& problem_;
         /// weak pointer to itself
@@ -122,7 +637,100 @@ namespace hpp {
 
         void addFailure (TypeOfFailure t, const graph::EdgePtr_t& edge);
 
+        /// Result of the extensions along one edge.
+        struct EdgeStatistics {
+          std::size_t trials, successes;
+          /// Total duration of the trials, in seconds.
+          value_type time;
+
+          EdgeStatistics () : trials (0), successes (0), time (0) {}
+        };
+        typedef std::map < graph::EdgePtr_t, EdgeStatistics >
+          EdgeStatisticsMap_t;
+        EdgeStatisticsMap_t edgeStatistics_;
+        /// States from which an extension was tried since the last call to
+        /// updateEdgeWeights.
+        std::set < graph::NodePtr_t > statesToUpdate_;
+
+        void addTrial (const graph::EdgePtr_t& edge, const bool& success,
+            const value_type& time);
+
+        /// Update the weights of the edges of statesToUpdate_.
+        void updateEdgeWeights ();
+
+        /// Update costsToGoal_ and edgeCosts_ from edgeStatistics_.
+        void updateCostsToGoal ();
+
+        /// Outgoing edge of a state with the lowest cost to the goal
+        /// states, among the ones reducing it.
+        /// \return the edge or NULL if there is none.
+        graph::EdgePtr_t edgeTowardGoal (const graph::NodePtr_t& state) const;
+
+        bool goalDirectedEdgeChoice_;
+        value_type explorationRatio_;
+        typedef std::map < graph::EdgePtr_t, value_type > EdgeCosts_t;
+        EdgeCosts_t edgeCosts_;
+        graph::Graph::StateCosts_t costsToGoal_;
+
+        bool adaptiveEdgeWeights_;
+        value_type explorationFactor_;
+        /// Initial weights of the edges.
+        typedef std::map < graph::EdgePtr_t, graph::Weight_t > Weights_t;
+        Weights_t priors_;
+
+        /// Protect extendStatistics_, failureReasons_, edgeStatistics_
+        /// and statesToUpdate_.
+        boost::mutex statisticsMutex_;
+
+        /// Workers of the parallel extension. NULL if there is only one
+        /// thread.
+        ThreadPoolPtr_t threadPool_;
+
         mutable Configuration_t qProj_;
+
+        std::size_t seed_;
+        /// Index of the current step, used to derive the seeds of the
+        /// extensions.
+        std::size_t step_;
+        /// Generator of the extensions done outside of oneStep.
+        RandomGenerator_t rng_;
+        value_type timeBudget_;
+        /// Deadline of the running solve, not_a_date_time if none.
+        boost::posix_time::ptime deadline_;
+
+        std::size_t maxConnectionsPerComponent_;
+        value_type connectionRadius_;
+        std::size_t connectionBudget_;
+        bool lazyConnection_;
+        LazyEdges_t lazyEdges_;
+        std::size_t maxLazyEdges_;
+        /// Whether lazy edges or query nodes were added since the last
+        /// search of a candidate solution.
+        bool lazySearchNeeded_;
+        /// Number of edges of the roadmap at the last search.
+        std::size_t lazySearchEdges_;
+        /// Roadmap::clearCount when the lazy edges were checked.
+        std::size_t roadmapClears_;
+
+        bool measureLatencies_;
+        /// Durations recorded by the threads, indexed by thread slot and
+        /// filled by initializeThreads.
+        std::vector < ThreadLatenciesPtr_t > threadLatencies_;
+        /// Durations recorded by the threads without slot in
+        /// threadLatencies_.
+        ThreadLatenciesPtr_t otherLatencies_;
+
+        PathValidationFactory_t pathValidationFactory_;
+        /// Path validations of the threads, indexed by thread slot. NULL
+        /// for the threads using the path validation of the problem.
+        std::vector < core::PathValidationPtr_t > pathValidations_;
+        /// Whether initializeThreads was called since the threads changed.
+        bool threadsInitialized_;
+
+        /// Workers of the pipelined extension. NULL if disabled.
+        /// The workers use the members above, so it is destroyed first.
+        struct Pipeline;
+        boost::shared_ptr < Pipeline > pipeline_;
     };
     /// \}
   } // namespace manipulation
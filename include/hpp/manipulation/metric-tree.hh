@@ -0,0 +1,152 @@
+// Copyright (c) 2015, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_METRIC_TREE_HH
+# define HPP_MANIPULATION_METRIC_TREE_HH
+
+# include <vector>
+
+# include <hpp/core/node.hh>
+
+# include "hpp/manipulation/config.hh"
+# include "hpp/manipulation/fwd.hh"
+
+namespace hpp {
+  namespace manipulation {
+    /// \addtogroup roadmap
+    /// \{
+
+    /// Nearest neighbor index of roadmap nodes.
+    ///
+    /// The nodes are stored in vantage point trees, which only rely on the
+    /// triangle inequality of the distance. Unlike a k-d tree, they do not
+    /// need the distance to be bounded by differences of coordinates,
+    /// which does not hold for the joints whose configuration space wraps
+    /// around.
+    ///
+    /// Nodes are inserted with the logarithmic method: the index keeps
+    /// trees of \f$2^i\f$ nodes, and an insertion rebuilds the trees
+    /// smaller than the first empty one into it. Queries search every
+    /// tree.
+    /// \note The queries are const and can be run concurrently, but not
+    ///       during an insertion.
+    class HPP_MANIPULATION_DLLAPI MetricTree
+    {
+      public:
+        /// Nodes and their distances, in a heap whose top is the
+        /// farthest node.
+        typedef std::vector < std::pair < value_type, core::NodePtr_t > >
+          Neighbors_t;
+
+        explicit MetricTree (const core::DistancePtr_t& distance =
+            core::DistancePtr_t ());
+
+        /// Insert a node.
+        void insert (const core::NodePtr_t& node);
+
+        /// Insert the nodes of another index.
+        void merge (const MetricTree& other);
+
+        /// Remove all the nodes.
+        void clear ();
+
+        /// Number of nodes.
+        std::size_t size () const
+        {
+          return size_;
+        }
+
+        bool empty () const
+        {
+          return size_ == 0;
+        }
+
+        /// First inserted node. Not modified by merge.
+        const core::NodePtr_t& front () const
+        {
+          return front_;
+        }
+
+        /// Nodes, in no particular order.
+        core::Nodes_t nodes () const;
+
+        /// Find a node closer than minDistance to a configuration.
+        /// \retval nearest the nearest node, if closer than minDistance.
+        ///         Not modified otherwise.
+        /// \retval minDistance the distance to nearest.
+        void nearest (ConfigurationIn_t configuration,
+            core::NodePtr_t& nearest, value_type& minDistance) const;
+
+        /// Find the nearest nodes within a radius of a configuration.
+        ///
+        /// The subtrees farther than the radius, or than the k-th node
+        /// found so far, are skipped.
+        /// \param k maximal number of nodes in neighbors, 0 for no limit.
+        /// \param radius maximal distance to the nodes.
+        /// \retval neighbors the k nearest nodes among the ones found and
+        ///         the ones it already contained, so that it can be shared
+        ///         by several indexes to search their union.
+        void nearest (ConfigurationIn_t configuration, const std::size_t& k,
+            const value_type& radius, Neighbors_t& neighbors) const;
+
+        /// Add a node to neighbors if it is among the k nearest.
+        /// \param k maximal number of nodes in neighbors, 0 for no limit.
+        static void keep (Neighbors_t& neighbors, const std::size_t& k,
+            const value_type& distance, const core::NodePtr_t& node);
+
+        const core::DistancePtr_t& distance () const
+        {
+          return distance_;
+        }
+
+      private:
+        /// Node of a tree. The nodes of the subtree of the item at position
+        /// i of a tree are at positions i+1 to j. The first half of them
+        /// are at a distance lower than or equal to threshold of the
+        /// node, the other half at a distance greater than or equal to it.
+        struct Item {
+          core::NodePtr_t node;
+          value_type threshold;
+        };
+        typedef std::vector < Item > Tree_t;
+
+        value_type distance (const core::NodePtr_t& node,
+            ConfigurationIn_t configuration) const;
+
+        /// Build the subtree of the items between begin and end.
+        void build (Tree_t& tree, const std::size_t& begin,
+            const std::size_t& end) const;
+
+        void search (const Tree_t& tree, const std::size_t& begin,
+            const std::size_t& end, ConfigurationIn_t configuration,
+            core::NodePtr_t& nearest, value_type& minDistance) const;
+
+        void search (const Tree_t& tree, const std::size_t& begin,
+            const std::size_t& end, ConfigurationIn_t configuration,
+            const std::size_t& k, const value_type& radius,
+            Neighbors_t& neighbors) const;
+
+        core::DistancePtr_t distance_;
+        /// Trees of the logarithmic method. Tree i has 0 or 2^i nodes.
+        std::vector < Tree_t > trees_;
+        std::size_t size_;
+        core::NodePtr_t front_;
+    };
+    /// \}
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_METRIC_TREE_HH
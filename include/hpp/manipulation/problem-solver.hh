@@ -41,7 +41,8 @@ namespace hpp {
         {}
 
         ProblemSolver () :
-          core::ProblemSolver (), robot_ (), problem_ (0x0), graspsMap_()
+          core::ProblemSolver (), robot_ (), problem_ (0x0), graspsMap_(),
+          multiQuery_ (false), roadmapGraph_ (), roadmapValidation_ ()
         {
         }
 
@@ -109,8 +110,37 @@ namespace hpp {
         virtual void resetProblem ();
 
         /// Create a new Roadmap
+        ///
+        /// In multi-query mode, the current roadmap is kept if it was
+        /// created with the current constraint graph and path validation,
+        /// and only its goal nodes are removed.
         virtual void resetRoadmap ();
 
+        /// \name Multi-query
+        /// \{
+
+        /// Keep the roadmap, its histograms and its connected components
+        /// from one query to the next.
+        ///
+        /// The init and goal nodes of the next query are connected to the
+        /// roadmap by ManipulationPlanner::startSolve. The roadmap is
+        /// dropped when the constraint graph or the path validation of the
+        /// problem is replaced. Disabled by default.
+        /// \note The edges of the roadmap are not validated again, so the
+        ///       environment must be static: obstacles must not be added or
+        ///       moved between the queries.
+        void multiQuery (const bool& enable)
+        {
+          multiQuery_ = enable;
+        }
+
+        /// Whether the roadmap is kept from one query to the next.
+        bool multiQuery () const
+        {
+          return multiQuery_;
+        }
+        /// \}
+
         /// Get pointer to problem
         ProblemPtr_t problem () const
         {
@@ -148,6 +178,13 @@ namespace hpp {
         graph::GraphPtr_t constraintGraph_;
 
         GraspsMap_t graspsMap_;
+
+        /// Whether resetRoadmap keeps the current roadmap.
+        bool multiQuery_;
+        /// Constraint graph and path validation of the problem when the
+        /// roadmap was created.
+        graph::GraphPtr_t roadmapGraph_;
+        core::PathValidationPtr_t roadmapValidation_;
     }; // class ProblemSolver
   } // namespace manipulation
 } // namespace hpp
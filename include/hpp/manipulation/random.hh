@@ -0,0 +1,70 @@
+// Copyright (c) 2015, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_RANDOM_HH
+# define HPP_MANIPULATION_RANDOM_HH
+
+# include <boost/functional/hash.hpp>
+# include <boost/random/mersenne_twister.hpp>
+# include <boost/random/uniform_01.hpp>
+# include <boost/random/uniform_int_distribution.hpp>
+
+# include "hpp/manipulation/config.hh"
+# include "hpp/manipulation/fwd.hh"
+
+namespace hpp {
+  namespace manipulation {
+    /// \addtogroup path_planning
+    /// \{
+
+    /// Random number generator of the planner.
+    ///
+    /// Each task of the planner, such as the extension of a connected
+    /// component, draws from its own generator, seeded by deriveSeed. The
+    /// numbers drawn do not depend on the thread executing the task.
+    typedef boost::random::mt19937 RandomGenerator_t;
+
+    /// Seed of the generator of a task.
+    /// \param seed the seed of the planner,
+    /// \param step, task indexes of the task.
+    inline RandomGenerator_t::result_type deriveSeed (const std::size_t& seed,
+        const std::size_t& step, const std::size_t& task)
+    {
+      std::size_t h = seed;
+      boost::hash_combine (h, step);
+      boost::hash_combine (h, task);
+      return (RandomGenerator_t::result_type) h;
+    }
+
+    /// Draw a number uniformly in [0, 1[.
+    inline value_type uniform01 (RandomGenerator_t& rng)
+    {
+      return boost::random::uniform_01 < value_type > () (rng);
+    }
+
+    /// Draw an integer uniformly in [0, n[.
+    /// \pre n > 0
+    inline std::size_t uniformIndex (RandomGenerator_t& rng,
+        const std::size_t& n)
+    {
+      return boost::random::uniform_int_distribution < std::size_t >
+        (0, n - 1) (rng);
+    }
+    /// \}
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_RANDOM_HH
@@ -0,0 +1,226 @@
+// Copyright (c) 2015, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_ROADMAP_NODE_HH
+# define HPP_MANIPULATION_ROADMAP_NODE_HH
+
+# include <cassert>
+# include <vector>
+# include <stdexcept>
+# include <boost/cstdint.hpp>
+# include <boost/iterator/iterator_adaptor.hpp>
+
+# include <hpp/core/node.hh>
+
+# include "hpp/manipulation/config.hh"
+# include "hpp/manipulation/fwd.hh"
+# include "hpp/manipulation/graph/fwd.hh"
+
+namespace hpp {
+  namespace manipulation {
+    /// \addtogroup roadmap
+    /// \{
+
+    /// Node of a Roadmap that stores the state of the constraint graph
+    /// its configuration lies in.
+    ///
+    /// The state is computed once, when the node is inserted in the
+    /// Roadmap, and reused by the planner, the steering method and the
+    /// statistics.
+    class HPP_MANIPULATION_DLLAPI RoadmapNode : public core::Node
+    {
+      public:
+        /// Constructor
+        RoadmapNode (const ConfigurationPtr_t& configuration) :
+          core::Node (configuration), cacheUpToDate_ (false), graphNode_ (),
+          index_ (0)
+        {}
+
+        /// Index of the node in the RoadmapNodeArena of its roadmap.
+        boost::uint32_t index () const
+        {
+          return index_;
+        }
+
+        /// Set the index of the node in the RoadmapNodeArena.
+        void index (const boost::uint32_t& i)
+        {
+          index_ = i;
+        }
+
+        /// \name Cache
+        /// \{
+
+        /// Whether the cached state is valid.
+        bool cacheUpToDate () const
+        {
+          return cacheUpToDate_;
+        }
+
+        /// Get the cached state.
+        const graph::NodePtr_t& graphNode () const
+        {
+          return graphNode_;
+        }
+
+        /// Set the cached state.
+        void graphNode (const graph::NodePtr_t& node)
+        {
+          graphNode_ = node;
+          cacheUpToDate_ = true;
+        }
+
+        /// Invalidate the cached state.
+        void resetCache ()
+        {
+          graphNode_.reset ();
+          cacheUpToDate_ = false;
+        }
+        /// \}
+
+      private:
+        bool cacheUpToDate_;
+        graph::NodePtr_t graphNode_;
+        boost::uint32_t index_;
+    };
+
+    /// Nodes of a Roadmap, indexed by 32 bits integers.
+    ///
+    /// The histograms of the roadmap store the indexes of their nodes in
+    /// contiguous vectors rather than lists of pointers.
+    class HPP_MANIPULATION_DLLAPI RoadmapNodeArena
+    {
+      public:
+        typedef boost::uint32_t Index_t;
+        typedef std::vector < Index_t > Indexes_t;
+
+        /// Iterator over the nodes of a vector of indexes.
+        class const_iterator : public boost::iterator_adaptor < const_iterator,
+          Indexes_t::const_iterator, const core::NodePtr_t,
+          boost::use_default, const core::NodePtr_t& >
+        {
+          public:
+            const_iterator () : arena_ (NULL) {}
+
+            const_iterator (const Indexes_t::const_iterator& it,
+                const RoadmapNodeArena* arena) :
+              const_iterator::iterator_adaptor_ (it), arena_ (arena)
+            {}
+
+          private:
+            friend class boost::iterator_core_access;
+
+            const core::NodePtr_t& dereference () const
+            {
+              return (*arena_) [*this->base_reference ()];
+            }
+
+            const RoadmapNodeArena* arena_;
+        };
+
+        /// Nodes of a vector of indexes.
+        class Range
+        {
+          public:
+            typedef RoadmapNodeArena::const_iterator const_iterator;
+
+            Range (const Indexes_t& indexes, const RoadmapNodeArena* arena) :
+              indexes_ (&indexes), arena_ (arena)
+            {}
+
+            const_iterator begin () const
+            {
+              return const_iterator (indexes_->begin (), arena_);
+            }
+
+            const_iterator end () const
+            {
+              return const_iterator (indexes_->end (), arena_);
+            }
+
+            std::size_t size () const
+            {
+              return indexes_->size ();
+            }
+
+            bool empty () const
+            {
+              return indexes_->empty ();
+            }
+
+            const core::NodePtr_t& front () const
+            {
+              return (*arena_) [indexes_->front ()];
+            }
+
+          private:
+            const Indexes_t* indexes_;
+            const RoadmapNodeArena* arena_;
+        };
+
+        static RoadmapNodeArenaPtr_t create ()
+        {
+          return RoadmapNodeArenaPtr_t (new RoadmapNodeArena);
+        }
+
+        /// Insert a node and set its index.
+        /// \throw std::overflow_error if the arena is full.
+        Index_t push_back (const RoadmapNodePtr_t& node)
+        {
+          if (nodes_.size () > (std::size_t) Index_t (-1))
+            throw std::overflow_error ("Too many nodes in RoadmapNodeArena");
+          const Index_t i = (Index_t) nodes_.size ();
+          nodes_.push_back (node);
+          node->index (i);
+          return i;
+        }
+
+        const core::NodePtr_t& operator[] (const Index_t& i) const
+        {
+          return nodes_ [i];
+        }
+
+        std::size_t size () const
+        {
+          return nodes_.size ();
+        }
+
+        void clear ()
+        {
+          nodes_.clear ();
+        }
+
+      protected:
+        RoadmapNodeArena () : nodes_ () {}
+
+      private:
+        std::vector < core::NodePtr_t > nodes_;
+    };
+
+    /// Get the RoadmapNode of a node of a Roadmap.
+    /// The nodes of a Roadmap are created by Roadmap::createNode, which
+    /// hpp-core calls for every node it creates.
+    inline RoadmapNodePtr_t roadmapNode (const core::NodePtr_t& node)
+    {
+      RoadmapNodePtr_t n = dynamic_cast <RoadmapNodePtr_t> (node);
+      assert (n && "The node was not created by Roadmap::createNode");
+      return n;
+    }
+    /// \}
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_ROADMAP_NODE_HH
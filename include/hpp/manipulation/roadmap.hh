@@ -17,10 +17,18 @@
 #ifndef HPP_MANIPULATION_ROADMAP_HH
 # define HPP_MANIPULATION_ROADMAP_HH
 
+# include <map>
+# include <string>
+# include <boost/thread/thread.hpp>
+# include <boost/thread/mutex.hpp>
+# include <boost/thread/condition_variable.hpp>
+# include <boost/lockfree/spsc_queue.hpp>
+
 # include <hpp/core/roadmap.hh>
 # include <hpp/core/constraint-set.hh>
 
 # include "hpp/manipulation/fwd.hh"
+# include "hpp/manipulation/metric-tree.hh"
 # include "hpp/manipulation/graph/statistics.hh"
 
 namespace hpp {
@@ -39,7 +47,9 @@ namespace hpp {
         static RoadmapPtr_t create (const core::DistancePtr_t& distance, const core::DevicePtr_t& robot);
 
         /// Register histogram so that each time a node is added to the roadmap,
-        /// it is also added to the histogram
+        /// it is also added to the histogram.
+        /// The histogram stores its nodes in the RoadmapNodeArena of the
+        /// roadmap.
         void insertHistogram (const graph::HistogramPtr_t hist);
 
         /// Register the constraint graph to do statistics.
@@ -48,21 +58,232 @@ namespace hpp {
         /// Clear the histograms and call parent implementation.
         void clear ();
 
+        /// Number of calls to clear.
+        /// The objects keeping pointers to the nodes compare it with the
+        /// value they read before, to know whether the nodes were deleted.
+        const std::size_t& clearCount () const
+        {
+          return clearCount_;
+        }
+
         /// Catch event 'New node added'
         void push_node (const core::NodePtr_t& n);
 
+        /// \name Asynchronous statistics
+        /// \{
+
+        /// Insert the nodes in the histograms in a background thread.
+        ///
+        /// When enabled, push_node only queues the node. The background
+        /// thread classifies it with graph::Histogram::classifier, on its
+        /// own copy of the robot, then inserts it in the histograms, which
+        /// are therefore not up to date. Call sync before reading them.
+        /// Disabled by default.
+        /// \note push_node and sync must be called by the same thread.
+        /// \throw std::logic_error if a histogram cannot create a
+        ///        classifier, e.g. a graph::LeafHistogram whose foliation was
+        ///        set without factories. insertHistogram throws likewise
+        ///        while enabled.
+        void asynchronousStatistics (const bool& enable);
+
+        /// Whether the histograms are filled in a background thread.
+        bool asynchronousStatistics () const
+        {
+          return (bool) statThread_;
+        }
+
+        /// Wait until the queued nodes are inserted in the histograms.
+        /// Returns immediately if the statistics are synchronous.
+        void sync ();
+        /// \}
+
+        /// \name Persistence
+        /// \{
+
+        /// Save the nodes and the edges of the roadmap in a binary file.
+        ///
+        /// The file contains the configurations of the nodes in a
+        /// contiguous block, the state of each node and, for each edge,
+        /// its end nodes, the edge of the constraint graph that built its
+        /// path and the direction in which it was built. States and edges
+        /// of the constraint graph are stored by name. Paths are not
+        /// stored. Data is written in the native byte order.
+        /// \throw std::runtime_error if the constraint graph is not set, if
+        ///        the path of an edge was not built by an edge of the
+        ///        constraint graph or if the file cannot be written.
+        void save (const std::string& filename) const;
+
+        /// Add the nodes and the edges saved in a file to the roadmap.
+        ///
+        /// The file is mapped in memory. The states of the nodes are read
+        /// from the file, unless the constraint graph has no state of that
+        /// name, and the histograms are filled as the nodes are inserted.
+        /// The path of each edge is rebuilt between the saved
+        /// configurations by the steering method of the edge of the
+        /// constraint graph that built it, in the same direction, so that
+        /// loading does not plan again. Mapping the file only saves the
+        /// parsing: the configurations are copied in the roadmap and all
+        /// the paths are rebuilt by this call, so its time is linear in the
+        /// size of the roadmap.
+        /// \param validation if set, the rebuilt paths are validated. If
+        ///        not, they are trusted, which assumes that neither the
+        ///        environment nor the constraint graph changed since the
+        ///        roadmap was saved. Validating is much slower than
+        ///        rebuilding.
+        /// \param projector if set, the rebuilt paths are projected.
+        /// \throw std::runtime_error if the constraint graph is not set, if
+        ///        the file is not a roadmap of the robot and its constraint
+        ///        graph or if a path cannot be rebuilt, fully projected or
+        ///        fully validated. The roadmap is not modified then.
+        void load (const std::string& filename,
+            const core::PathValidationPtr_t& validation =
+            core::PathValidationPtr_t (),
+            const PathProjectorPtr_t& projector =
+            PathProjectorPtr_t ());
+        /// \}
+
+        /// Get the nearest neighbor in a connected component, among the
+        /// nodes lying in a state of the constraint graph.
+        /// \param configuration the configuration,
+        /// \param connectedComponent the connected component,
+        /// \param state the state of the constraint graph,
+        /// \retval minDistance the distance to the returned node.
+        /// \return the nearest node or NULL if none of the nodes of the
+        ///         connected component lies in state.
+        /// \note If the constraint graph is not set, the nodes are not
+        ///       sorted by state and the nearest node of the connected
+        ///       component is returned.
+        core::NodePtr_t nearestNode (const ConfigurationPtr_t& configuration,
+            const ConnectedComponentPtr_t& connectedComponent,
+            const graph::NodePtr_t& state, value_type& minDistance) const;
+
+        /// Get the nearest neighbor in a connected component, among the
+        /// nodes lying in a set of states of the constraint graph.
+        /// \sa nearestNode (const ConfigurationPtr_t&,
+        ///     const ConnectedComponentPtr_t&, const graph::NodePtr_t&,
+        ///     value_type&) const
+        core::NodePtr_t nearestNode (const ConfigurationPtr_t& configuration,
+            const ConnectedComponentPtr_t& connectedComponent,
+            const graph::Nodes_t& states, value_type& minDistance) const;
+
+        /// Get the nearest neighbors in a connected component, among the
+        /// nodes lying in a set of states of the constraint graph.
+        /// \param configuration the configuration,
+        /// \param connectedComponent the connected component,
+        /// \param states the states of the constraint graph,
+        /// \param k maximal number of returned nodes, 0 for no limit,
+        /// \param radius maximal distance to the returned nodes. The
+        ///        indexes of the buckets skip the nodes beyond it without
+        ///        computing their distance.
+        /// \return the nodes sorted by increasing distance.
+        /// \note If the constraint graph is not set, all the nodes of the
+        ///       connected component are candidates.
+        core::Nodes_t nearestNodes (const ConfigurationPtr_t& configuration,
+            const ConnectedComponentPtr_t& connectedComponent,
+            const graph::Nodes_t& states, const std::size_t& k,
+            const value_type& radius) const;
+
+        /// Get the states of the constraint graph containing at least one
+        /// node of the roadmap.
+        graph::Nodes_t states () const;
+
       protected:
+        /// Node waiting to be inserted in the histograms, with the values
+        /// computed by graph::Histogram::classify, in the order of the
+        /// histograms.
+        struct StatisticsJob {
+          core::NodePtr_t node;
+          std::vector < bool > added;
+          std::vector < vector_t > values;
+        };
+
+        /// Classify a node for the histograms.
+        void statClassify (const core::NodePtr_t& n, StatisticsJob& job) const;
+
         /// Register a new configuration.
-        void statInsert (const core::NodePtr_t& n);
+        void statInsert (const StatisticsJob& job);
+
+        /// Create a RoadmapNode.
+        /// The state of the node is computed when it is inserted.
+        virtual core::NodePtr_t createNode
+          (const ConfigurationPtr_t& configuration) const;
 
         /// Constructor
         Roadmap (const core::DistancePtr_t& distance, const core::DevicePtr_t& robot);
 
+      public:
+        /// Stop the statistics thread.
+        virtual ~Roadmap ();
+
       private:
+        /// Main loop of the statistics thread.
+        void processStatistics ();
+
+        /// Create the classifiers of the histograms on statRobot_, or
+        /// clear them if the statistics are synchronous.
+        void statCreateClassifiers ();
+
+        /// Nodes waiting to be inserted in the histograms.
+        typedef boost::lockfree::spsc_queue < StatisticsJob* >
+          StatisticsQueue_t;
+        StatisticsQueue_t statQueue_;
+        boost::shared_ptr < boost::thread > statThread_;
+        /// Number of queued nodes, only accessed by the thread calling
+        /// push_node.
+        std::size_t statPushed_;
+        /// Protect statProcessed_ and statStop_.
+        boost::mutex statMutex_;
+        boost::condition_variable statAvailable_, statDone_;
+        std::size_t statProcessed_;
+        bool statStop_;
+
+        typedef std::vector < graph::Histogram::Classifier_t > Classifiers_t;
+        core::DevicePtr_t robot_;
+        /// Copy of the robot used by the statistics thread, if any.
+        core::DevicePtr_t statRobot_;
+        /// Classifiers of the histograms on statRobot_, in the order of
+        /// the histograms.
+        Classifiers_t statClassifiers_;
+
         typedef std::list < graph::HistogramPtr_t > Histograms;
+        /// Nodes of the roadmap referenced by the histograms.
+        RoadmapNodeArenaPtr_t nodeArena_;
         /// Keep track of the leaf that are explored.
         /// There should be one histogram per foliation.
         Histograms histograms_;
+
+        /// Roadmap nodes of one state, sorted by connected component, each
+        /// bucket being indexed by a MetricTree.
+        ///
+        /// The roadmap does not notify merges of connected components. A
+        /// bucket is therefore indexed by the connected component of its
+        /// nodes at insertion time, which remains valid until a merge.
+        /// After a merge, all the nodes of a bucket are still in the same
+        /// connected component, the one of their first node. Such buckets are
+        /// filtered out by queries and merged into the right one by
+        /// push_node.
+        typedef std::map < ConnectedComponentPtr_t, MetricTree >
+          ConnectedComponentBuckets_t;
+        typedef std::map < graph::NodePtr_t, ConnectedComponentBuckets_t >
+          StateIndex_t;
+
+        /// Merge the buckets whose connected component was merged.
+        static void updateBuckets (ConnectedComponentBuckets_t& buckets);
+
+        /// Insert a node in the bucket of its state and connected
+        /// component.
+        void addToIndex (const core::NodePtr_t& node,
+            const graph::NodePtr_t& state);
+
+        /// The constraint graph used to sort the nodes.
+        graph::GraphPtr_t graph_;
+        /// State of the node inserted by load, if known.
+        graph::NodePtr_t loadedState_;
+        /// Distance used by the nearest neighbor queries.
+        core::DistancePtr_t distance_;
+        /// Roadmap nodes sorted by state and connected component.
+        StateIndex_t stateIndex_;
+        std::size_t clearCount_;
     };
     /// \}
   } // namespace manipulation
@@ -0,0 +1,67 @@
+// Copyright (c) 2015, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_SEEDED_CONFIGURATION_SHOOTER_HH
+# define HPP_MANIPULATION_SEEDED_CONFIGURATION_SHOOTER_HH
+
+# include <hpp/core/configuration-shooter.hh>
+
+# include "hpp/manipulation/config.hh"
+# include "hpp/manipulation/fwd.hh"
+# include "hpp/manipulation/random.hh"
+
+namespace hpp {
+  namespace manipulation {
+    /// \addtogroup path_planning
+    /// \{
+
+    /// Uniform configuration shooter drawing from its own generator.
+    ///
+    /// It samples the configurations as core::BasicConfigurationShooter
+    /// does, which draws from std::rand, so that the configurations only
+    /// depend on the seed of the shooter.
+    /// \note shoot is not thread safe.
+    class HPP_MANIPULATION_DLLAPI SeededConfigurationShooter :
+      public core::ConfigurationShooter
+    {
+      public:
+        static SeededConfigurationShooterPtr_t create
+          (const core::DevicePtr_t& robot);
+
+        /// Restart the sequence of configurations.
+        void seed (const RandomGenerator_t::result_type& s)
+        {
+          rng_.seed (s);
+        }
+
+        /// Shoot a configuration uniformly in the bounds of the joints and
+        /// of the extra configuration space.
+        /// \throw std::runtime_error if a translation or an extra
+        ///        configuration variable is not bounded.
+        virtual ConfigurationPtr_t shoot () const;
+
+      protected:
+        SeededConfigurationShooter (const core::DevicePtr_t& robot);
+
+      private:
+        core::DevicePtr_t robot_;
+        mutable RandomGenerator_t rng_;
+    };
+    /// \}
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_SEEDED_CONFIGURATION_SHOOTER_HH
@@ -0,0 +1,105 @@
+// Copyright (c) 2015, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_THREAD_POOL_HH
+# define HPP_MANIPULATION_THREAD_POOL_HH
+
+# include <string>
+# include <vector>
+# include <boost/function.hpp>
+# include <boost/thread/thread.hpp>
+# include <boost/thread/mutex.hpp>
+# include <boost/thread/condition_variable.hpp>
+
+# include "hpp/manipulation/config.hh"
+# include "hpp/manipulation/fwd.hh"
+
+namespace hpp {
+  namespace manipulation {
+    /// \addtogroup path_planning
+    /// \{
+
+    /// Fixed set of worker threads executing indexed tasks.
+    ///
+    /// The threads are created once, by the constructor, and wait for work
+    /// between two calls to run. Keeping the same threads alive matters
+    /// because some objects keep one instance of their buffers per thread.
+    class HPP_MANIPULATION_DLLAPI ThreadPool
+    {
+      public:
+        /// Function called by the workers with the index of the task.
+        typedef boost::function < void (const std::size_t&) > Task_t;
+
+        /// Create a pool of nbThreads workers.
+        /// \param nbThreads number of workers. If 0, run executes the tasks
+        ///        in the calling thread.
+        static ThreadPoolPtr_t create (const std::size_t& nbThreads);
+
+        /// Stop and join the workers.
+        ~ThreadPool ();
+
+        /// Number of workers.
+        std::size_t size () const;
+
+        /// Index of the calling thread.
+        ///
+        /// Indices are assigned on the first call of each thread. A thread
+        /// gets the smallest index released by the threads that exited, or
+        /// else a new one, starting from 0, so that the indices stay lower
+        /// than the largest number of threads alive at the same time.
+        /// They are meant to select the instance of a per thread buffer.
+        static std::size_t threadSlot ();
+
+        /// Slots of the workers.
+        const std::vector < std::size_t >& slots () const
+        {
+          return slots_;
+        }
+
+        /// Call task (i) for every i in [0, nbTasks[ and wait until all
+        /// the calls return.
+        /// \note The order in which the tasks are executed is not specified.
+        /// \throw std::runtime_error if a task threw an exception. The
+        ///        message is the one of the first exception caught.
+        void run (const std::size_t& nbTasks, const Task_t& task);
+
+      protected:
+        /// Constructor
+        ThreadPool (const std::size_t& nbThreads);
+
+      private:
+        /// Main loop of the workers.
+        void work ();
+
+        boost::thread_group threads_;
+        /// Slots of the workers, set when they start.
+        std::vector < std::size_t > slots_;
+        /// Serialize the calls to run.
+        boost::mutex runMutex_;
+        /// Protect all the members below.
+        boost::mutex mutex_;
+        boost::condition_variable workAvailable_, workDone_;
+
+        const Task_t* task_;
+        std::size_t nbTasks_, nextTask_, nbDone_;
+        std::string error_;
+        bool stop_;
+    }; // class ThreadPool
+    /// \}
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_THREAD_POOL_HH
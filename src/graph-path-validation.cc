@@ -103,21 +103,25 @@ namespace hpp {
       const Path& oldPath (*path);
       const core::interval_t& newTR = newPath.timeRange (),
                               oldTR = oldPath.timeRange ();
-      Configuration_t q (newPath.outputSize());
+      // The valid part usually shares one of its end with the path. The
+      // state of such an end is computed only once.
+      Configuration_t q (newPath.outputSize()), qOld (oldPath.outputSize());
       if (!newPath (q, newTR.first))
         throw std::logic_error ("Initial configuration of the valid part cannot be projected.");
-      const graph::NodePtr_t& origNode = constraintGraph_->getNode (q);
-      if (!newPath (q, newTR.second))
-        throw std::logic_error ("End configuration of the valid part cannot be projected.");
-      const graph::NodePtr_t& destNode = constraintGraph_->getNode (q);
-      if (!oldPath (q, oldTR.first))
+      if (!oldPath (qOld, oldTR.first))
         throw std::logic_error ("Initial configuration of the path to be validated cannot be projected.");
-      const graph::NodePtr_t& oldOnode = constraintGraph_->getNode (q);
-      if (!oldPath (q, oldTR.second))
-        throw std::logic_error ("End configuration of the path to be validated cannot be projected.");
-      const graph::NodePtr_t& oldDnode = constraintGraph_->getNode (q);
+      const graph::NodePtr_t oldOnode = constraintGraph_->getNode (qOld);
+      bool sameStates = (q == qOld || constraintGraph_->getNode (q) == oldOnode);
+      if (sameStates) {
+        if (!newPath (q, newTR.second))
+          throw std::logic_error ("End configuration of the valid part cannot be projected.");
+        if (!oldPath (qOld, oldTR.second))
+          throw std::logic_error ("End configuration of the path to be validated cannot be projected.");
+        const graph::NodePtr_t oldDnode = constraintGraph_->getNode (qOld);
+        sameStates = (q == qOld || constraintGraph_->getNode (q) == oldDnode);
+      }
 
-      if (origNode == oldOnode && destNode == oldDnode) {
+      if (sameStates) {
         validPart = pathNoCollision;
         return false;
       }
@@ -55,13 +55,22 @@ namespace hpp {
 
     PathPtr_t GraphSteeringMethod::impl_compute (ConfigurationIn_t q1, ConfigurationIn_t q2) const
     {
-      graph::Edges_t possibleEdges;
+      graph::NodePtr_t n1, n2;
       try {
-        possibleEdges = graph_->getEdges (graph_->getNode (q1), graph_->getNode (q2));
+        n1 = graph_->getNode (q1);
+        n2 = graph_->getNode (q2);
       } catch (const std::logic_error& e) {
         hppDout (error, e.what ());
         return PathPtr_t ();
       }
+      return compute (q1, n1, q2, n2);
+    }
+
+    PathPtr_t GraphSteeringMethod::compute
+    (ConfigurationIn_t q1, const graph::NodePtr_t& n1,
+     ConfigurationIn_t q2, const graph::NodePtr_t& n2) const
+    {
+      graph::Edges_t possibleEdges (graph_->getEdges (n1, n2));
       PathPtr_t path;
       while (!possibleEdges.empty()) {
         if (possibleEdges.back ()->build (path, q1, q2, *distance_)) {
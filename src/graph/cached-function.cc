@@ -0,0 +1,73 @@
+// Copyright (c) 2015, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#include "hpp/manipulation/graph/cached-function.hh"
+
+namespace hpp {
+  namespace manipulation {
+    namespace graph {
+      CachedFunctionPtr_t CachedFunction::create
+      (const DifferentiableFunctionPtr_t& function,
+       const std::size_t& nbSlots)
+      {
+        return CachedFunctionPtr_t (new CachedFunction (function, nbSlots));
+      }
+
+      CachedFunction::CachedFunction
+      (const DifferentiableFunctionPtr_t& function,
+       const std::size_t& nbSlots) :
+        DifferentiableFunction (function->inputSize (),
+            function->inputDerivativeSize (), function->outputSize (),
+            function->name ()),
+        function_ (function), results_ ()
+      {
+        // Size the storage now, so that the threads never make it grow.
+        if (nbSlots > 0) results_.at (nbSlots - 1);
+      }
+
+      void CachedFunction::fixSlots (const std::size_t& nbSlots) const
+      {
+        results_.fix (nbSlots);
+      }
+
+      void CachedFunction::impl_compute (constraints::vectorOut_t result,
+          ConfigurationIn_t argument) const
+      {
+        Results& r = results_.local ();
+        if (!r.hasValue || r.valueArgument != argument) {
+          r.value.resize (outputSize ());
+          (*function_) (r.value, argument);
+          r.valueArgument = argument;
+          r.hasValue = true;
+        }
+        result = r.value;
+      }
+
+      void CachedFunction::impl_jacobian (constraints::matrixOut_t jacobian,
+          ConfigurationIn_t argument) const
+      {
+        Results& r = results_.local ();
+        if (!r.hasJacobian || r.jacobianArgument != argument) {
+          r.jacobian.resize (outputSize (), inputDerivativeSize ());
+          function_->jacobian (r.jacobian, argument);
+          r.jacobianArgument = argument;
+          r.hasJacobian = true;
+        }
+        jacobian = r.jacobian;
+      }
+    } // namespace graph
+  } // namespace manipulation
+} // namespace hpp
@@ -34,6 +34,7 @@ namespace hpp {
       Edge::Edge (const std::string& name,
 		  const core::SteeringMethodPtr_t& steeringMethod) :
 	GraphComponent (name), pathConstraints_ (new Constraint_t()),
+	steeringMethods_ (new SteeringMethod_t()),
 	configConstraints_ (new Constraint_t()),
 	steeringMethod_ (steeringMethod->copy ())
       {}
@@ -41,6 +42,7 @@ namespace hpp {
       Edge::~Edge ()
       {
         if (pathConstraints_  ) delete pathConstraints_;
+        if (steeringMethods_  ) delete steeringMethods_;
         if (configConstraints_) delete configConstraints_;
       }
 
@@ -105,56 +107,101 @@ namespace hpp {
       ConstraintSetPtr_t Edge::configConstraint() const
       {
         if (!*configConstraints_) {
-          configConstraints_->set (buildConfigConstraint ());
+          configConstraints_->set
+            (buildConfigConstraint (ThreadPool::threadSlot ()));
         }
         return configConstraints_->get ();
       }
 
-      ConstraintSetPtr_t Edge::buildConfigConstraint() const
+      ConstraintSetPtr_t Edge::buildConfigConstraint
+      (const std::size_t& slot) const
       {
         std::string n = "(" + name () + ")";
         GraphPtr_t g = graph_.lock ();
+        const core::DevicePtr_t robot = g->robot (slot);
 
-        ConstraintSetPtr_t constraint = ConstraintSet::create (g->robot (), "Set " + n);
+        ConstraintSetPtr_t constraint = ConstraintSet::create (robot, "Set " + n);
 
-        ConfigProjectorPtr_t proj = ConfigProjector::create(g->robot(), "proj_" + n, g->errorThreshold(), g->maxIterations());
-        g->insertNumericalConstraints (proj);
-        insertNumericalConstraints (proj);
-        to ()->insertNumericalConstraints (proj);
+        ConfigProjectorPtr_t proj = ConfigProjector::create(robot, "proj_" + n, g->errorThreshold(), g->maxIterations());
+        g->insertNumericalConstraints (proj, slot);
+        insertNumericalConstraints (proj, slot);
+        to ()->insertNumericalConstraints (proj, slot);
         constraint->addConstraint (proj);
 
-        g->insertLockedJoints (proj);
-        insertLockedJoints (proj);
-        to ()->insertLockedJoints (proj);
+        g->insertLockedJoints (proj, slot);
+        insertLockedJoints (proj, slot);
+        to ()->insertLockedJoints (proj, slot);
         return constraint;
       }
 
       ConstraintSetPtr_t Edge::pathConstraint() const
       {
         if (!*pathConstraints_) {
-	  ConstraintSetPtr_t pathConstraints (buildPathConstraint ());
-          pathConstraints_->set (pathConstraints);
-	  steeringMethod_->constraints (pathConstraints);
+          setPathConstraint (ThreadPool::threadSlot ());
         }
         return pathConstraints_->get ();
       }
 
-      ConstraintSetPtr_t Edge::buildPathConstraint() const
+      core::SteeringMethodPtr_t Edge::steeringMethod () const
+      {
+        if (!*pathConstraints_) {
+          setPathConstraint (ThreadPool::threadSlot ());
+        }
+        return steeringMethods_->get ();
+      }
+
+      void Edge::setPathConstraint (const std::size_t& slot) const
+      {
+        ConstraintSetPtr_t pathConstraints (buildPathConstraint (slot));
+        core::SteeringMethodPtr_t sm (steeringMethod_->copy ());
+        sm->constraints (pathConstraints);
+        pathConstraints_->set (slot, pathConstraints);
+        steeringMethods_->set (slot, sm);
+      }
+
+      void Edge::buildConstraints (const std::size_t& slot) const
+      {
+        if (!configConstraints_->isSet (slot))
+          configConstraints_->set (slot, buildConfigConstraint (slot));
+        if (!pathConstraints_->isSet (slot))
+          setPathConstraint (slot);
+      }
+
+      void Edge::instantiateConstraints (const std::size_t& slot,
+          const core::DevicePtr_t& robot) const
+      {
+        GraphComponent::instantiateConstraints (slot, robot);
+        configConstraints_->set (slot, ConstraintSetPtr_t ());
+        pathConstraints_->set (slot, ConstraintSetPtr_t ());
+        steeringMethods_->set (slot, core::SteeringMethodPtr_t ());
+      }
+
+      void Edge::fixSlots (const std::size_t& nbSlots) const
+      {
+        GraphComponent::fixSlots (nbSlots);
+        configConstraints_->fix (nbSlots);
+        pathConstraints_->fix (nbSlots);
+        steeringMethods_->fix (nbSlots);
+      }
+
+      ConstraintSetPtr_t Edge::buildPathConstraint
+      (const std::size_t& slot) const
       {
         std::string n = "(" + name () + ")";
         GraphPtr_t g = graph_.lock ();
+        const core::DevicePtr_t robot = g->robot (slot);
 
-        ConstraintSetPtr_t constraint = ConstraintSet::create (g->robot (), "Set " + n);
+        ConstraintSetPtr_t constraint = ConstraintSet::create (robot, "Set " + n);
 
-        ConfigProjectorPtr_t proj = ConfigProjector::create(g->robot(), "proj_" + n, g->errorThreshold(), g->maxIterations());
-        g->insertNumericalConstraints (proj);
-        insertNumericalConstraints (proj);
-        node ()->insertNumericalConstraintsForPath (proj);
+        ConfigProjectorPtr_t proj = ConfigProjector::create(robot, "proj_" + n, g->errorThreshold(), g->maxIterations());
+        g->insertNumericalConstraints (proj, slot);
+        insertNumericalConstraints (proj, slot);
+        node ()->insertNumericalConstraintsForPath (proj, slot);
         constraint->addConstraint (proj);
 
-        g->insertLockedJoints (proj);
-        insertLockedJoints (proj);
-        node ()->insertLockedJoints (proj);
+        g->insertLockedJoints (proj, slot);
+        insertLockedJoints (proj, slot);
+        node ()->insertLockedJoints (proj, slot);
         return constraint;
       }
 
@@ -167,7 +214,7 @@ namespace hpp {
         if (!constraints->isSatisfied (q1) || !constraints->isSatisfied (q2)) {
           return false;
         }
-	path = (*steeringMethod_) (q1, q2);
+	path = (*steeringMethods_->get ()) (q1, q2);
         return true;
       }
 
@@ -176,6 +223,24 @@ namespace hpp {
         return applyConstraints (*(nnear->configuration ()), q);
       }
 
+      bool Edge::applyConstraints (core::NodePtr_t nnear, ConfigurationOut_t q,
+          RandomGenerator_t& /*rng*/) const
+      {
+        return applyConstraints (nnear, q);
+      }
+
+      ConfigurationPtr_t Edge::sampleTarget (const core::NodePtr_t&,
+          RandomGenerator_t&) const
+      {
+        return ConfigurationPtr_t ();
+      }
+
+      bool Edge::applyConstraints (ConfigurationIn_t qoffset,
+          const ConfigurationPtr_t&, ConfigurationOut_t q) const
+      {
+        return applyConstraints (qoffset, q);
+      }
+
       bool Edge::applyConstraints (ConfigurationIn_t qoffset,
 				   ConfigurationOut_t q) const
       {
@@ -217,13 +282,15 @@ namespace hpp {
       bool WaypointEdge::build (core::PathPtr_t& path, ConfigurationIn_t q1, ConfigurationIn_t q2, const core::WeighedDistance& d) const
       {
         assert (waypoint_.first);
+        Buffers& buffers = buffers_.local ();
+        Configuration_t& config = buffers.config;
         core::PathPtr_t pathToWaypoint;
-        // Many times, this will be called rigth after WaypointEdge::applyConstraints so config_
+        // Many times, this will be called rigth after WaypointEdge::applyConstraints so config
         // already satisfies the constraints.
-        if (!result_.isApprox (q2)) config_ = q2;
-        if (!waypoint_.first->applyConstraints (q1, config_))
+        if (!buffers.result.isApprox (q2)) config = q2;
+        if (!waypoint_.first->applyConstraints (q1, config))
           return false;
-        if (!waypoint_.first->build (pathToWaypoint, q1, config_, d))
+        if (!waypoint_.first->build (pathToWaypoint, q1, config, d))
           return false;
         core::PathVectorPtr_t pv = HPP_DYNAMIC_PTR_CAST (core::PathVector, pathToWaypoint);
         if (!pv) {
@@ -235,7 +302,7 @@ namespace hpp {
         path = pv;
 
         core::PathPtr_t end;
-        if (!Edge::build (end, config_, q2, d))
+        if (!Edge::build (end, config, q2, d))
           return false;
         pv->appendPath (end);
         return true;
@@ -244,16 +311,30 @@ namespace hpp {
       bool WaypointEdge::applyConstraints (ConfigurationIn_t qoffset, ConfigurationOut_t q) const
       {
         assert (waypoint_.first);
-        config_ = q;
-        if (!waypoint_.first->applyConstraints (qoffset, config_))
+        Buffers& buffers = buffers_.local ();
+        buffers.config = q;
+        if (!waypoint_.first->applyConstraints (qoffset, buffers.config))
           return false;
-        bool success = Edge::applyConstraints (config_, q);
-        result_ = q;
+        bool success = Edge::applyConstraints (buffers.config, q);
+        buffers.result = q;
         return success;
       }
 
+      void WaypointEdge::buildConstraints (const std::size_t& slot) const
+      {
+        Edge::buildConstraints (slot);
+        buffers_.at (slot);
+      }
+
+      void WaypointEdge::fixSlots (const std::size_t& nbSlots) const
+      {
+        Edge::fixSlots (nbSlots);
+        buffers_.fix (nbSlots);
+      }
+
       void WaypointEdge::createWaypoint (const unsigned d, const std::string& bname)
       {
+        checkNotFrozen ();
         std::ostringstream ss;
         ss << bname << "_n" << d;
         NodePtr_t node = Node::create (ss.str());
@@ -262,19 +343,20 @@ namespace hpp {
         ss.str (std::string ()); ss.clear ();
         ss << bname << "_e" << d;
         if (d == 0) {
-          edge = Edge::create (ss.str (), steeringMethod (), graph_, from (),
+          edge = Edge::create (ss.str (), unconstrainedSteeringMethod (),
+                               graph_, from (),
 			       node);
           edge->isInNodeFrom (isInNodeFrom ());
         } else {
           WaypointEdgePtr_t we = WaypointEdge::create
-	    (ss.str (), steeringMethod (), graph_, from (), node);
+	    (ss.str (), unconstrainedSteeringMethod (), graph_, from (),
+             node);
           we->createWaypoint (d-1, bname);
           edge = we;
           edge->isInNodeFrom (isInNodeFrom ());
         }
         waypoint_ = Waypoint (edge, node);
-        config_ = Configuration_t(graph_.lock ()->robot ()->configSize ());
-        result_ = Configuration_t(graph_.lock ()->robot ()->configSize ());
+        buffers_.reset (Buffers (graph_.lock ()->robot ()->configSize ()));
       }
 
       NodePtr_t WaypointEdge::node () const
@@ -363,32 +445,60 @@ namespace hpp {
 
       bool LevelSetEdge::applyConstraints (core::NodePtr_t n_offset, ConfigurationOut_t q) const
       {
-        ConfigProjectorPtr_t param = hist_->foliation().parametrizer();
-        const NumericalConstraints_t& nc = param->numericalConstraints();
-        const LockedJoints_t& lj = param->lockedJoints ();
-
         // First, get an offset from the histogram that is not in the same connected component.
-        statistics::DiscreteDistribution < core::NodePtr_t > distrib = hist_->getDistribOutOfConnectedComponent (n_offset->connectedComponent ());
-        if (distrib.size () == 0) {
+        const core::NodePtr_t target = hist_->sampleOutOfConnectedComponent
+          (n_offset->connectedComponent ());
+        return applyConstraints (*(n_offset->configuration ()),
+            target ? target->configuration () : ConfigurationPtr_t (), q);
+      }
+
+      bool LevelSetEdge::applyConstraints (core::NodePtr_t n_offset, ConfigurationOut_t q,
+          RandomGenerator_t& rng) const
+      {
+        return applyConstraints (*(n_offset->configuration ()),
+            sampleTarget (n_offset, rng), q);
+      }
+
+      ConfigurationPtr_t LevelSetEdge::sampleTarget
+      (const core::NodePtr_t& n_offset, RandomGenerator_t& rng) const
+      {
+        const core::NodePtr_t target = hist_->sampleOutOfConnectedComponent
+          (n_offset->connectedComponent (), rng);
+        if (!target) return ConfigurationPtr_t ();
+        return target->configuration ();
+      }
+
+      bool LevelSetEdge::applyConstraints (ConfigurationIn_t qoffset,
+          const ConfigurationPtr_t& target, ConfigurationOut_t q) const
+      {
+        if (!target) {
           hppDout (warning, "Edge " << name() << ": Distrib is empty");
           return false;
         }
-        const Configuration_t& levelsetTarget = *(distrib ()->configuration ()),
-                               q_offset = *(n_offset->configuration ());
-        // Then, set the offset.
+        return projectOnLeaf (qoffset, *target, q);
+      }
+
+      bool LevelSetEdge::projectOnLeaf (ConfigurationIn_t q_offset,
+          ConfigurationIn_t levelsetTarget, ConfigurationOut_t q) const
+      {
+        const std::size_t slot = ThreadPool::threadSlot ();
         ConstraintSetPtr_t cs = extraConfigConstraint ();
+        const NumericalConstraints_t& nc = extraNumericalConstraints_.at (slot);
+        const LockedJoints_t& lj = parametrizer (slot)->lockedJoints ();
+
+        // Then, set the offset.
         const ConfigProjectorPtr_t cp = cs->configProjector ();
         assert (cp);
-	cp->rightHandSideFromConfig (q_offset);
-	for (NumericalConstraints_t::const_iterator it = nc.begin ();
-	     it != nc.end (); ++it) {
+        cp->rightHandSideFromConfig (q_offset);
+        for (NumericalConstraints_t::const_iterator it = nc.begin ();
+            it != nc.end (); ++it) {
           (*it)->rightHandSideFromConfig (levelsetTarget);
         }
         for (LockedJoints_t::const_iterator it = lj.begin ();
-	     it != lj.end (); ++it) {
+            it != lj.end (); ++it) {
           (*it)->rightHandSideFromConfig (levelsetTarget);
         }
-	cp->updateRightHandSide ();
+        cp->updateRightHandSide ();
 
         // Eventually, do the projection.
         if (cs->apply (q))
@@ -423,6 +533,7 @@ namespace hpp {
 
       void LevelSetEdge::histogram (LeafHistogramPtr_t hist)
       {
+        checkNotFrozen ();
         hist_ = hist;
       }
 
@@ -431,48 +542,86 @@ namespace hpp {
         return hist_;
       }
 
-      void LevelSetEdge::buildExtraConfigConstraint () const
+      ConfigProjectorPtr_t LevelSetEdge::parametrizer
+      (const std::size_t& slot) const
+      {
+        const ConfigProjectorPtr_t& param = parametrizers_.at (slot);
+        return param ? param : hist_->foliation ().parametrizer ();
+      }
+
+      ConstraintSetPtr_t LevelSetEdge::buildExtraConfigConstraint
+      (const std::size_t& slot) const
       {
         /// First get the numerical constraints
-        ConfigProjectorPtr_t param = hist_->foliation().parametrizer();
+        ConfigProjectorPtr_t param = parametrizer (slot);
         const NumericalConstraints_t& nc = param->numericalConstraints();
         const LockedJoints_t& lj = param->lockedJoints ();
 
         /// Build the constraint set.
         std::string n = "(" + name () + "_extra)";
         GraphPtr_t g = graph_.lock ();
+        const core::DevicePtr_t robot = g->robot (slot);
 
-        ConstraintSetPtr_t constraint = ConstraintSet::create (g->robot (), "Set " + n);
+        ConstraintSetPtr_t constraint = ConstraintSet::create (robot, "Set " + n);
 
-        ConfigProjectorPtr_t proj = ConfigProjector::create(g->robot(), "proj_" + n, g->errorThreshold(), g->maxIterations());
-        g->insertNumericalConstraints (proj);
+        ConfigProjectorPtr_t proj = ConfigProjector::create(robot, "proj_" + n, g->errorThreshold(), g->maxIterations());
+        g->insertNumericalConstraints (proj, slot);
+        NumericalConstraints_t& extra = extraNumericalConstraints_.at (slot);
+        extra.clear ();
         for (NumericalConstraints_t::const_iterator it = nc.begin ();
             it != nc.end (); ++it) {
-          proj->add (*it);
+          extra.push_back (g->sharedConstraint (*it));
+          proj->add (extra.back ());
         }
 
-        insertNumericalConstraints (proj);
-        to ()->insertNumericalConstraints (proj);
+        insertNumericalConstraints (proj, slot);
+        to ()->insertNumericalConstraints (proj, slot);
         constraint->addConstraint (proj);
 
-        g->insertLockedJoints (proj);
+        g->insertLockedJoints (proj, slot);
         for (LockedJoints_t::const_iterator it = lj.begin ();
             it != lj.end (); ++it) {
           proj->add (*it);
         }
-        insertLockedJoints (proj);
-        to ()->insertLockedJoints (proj);
-        extraConstraints_->set (constraint);
+        insertLockedJoints (proj, slot);
+        to ()->insertLockedJoints (proj, slot);
+        return constraint;
       }
 
       ConstraintSetPtr_t LevelSetEdge::extraConfigConstraint () const
       {
         if (!*extraConstraints_) {
-          buildExtraConfigConstraint ();
+          extraConstraints_->set
+            (buildExtraConfigConstraint (ThreadPool::threadSlot ()));
         }
         return extraConstraints_->get ();
       }
 
+      void LevelSetEdge::buildConstraints (const std::size_t& slot) const
+      {
+        Edge::buildConstraints (slot);
+        if (hist_ && !extraConstraints_->isSet (slot))
+          extraConstraints_->set (slot, buildExtraConfigConstraint (slot));
+      }
+
+      void LevelSetEdge::instantiateConstraints (const std::size_t& slot,
+          const core::DevicePtr_t& robot) const
+      {
+        Edge::instantiateConstraints (slot, robot);
+        extraConstraints_->set (slot, ConstraintSetPtr_t ());
+        extraNumericalConstraints_.at (slot).clear ();
+        parametrizers_.at (slot) = (hist_ && robot) ?
+          hist_->foliation ().createParametrizer (robot) : ConfigProjectorPtr_t ();
+      }
+
+      void LevelSetEdge::fixSlots (const std::size_t& nbSlots) const
+      {
+        Edge::fixSlots (nbSlots);
+        extraConstraints_->fix (nbSlots);
+        parametrizers_.fix (nbSlots);
+        extraNumericalConstraints_.fix (nbSlots);
+      }
+
       LevelSetEdge::LevelSetEdge
       (const std::string& name,
        const core::SteeringMethodPtr_t& steeringMethod) :
@@ -16,12 +16,17 @@
 
 #include "hpp/manipulation/graph/graph-component.hh"
 
+#include <hpp/util/pointer.hh>
+#include <hpp/core/numerical-constraint.hh>
 #include <hpp/core/config-projector.hh>
 #include <hpp/core/constraint-set.hh>
 #include <hpp/core/locked-joint.hh>
 
 #include <hpp/constraints/differentiable-function.hh>
 
+#include "hpp/manipulation/graph/graph.hh"
+#include "hpp/manipulation/thread-pool.hh"
+
 namespace hpp {
   namespace manipulation {
     namespace graph {
@@ -66,8 +71,26 @@ namespace hpp {
       void GraphComponent::addNumericalConstraint (const NumericalConstraintPtr_t& nm,
           const SizeIntervals_t& passiveDofs)
       {
+        checkNotFrozen ();
         numericalConstraints_.push_back(nm);
         passiveDofs_.push_back (passiveDofs);
+        factories_.push_back (NumericalConstraintFactory_t ());
+        invalidate ();
+      }
+
+      void GraphComponent::addNumericalConstraint
+      (const NumericalConstraintFactory_t& factory,
+       const SizeIntervals_t& passiveDofs)
+      {
+        checkNotFrozen ();
+        GraphPtr_t g = graph_.lock ();
+        if (!g)
+          throw std::logic_error ("Component " + name () + " is not in a "
+              "graph: there is no robot to create the constraint for.");
+        numericalConstraints_.push_back (factory (g->robot ()));
+        passiveDofs_.push_back (passiveDofs);
+        factories_.push_back (factory);
+        invalidate ();
       }
 
       void GraphComponent::addNumericalConstraint (const DifferentiableFunctionPtr_t& function, const ComparisonTypePtr_t& ineq)
@@ -78,27 +101,44 @@ namespace hpp {
       void GraphComponent::addLockedJointConstraint
       (const LockedJointPtr_t& constraint)
       {
+        checkNotFrozen ();
         lockedJoints_.push_back (constraint);
+        invalidate ();
       }
 
       bool GraphComponent::insertNumericalConstraints (ConfigProjectorPtr_t& proj) const
       {
+        return insertNumericalConstraints (proj, ThreadPool::threadSlot ());
+      }
+
+      bool GraphComponent::insertNumericalConstraints (ConfigProjectorPtr_t& proj,
+          const std::size_t& slot) const
+      {
+        GraphPtr_t g = graph_.lock ();
+        const NumericalConstraints_t& ncs = numericalConstraints (slot);
         IntervalsContainer_t::const_iterator itpdof = passiveDofs_.begin ();
-        for (NumericalConstraints_t::const_iterator it = numericalConstraints_.begin();
-            it != numericalConstraints_.end(); ++it) {
-          proj->add (*it, *itpdof);
+        for (NumericalConstraints_t::const_iterator it = ncs.begin();
+            it != ncs.end(); ++it) {
+          proj->add (g ? g->sharedConstraint (*it) : *it, *itpdof);
           ++itpdof;
         }
         assert (itpdof == passiveDofs_.end ());
-        return !numericalConstraints_.empty ();
+        return !ncs.empty ();
       }
 
       bool GraphComponent::insertLockedJoints (ConfigProjectorPtr_t& cp) const
       {
-        for (LockedJoints_t::const_iterator it = lockedJoints_.begin();
-            it != lockedJoints_.end(); ++it)
+        return insertLockedJoints (cp, ThreadPool::threadSlot ());
+      }
+
+      bool GraphComponent::insertLockedJoints (ConfigProjectorPtr_t& cp,
+          const std::size_t& slot) const
+      {
+        const LockedJoints_t& ljs = lockedJoints (slot);
+        for (LockedJoints_t::const_iterator it = ljs.begin();
+            it != ljs.end(); ++it)
           cp->add (*it);
-        return !lockedJoints_.empty ();
+        return !ljs.empty ();
       }
 
       const NumericalConstraints_t& GraphComponent::numericalConstraints() const
@@ -106,6 +146,14 @@ namespace hpp {
         return numericalConstraints_;
       }
 
+      const NumericalConstraints_t& GraphComponent::numericalConstraints
+      (const std::size_t& slot) const
+      {
+        const Instances& instances = instances_.at (slot);
+        return instances.set ? instances.numericalConstraints :
+          numericalConstraints_;
+      }
+
       const std::vector <SizeIntervals_t>& GraphComponent::passiveDofs() const
       {
         return passiveDofs_;
@@ -116,6 +164,58 @@ namespace hpp {
         return lockedJoints_;
       }
 
+      const LockedJoints_t& GraphComponent::lockedJoints
+      (const std::size_t& slot) const
+      {
+        const Instances& instances = instances_.at (slot);
+        return instances.set ? instances.lockedJoints : lockedJoints_;
+      }
+
+      NumericalConstraintPtr_t GraphComponent::instantiate
+      (const NumericalConstraintFactory_t& factory,
+       const NumericalConstraintPtr_t& constraint,
+       const core::DevicePtr_t& robot) const
+      {
+        if (factory.empty ())
+          throw std::logic_error ("Constraint " + constraint->function ().name ()
+              + " of " + name () + " was added without factory. It cannot be "
+              "evaluated by several threads.");
+        NumericalConstraintPtr_t nc = factory (robot);
+        nc->rightHandSide (constraint->rightHandSide ());
+        return nc;
+      }
+
+      void GraphComponent::instantiateConstraints (const std::size_t& slot,
+          const core::DevicePtr_t& robot) const
+      {
+        Instances& instances = instances_.at (slot);
+        instances = Instances ();
+        if (!robot) return;
+        for (std::size_t i = 0; i < numericalConstraints_.size (); ++i)
+          instances.numericalConstraints.push_back (instantiate
+              (factories_ [i], numericalConstraints_ [i], robot));
+        // Locked joints do not evaluate the kinematics but store their
+        // right hand side.
+        for (LockedJoints_t::const_iterator it = lockedJoints_.begin ();
+            it != lockedJoints_.end (); ++it)
+          instances.lockedJoints.push_back
+            (HPP_STATIC_PTR_CAST (LockedJoint, (*it)->copy ()));
+        instances.set = true;
+      }
+
+      void GraphComponent::fixSlots (const std::size_t& nbSlots) const
+      {
+        instances_.fix (nbSlots);
+      }
+
+      void GraphComponent::checkNotFrozen () const
+      {
+        GraphPtr_t g = graph_.lock ();
+        if (g && g->frozen ())
+          throw std::logic_error ("Graph " + g->name () + " is initialized. "
+              "Component " + name () + " cannot be modified.");
+      }
+
       void GraphComponent::parentGraph(const GraphWkPtr_t& parent)
       {
         graph_ = parent;
@@ -16,11 +16,25 @@
 
 #include "hpp/manipulation/graph/graph.hh"
 
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <queue>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
 #include <hpp/util/assertion.hh>
+#include <hpp/core/numerical-constraint.hh>
 
 #include "hpp/manipulation/graph/node-selector.hh"
 #include "hpp/manipulation/graph/node.hh"
 #include "hpp/manipulation/graph/edge.hh"
+#include "hpp/manipulation/graph/node-cache.hh"
+#include "hpp/manipulation/graph/cached-function.hh"
+#include "hpp/manipulation/roadmap-node.hh"
+#include "hpp/manipulation/thread-pool.hh"
 
 namespace hpp {
   namespace manipulation {
@@ -39,10 +53,12 @@ namespace hpp {
         GraphComponent::init (weak);
         robot_ = robot;
         wkPtr_ = weak;
+        parentGraph (weak);
       }
 
       NodeSelectorPtr_t Graph::createNodeSelector (const std::string& name)
       {
+        checkNotFrozen ();
         nodeSelector_ = NodeSelector::create (name);
         nodeSelector_->parentGraph (wkPtr_);
         return nodeSelector_;
@@ -50,7 +66,9 @@ namespace hpp {
 
       void Graph::maxIterations (size_type iterations)
       {
+        checkNotFrozen ();
         maxIterations_ = iterations;
+        invalidate ();
       }
 
       size_type Graph::maxIterations () const
@@ -60,7 +78,10 @@ namespace hpp {
 
       void Graph::errorThreshold (const value_type& threshold)
       {
+        checkNotFrozen ();
         errorThreshold_ = threshold;
+        // The classifier of the node selector uses the threshold.
+        invalidate ();
       }
 
       value_type Graph::errorThreshold () const
@@ -73,14 +94,196 @@ namespace hpp {
         return robot_;
       }
 
+      core::DevicePtr_t Graph::robot (const std::size_t& slot) const
+      {
+        if (slot < robots_.size () && robots_ [slot]) return robots_ [slot];
+        return robot_;
+      }
+
       const core::SteeringMethodPtr_t& Graph::steeringMethod () const
       {
 	return steeringMethod_;
       }
 
+      namespace {
+        typedef std::vector < GraphComponentPtr_t > GraphComponents_t;
+
+        /// Add an edge and, for waypoint edges, the inner edges and
+        /// nodes.
+        void addEdge (const EdgePtr_t& edge, GraphComponents_t& components)
+        {
+          components.push_back (edge);
+          WaypointEdgePtr_t we = HPP_DYNAMIC_PTR_CAST (WaypointEdge, edge);
+          if (we) {
+            const EdgePtr_t inner = we->waypoint <Edge> ();
+            // The inner edge leads to the waypoint node.
+            components.push_back (inner->to ());
+            addEdge (inner, components);
+          }
+        }
+
+        void buildComponent (const std::size_t& i,
+            const GraphComponents_t& components,
+            const std::vector < std::size_t >& slots,
+            std::vector < value_type >& times)
+        {
+          const boost::posix_time::ptime start =
+            boost::posix_time::microsec_clock::universal_time ();
+          for (std::size_t j = 0; j < slots.size (); ++j)
+            components [i]->buildConstraints (slots [j]);
+          times [i] = 1e-6 * (value_type) (boost::posix_time::microsec_clock::
+              universal_time () - start).total_microseconds ();
+        }
+      }
+
+      void Graph::initialize (const std::vector < std::size_t >& slots,
+          const std::size_t& nbThreads)
+      {
+        if (!nodeSelector_)
+          throw std::logic_error ("Graph " + name () + " has no NodeSelector.");
+
+        const std::size_t caller = ThreadPool::threadSlot ();
+        std::vector < std::size_t > s (slots);
+        s.push_back (caller);
+        std::sort (s.begin (), s.end ());
+        s.erase (std::unique (s.begin (), s.end ()), s.end ());
+        // Only the slots that were not initialized yet are built.
+        std::vector < std::size_t > added;
+        std::set_difference (s.begin (), s.end (), slots_.begin (),
+            slots_.end (), std::back_inserter (added));
+        if (frozen_ && added.empty ()) return;
+
+        GraphComponents_t components;
+        components.push_back (wkPtr_.lock ());
+        components.push_back (nodeSelector_);
+        const Nodes_t& nodes = nodeSelector_->getNodes ();
+        for (Nodes_t::const_iterator itNode = nodes.begin ();
+            itNode != nodes.end (); ++itNode) {
+          components.push_back (*itNode);
+          for (Neighbors_t::const_iterator itEdge =
+              (*itNode)->neighbors ().begin ();
+              itEdge != (*itNode)->neighbors ().end (); ++itEdge)
+            addEdge (itEdge->second, components);
+        }
+
+        // Create the constraints of each thread on its copy of the robot.
+        // This is sequential, so that the storage of every component is
+        // sized for all the slots before the threads read it. The first
+        // caller uses robot (), the threads added later use a copy.
+        const std::size_t nbSlots = std::max (s.back (),
+            slots_.empty () ? 0 : slots_.back ()) + 1;
+        if (robots_.size () < nbSlots) robots_.resize (nbSlots);
+        for (std::size_t i = 0; i < components.size (); ++i)
+          components [i]->fixSlots (nbSlots);
+        for (SharedFunctions_t::const_iterator it = sharedFunctions_.begin ();
+            it != sharedFunctions_.end (); ++it)
+          it->second->fixSlots (nbSlots);
+        try {
+          for (std::size_t j = 0; j < added.size (); ++j) {
+            if (frozen_ || added [j] != caller)
+              robots_ [added [j]] = robot_->clone ();
+            for (std::size_t i = 0; i < components.size (); ++i)
+              components [i]->instantiateConstraints (added [j],
+                  robots_ [added [j]]);
+          }
+        } catch (const std::exception&) {
+          // Leave the slots that were initialized before as they were.
+          for (std::size_t j = 0; j < added.size (); ++j) {
+            robots_ [added [j]].reset ();
+            for (std::size_t i = 0; i < components.size (); ++i)
+              components [i]->instantiateConstraints (added [j],
+                  core::DevicePtr_t ());
+          }
+          throw;
+        }
+
+        // The shared functions created while building are fixed for the
+        // slots.
+        std::vector < std::size_t > merged;
+        std::set_union (slots_.begin (), slots_.end (), added.begin (),
+            added.end (), std::back_inserter (merged));
+        slots_ = merged;
+        std::vector < value_type > times (components.size (), 0);
+        ThreadPoolPtr_t pool = ThreadPool::create
+          (nbThreads > 0 ? nbThreads : boost::thread::hardware_concurrency ());
+        pool->run (components.size (), boost::bind (&buildComponent, _1,
+              boost::cref (components), boost::cref (added),
+              boost::ref (times)));
+
+        initializationTimes_.clear ();
+        for (std::size_t i = 0; i < components.size (); ++i) {
+          initializationTimes_ [components [i]->id ()] = times [i];
+          hppDout (info, "Built constraints of " << components [i]->name ()
+              << " in " << times [i] << "s");
+        }
+        frozen_ = true;
+      }
+
+      void Graph::nodeCache (const NodeCachePtr_t& cache)
+      {
+        nodeCache_ = cache;
+      }
+
+      const NodeCachePtr_t& Graph::nodeCache () const
+      {
+        return nodeCache_;
+      }
+
+      void Graph::shareConstraintEvaluation (const bool& share)
+      {
+        checkNotFrozen ();
+        shareConstraintEvaluation_ = share;
+        invalidate ();
+      }
+
+      NumericalConstraintPtr_t Graph::sharedConstraint
+      (const NumericalConstraintPtr_t& nc) const
+      {
+        if (!shareConstraintEvaluation_) return nc;
+        // Constraints with different comparison types or right hand sides
+        // may share the same function.
+        const DifferentiableFunctionPtr_t& f = nc->functionPtr ();
+        CachedFunctionPtr_t cached;
+        {
+          boost::mutex::scoped_lock lock (sharedConstraintsMutex_);
+          SharedFunctions_t::const_iterator it = sharedFunctions_.find (f);
+          if (it == sharedFunctions_.end ()) {
+            it = sharedFunctions_.insert (std::make_pair (f,
+                  CachedFunction::create (f, slots_.empty () ?
+                    ThreadPool::threadSlot () + 1 : slots_.back () + 1)))
+              .first;
+            if (!slots_.empty ()) it->second->fixSlots (slots_.back () + 1);
+          }
+          cached = it->second;
+        }
+        NumericalConstraintPtr_t shared = NumericalConstraint::create
+          (cached, nc->comparisonType ());
+        shared->rightHandSide (nc->rightHandSide ());
+        return shared;
+      }
+
+      void Graph::invalidate ()
+      {
+        // The decision tree of the node selector tests the constraints of
+        // the graph. This also clears the cache.
+        if (nodeSelector_) nodeSelector_->invalidate ();
+        else if (nodeCache_) nodeCache_->clear ();
+      }
+
       NodePtr_t Graph::getNode (ConfigurationIn_t config) const
       {
-        return nodeSelector_->getNode (config);
+        NodePtr_t node;
+        if (nodeCache_ && nodeCache_->get (config, node)) return node;
+        node = nodeSelector_->getNode (config);
+        if (nodeCache_) nodeCache_->insert (config, node);
+        return node;
+      }
+
+      NodePtr_t Graph::getNode (const RoadmapNodePtr_t& node) const
+      {
+        if (!node->cacheUpToDate ())
+          node->graphNode (getNode (*node->configuration ()));
+        return node->graphNode ();
       }
 
       Edges_t Graph::getEdges (const NodePtr_t& from, const NodePtr_t& to) const
@@ -94,11 +297,61 @@ namespace hpp {
         return edges;
       }
 
+      Graph::StateCosts_t Graph::costsTo (const Nodes_t& targets,
+          const EdgeCost_t& cost) const
+      {
+        // The search goes backward from the targets.
+        std::map < NodePtr_t, Edges_t > incoming;
+        const Nodes_t& states = nodeSelector_->getNodes ();
+        for (Nodes_t::const_iterator itState = states.begin ();
+            itState != states.end (); ++itState) {
+          for (Neighbors_t::const_iterator it =
+              (*itState)->neighbors ().begin ();
+              it != (*itState)->neighbors ().end (); ++it)
+            if (it->first > 0) incoming [it->second->to ()].push_back (it->second);
+        }
+
+        typedef std::pair < value_type, NodePtr_t > Item_t;
+        std::priority_queue < Item_t, std::vector < Item_t >,
+          std::greater < Item_t > > queue;
+        StateCosts_t costs;
+        for (Nodes_t::const_iterator it = targets.begin ();
+            it != targets.end (); ++it)
+          if (costs.insert (std::make_pair (*it, 0.)).second)
+            queue.push (Item_t (0, *it));
+        while (!queue.empty ()) {
+          const Item_t item = queue.top ();
+          queue.pop ();
+          // Skip outdated items.
+          if (item.first > costs [item.second]) continue;
+          const Edges_t& edges = incoming [item.second];
+          for (Edges_t::const_iterator it = edges.begin ();
+              it != edges.end (); ++it) {
+            const value_type c = cost (*it);
+            assert (c >= 0);
+            if (c == std::numeric_limits <value_type>::infinity ()) continue;
+            const NodePtr_t from = (*it)->from ();
+            StateCosts_t::iterator itCost = costs.find (from);
+            if (itCost != costs.end () && itCost->second <= item.first + c)
+              continue;
+            costs [from] = item.first + c;
+            queue.push (Item_t (item.first + c, from));
+          }
+        }
+        return costs;
+      }
+
       EdgePtr_t Graph::chooseEdge (const NodePtr_t& node) const
       {
         return nodeSelector_->chooseEdge (node);
       }
 
+      EdgePtr_t Graph::chooseEdge (const NodePtr_t& node,
+          RandomGenerator_t& rng) const
+      {
+        return nodeSelector_->chooseEdge (node, rng);
+      }
+
       ConstraintSetPtr_t Graph::configConstraint (const NodePtr_t& node)
       {
         return node->configConstraint ();
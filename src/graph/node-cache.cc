@@ -0,0 +1,216 @@
+// Copyright (c) 2015, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#include "hpp/manipulation/graph/node-cache.hh"
+
+#include <cmath>
+#include <boost/functional/hash.hpp>
+
+#include "hpp/manipulation/graph/node.hh"
+#include "hpp/manipulation/graph/node-selector.hh"
+
+namespace hpp {
+  namespace manipulation {
+    namespace graph {
+      namespace {
+        /// Ratio between the size of the cells of the grid and the
+        /// tolerance.
+        const value_type cellSizeRatio = 16;
+        /// Maximal number of coordinates along which the neighbouring
+        /// cells are searched. Beyond, the entries of some neighbouring
+        /// cells are missed.
+        const std::size_t maxNeighborCoordinates = 4;
+
+        /// Whether a state is the first one of its NodeSelector containing
+        /// a configuration, as NodeSelector::getNode would return.
+        bool isStateOf (const NodePtr_t& state, ConfigurationIn_t config)
+        {
+          if (!state->contains (config)) return false;
+          const NodeSelectorPtr_t selector = state->nodeSelector ().lock ();
+          if (!selector) return true;
+          const Nodes_t& states = selector->getNodes ();
+          for (Nodes_t::const_iterator it = states.begin ();
+              it != states.end () && *it != state; ++it)
+            if ((*it)->contains (config)) return false;
+          return true;
+        }
+      }
+
+      NodeCachePtr_t NodeCache::create (const std::size_t& capacity,
+          const value_type& tolerance)
+      {
+        return NodeCachePtr_t (new NodeCache (capacity, tolerance));
+      }
+
+      NodeCache::NodeCache (const std::size_t& capacity,
+          const value_type& tolerance) :
+        capacity_ (capacity), tolerance_ (tolerance),
+        cellSize_ (cellSizeRatio * tolerance), entries_ (), index_ (),
+        hits_ (0), misses_ (0)
+      {
+        if (tolerance_ < 0)
+          throw std::invalid_argument ("The tolerance must be non negative.");
+      }
+
+      NodeCache::Cell_t NodeCache::cell (ConfigurationIn_t config) const
+      {
+        Cell_t c (config.size ());
+        for (size_type i = 0; i < config.size (); ++i)
+          c [i] = (long) std::floor (config [i] / cellSize_);
+        return c;
+      }
+
+      std::size_t NodeCache::hash (const Cell_t& cell)
+      {
+        return boost::hash_range (cell.begin (), cell.end ());
+      }
+
+      std::size_t NodeCache::hash (ConfigurationIn_t config) const
+      {
+        if (tolerance_ > 0) return hash (cell (config));
+        std::size_t seed = 0;
+        for (size_type i = 0; i < config.size (); ++i)
+          boost::hash_combine (seed, config [i]);
+        return seed;
+      }
+
+      NodeCache::Entries_t::iterator NodeCache::find
+      (ConfigurationIn_t config, const std::size_t& h, const bool& exact)
+      {
+        std::pair < Index_t::iterator, Index_t::iterator > range =
+          index_.equal_range (h);
+        for (Index_t::iterator it = range.first; it != range.second; ++it) {
+          const Configuration_t& q = it->second->config;
+          if (q.size () != config.size ()) continue;
+          if (!exact && tolerance_ > 0) {
+            if (q.size () == 0
+                || (q - config).cwiseAbs ().maxCoeff () <= tolerance_)
+              return it->second;
+          } else if (q == config)
+            return it->second;
+        }
+        return entries_.end ();
+      }
+
+      NodeCache::Entries_t::iterator NodeCache::find
+      (ConfigurationIn_t config)
+      {
+        if (tolerance_ == 0) return find (config, hash (config), true);
+        const Cell_t c = cell (config);
+        // A matching entry is in a neighbouring cell only along the
+        // coordinates close to the border of the cell.
+        std::vector < size_type > coords;
+        std::vector < long > directions;
+        for (size_type i = 0; i < config.size ()
+            && coords.size () < maxNeighborCoordinates; ++i) {
+          const value_type offset = config [i] - c [i] * cellSize_;
+          if (offset <= tolerance_) {
+            coords.push_back (i);
+            directions.push_back (-1);
+          } else if (cellSize_ - offset <= tolerance_) {
+            coords.push_back (i);
+            directions.push_back (1);
+          }
+        }
+        Cell_t neighbor (c);
+        for (std::size_t n = 0; n < ((std::size_t) 1 << coords.size ()); ++n) {
+          for (std::size_t k = 0; k < coords.size (); ++k)
+            neighbor [coords [k]] =
+              c [coords [k]] + ((n >> k) & 1 ? directions [k] : 0);
+          Entries_t::iterator it = find (config, hash (neighbor), false);
+          if (it != entries_.end ()) return it;
+        }
+        return entries_.end ();
+      }
+
+      bool NodeCache::get (ConfigurationIn_t config, NodePtr_t& node)
+      {
+        NodePtr_t cached;
+        bool equal = false;
+        {
+          boost::mutex::scoped_lock lock (mutex_);
+          Entries_t::iterator it = find (config);
+          if (it != entries_.end ()) {
+            cached = it->node;
+            equal = (it->config == config);
+            entries_.splice (entries_.begin (), entries_, it);
+          }
+        }
+        // The state of an equal configuration is right. Otherwise, it is
+        // checked outside of the lock as it evaluates the constraints.
+        const bool hit = cached && (equal || isStateOf (cached, config));
+        boost::mutex::scoped_lock lock (mutex_);
+        if (!hit) {
+          ++misses_;
+          return false;
+        }
+        ++hits_;
+        node = cached;
+        return true;
+      }
+
+      void NodeCache::insert (ConfigurationIn_t config, const NodePtr_t& node)
+      {
+        if (capacity_ == 0) return;
+        const std::size_t h = hash (config);
+        boost::mutex::scoped_lock lock (mutex_);
+        Entries_t::iterator it = find (config, h, true);
+        if (it != entries_.end ()) {
+          it->node = node;
+          entries_.splice (entries_.begin (), entries_, it);
+          return;
+        }
+        if (entries_.size () >= capacity_) {
+          // Remove the least recently used entry.
+          Entries_t::iterator last = --entries_.end ();
+          std::pair < Index_t::iterator, Index_t::iterator > range =
+            index_.equal_range (last->hash);
+          for (Index_t::iterator itI = range.first; itI != range.second; ++itI)
+            if (itI->second == last) {
+              index_.erase (itI);
+              break;
+            }
+          entries_.erase (last);
+        }
+        Entry e;
+        e.config = config;
+        e.node = node;
+        e.hash = h;
+        entries_.push_front (e);
+        index_.insert (std::make_pair (h, entries_.begin ()));
+      }
+
+      void NodeCache::clear ()
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        index_.clear ();
+        entries_.clear ();
+      }
+
+      std::size_t NodeCache::size () const
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        return entries_.size ();
+      }
+
+      void NodeCache::resetCounters ()
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        hits_ = misses_ = 0;
+      }
+    } // namespace graph
+  } // namespace manipulation
+} // namespace hpp
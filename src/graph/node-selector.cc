@@ -18,10 +18,257 @@
 #include "hpp/manipulation/graph/node-selector.hh"
 
 #include <cstdlib>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include <hpp/core/config-projector.hh>
+#include <hpp/core/locked-joint.hh>
+
+#include "hpp/manipulation/thread-pool.hh"
+#include "hpp/manipulation/graph/graph.hh"
+#include "hpp/manipulation/graph/node-cache.hh"
 
 namespace hpp {
   namespace manipulation {
     namespace graph {
+      /// Decision tree selecting the state of a configuration.
+      ///
+      /// Each internal vertex tests one of the distinct constraints of the
+      /// states and of the graph. A state is a candidate of a vertex if
+      /// none of its constraints failed the tests on the way from the root.
+      /// A leaf stores the first candidate, which still has to be checked
+      /// since a state may be unsatisfied even though each of its
+      /// constraints is satisfied separately: the squared errors of the
+      /// tests are summed as in the ConfigProjector of the state.
+      struct NodeSelector::Classifier
+      {
+        /// A constraint of one or several states, or of the graph.
+        struct Test {
+          NumericalConstraintPtr_t numericalConstraint;
+          SizeIntervals_t passiveDofs;
+          LockedJointPtr_t lockedJoint;
+          /// First component having the constraint and index of the
+          /// constraint in it, to get the instance of each thread.
+          GraphComponentPtr_t component;
+          std::size_t index;
+          /// ConfigProjector containing only this constraint.
+          mutable Cache <ConfigProjectorPtr_t> projector;
+        };
+        typedef boost::shared_ptr <Test> TestPtr_t;
+
+        /// Vertex of the tree. For a leaf, test is -1 and satisfied is the
+        /// index of the first candidate in states.
+        struct Vertex {
+          int test;
+          std::size_t satisfied, unsatisfied;
+        };
+
+        typedef std::vector <std::size_t> Indexes_t;
+        /// Squared errors of the tests for a configuration, negative if the
+        /// test was not evaluated yet. A locked joint has no error: it is
+        /// either 0 or infinite.
+        typedef std::vector <value_type> Errors_t;
+
+        /// Above this number of vertices, the leaves are not split anymore.
+        /// getNode remains correct since it scans the states following the
+        /// candidate of a leaf.
+        std::size_t maxSize;
+        Nodes_t states;
+        std::vector <TestPtr_t> tests;
+        /// For each state, the sorted indexes of its tests.
+        std::vector <Indexes_t> keys;
+        std::vector <Vertex> tree;
+        GraphPtr_t graph;
+        value_type squaredErrorThreshold;
+
+        typedef std::map <NumericalConstraintPtr_t, std::size_t> NCIndex_t;
+        typedef std::map <LockedJointPtr_t, std::size_t> LJIndex_t;
+
+        Classifier (const Nodes_t& s, const GraphPtr_t& g,
+            const std::size_t& m) : maxSize (m), states (s), graph (g),
+          squaredErrorThreshold (g->errorThreshold () * g->errorThreshold ())
+        {
+          NCIndex_t ncIndex;
+          LJIndex_t ljIndex;
+          // The constraints of the graph are in every state.
+          Indexes_t graphKeys;
+          addTests (graph, graphKeys, ncIndex, ljIndex);
+          keys.resize (states.size ());
+          for (std::size_t i = 0; i < states.size (); ++i) {
+            keys[i] = graphKeys;
+            addTests (states[i], keys[i], ncIndex, ljIndex);
+            std::sort (keys[i].begin (), keys[i].end ());
+            keys[i].erase (std::unique (keys[i].begin (), keys[i].end ()),
+                keys[i].end ());
+          }
+          Indexes_t candidates (states.size ());
+          for (std::size_t i = 0; i < states.size (); ++i) candidates[i] = i;
+          std::vector <bool> known (tests.size (), false);
+          build (candidates, known);
+        }
+
+        /// Add the tests of the constraints of a component that are not
+        /// tests yet.
+        /// \retval k the indexes of the tests of the component are appended.
+        void addTests (const GraphComponentPtr_t& component, Indexes_t& k,
+            NCIndex_t& ncIndex, LJIndex_t& ljIndex)
+        {
+          const NumericalConstraints_t& ncs = component->numericalConstraints ();
+          const IntervalsContainer_t& pdofs = component->passiveDofs ();
+          for (std::size_t j = 0; j < ncs.size (); ++j) {
+            NCIndex_t::iterator it = ncIndex.find (ncs[j]);
+            if (it == ncIndex.end ()) {
+              TestPtr_t t (new Test);
+              t->numericalConstraint = ncs[j];
+              t->passiveDofs = pdofs[j];
+              t->component = component;
+              t->index = j;
+              it = ncIndex.insert (std::make_pair (ncs[j], tests.size ())).first;
+              tests.push_back (t);
+            }
+            k.push_back (it->second);
+          }
+          const LockedJoints_t& ljs = component->lockedJoints ();
+          for (std::size_t j = 0; j < ljs.size (); ++j) {
+            LJIndex_t::iterator it = ljIndex.find (ljs[j]);
+            if (it == ljIndex.end ()) {
+              TestPtr_t t (new Test);
+              t->lockedJoint = ljs[j];
+              t->component = component;
+              t->index = j;
+              it = ljIndex.insert (std::make_pair (ljs[j], tests.size ())).first;
+              tests.push_back (t);
+            }
+            k.push_back (it->second);
+          }
+        }
+
+        /// Build the subtree of a set of candidates, sorted by priority.
+        /// \param known whether the tests were done on the way from the root.
+        /// \return the index of the root of the subtree.
+        std::size_t build (const Indexes_t& candidates, std::vector <bool>& known)
+        {
+          const std::size_t index = tree.size ();
+          tree.push_back (Vertex ());
+          tree[index].test = -1;
+          tree[index].unsatisfied = 0;
+          if (candidates.empty ()) {
+            tree[index].satisfied = states.size ();
+            return index;
+          }
+          tree[index].satisfied = candidates.front ();
+          if (tree.size () >= maxSize) return index;
+
+          // Among the remaining tests of the first candidate, choose the one
+          // shared by the largest number of candidates.
+          std::vector <std::size_t> count (tests.size (), 0);
+          for (Indexes_t::const_iterator c = candidates.begin ();
+              c != candidates.end (); ++c)
+            for (Indexes_t::const_iterator k = keys[*c].begin ();
+                k != keys[*c].end (); ++k)
+              if (!known[*k]) ++count[*k];
+          int best = -1;
+          const Indexes_t& first = keys[candidates.front ()];
+          for (Indexes_t::const_iterator k = first.begin ();
+              k != first.end (); ++k)
+            if (!known[*k] && (best < 0 || count[*k] > count[best]))
+              best = (int) *k;
+          if (best < 0) return index;
+
+          known[best] = true;
+          const std::size_t satisfied = build (candidates, known);
+          known[best] = false;
+          Indexes_t remaining;
+          for (Indexes_t::const_iterator c = candidates.begin ();
+              c != candidates.end (); ++c)
+            if (!std::binary_search (keys[*c].begin (), keys[*c].end (),
+                  (std::size_t) best))
+              remaining.push_back (*c);
+          const std::size_t unsatisfied = build (remaining, known);
+
+          tree[index].test = best;
+          tree[index].satisfied = satisfied;
+          tree[index].unsatisfied = unsatisfied;
+          return index;
+        }
+
+        /// Build the projector of a test for a thread, with the instance
+        /// of the constraint of the thread.
+        ConfigProjectorPtr_t buildProjector (const Test& t,
+            const std::size_t& slot) const
+        {
+          ConfigProjectorPtr_t proj = ConfigProjector::create
+            (graph->robot (slot), "classifier",
+             graph->errorThreshold (), graph->maxIterations ());
+          if (t.numericalConstraint)
+            proj->add (graph->sharedConstraint
+                (t.component->numericalConstraints (slot)[t.index]),
+                t.passiveDofs);
+          else
+            proj->add (t.component->lockedJoints (slot)[t.index]);
+          return proj;
+        }
+
+        /// Squared error of test i, evaluated at most once per
+        /// configuration.
+        value_type squaredError (const std::size_t& i,
+            ConfigurationIn_t config, Errors_t& errors) const
+        {
+          if (errors[i] >= 0) return errors[i];
+          const Test& t = *tests[i];
+          if (!t.projector)
+            t.projector.set (buildProjector (t, ThreadPool::threadSlot ()));
+          if (t.numericalConstraint) {
+            vector_t error;
+            t.projector.get ()->isSatisfied (config, error);
+            errors[i] = error.squaredNorm ();
+          } else if (t.projector.get ()->isSatisfied (config))
+            errors[i] = 0;
+          else
+            errors[i] = std::numeric_limits <value_type>::infinity ();
+          return errors[i];
+        }
+
+        bool isSatisfied (const std::size_t& i, ConfigurationIn_t config,
+            Errors_t& errors) const
+        {
+          return squaredError (i, config, errors) < squaredErrorThreshold;
+        }
+
+        /// Index of the first candidate of the leaf reached by config.
+        std::size_t candidate (ConfigurationIn_t config, Errors_t& errors)
+          const
+        {
+          std::size_t v = 0;
+          while (tree[v].test >= 0) {
+            if (isSatisfied (tree[v].test, config, errors))
+              v = tree[v].satisfied;
+            else
+              v = tree[v].unsatisfied;
+          }
+          return tree[v].satisfied;
+        }
+
+        /// Whether state s contains config, as Node::contains, from the
+        /// results of the tests.
+        bool contains (const std::size_t& s, ConfigurationIn_t config,
+            Errors_t& errors) const
+        {
+          const Indexes_t& k = keys[s];
+          // Reject the state without evaluating anything if one of its
+          // tests already failed.
+          for (Indexes_t::const_iterator it = k.begin (); it != k.end (); ++it)
+            if (errors[*it] >= squaredErrorThreshold) return false;
+          value_type error = 0;
+          for (Indexes_t::const_iterator it = k.begin (); it != k.end (); ++it) {
+            error += squaredError (*it, config, errors);
+            if (!(error < squaredErrorThreshold)) return false;
+          }
+          return true;
+        }
+      };
+
       NodeSelectorPtr_t NodeSelector::create(const std::string& name)
       {
         NodeSelector* ptr = new NodeSelector (name);
@@ -38,19 +285,78 @@ namespace hpp {
 
       NodePtr_t NodeSelector::createNode (const std::string& name)
       {
+        checkNotFrozen ();
         NodePtr_t newNode = Node::create (name);
         newNode->nodeSelector(wkPtr_);
         newNode->parentGraph(graph_);
         orderedStates_.push_back(newNode);
+        invalidate ();
         return newNode;
       }
 
+      void NodeSelector::invalidate ()
+      {
+        classifier_.reset ();
+        GraphPtr_t graph = graph_.lock ();
+        if (graph && graph->nodeCache ()) graph->nodeCache ()->clear ();
+      }
+
+      void NodeSelector::buildConstraints (const std::size_t& slot) const
+      {
+        const ClassifierPtr_t& c = classifier ();
+        for (std::size_t i = 0; i < c->tests.size (); ++i) {
+          const Classifier::Test& t = *c->tests [i];
+          if (!t.projector.isSet (slot))
+            t.projector.set (slot, c->buildProjector (t, slot));
+        }
+      }
+
+      void NodeSelector::instantiateConstraints (const std::size_t& slot,
+          const core::DevicePtr_t& robot) const
+      {
+        GraphComponent::instantiateConstraints (slot, robot);
+        const ClassifierPtr_t& c = classifier ();
+        for (std::size_t i = 0; i < c->tests.size (); ++i)
+          c->tests [i]->projector.set (slot, ConfigProjectorPtr_t ());
+      }
+
+      void NodeSelector::fixSlots (const std::size_t& nbSlots) const
+      {
+        GraphComponent::fixSlots (nbSlots);
+        const ClassifierPtr_t& c = classifier ();
+        for (std::size_t i = 0; i < c->tests.size (); ++i)
+          c->tests [i]->projector.fix (nbSlots);
+      }
+
+      const NodeSelector::ClassifierPtr_t& NodeSelector::classifier () const
+      {
+        if (!classifier_)
+          classifier_.reset (new Classifier (orderedStates_, graph_.lock (),
+                classifierMaxSize_));
+        return classifier_;
+      }
+
+      void NodeSelector::classifierMaxSize (const std::size_t& size)
+      {
+        checkNotFrozen ();
+        if (size == 0)
+          throw std::invalid_argument ("The decision tree needs a vertex.");
+        classifierMaxSize_ = size;
+        invalidate ();
+      }
+
       NodePtr_t NodeSelector::getNode(ConfigurationIn_t config) const
       {
-        for (Nodes_t::const_iterator it = orderedStates_.begin();
-	     orderedStates_.end() != it; ++it) {
-          if ((*it)->contains(config))
-            return *it;
+        const ClassifierPtr_t& c = classifier ();
+        Classifier::Errors_t errors (c->tests.size (), -1);
+        // The states before the candidate were rejected by one of their
+        // constraints. If the candidate is rejected, the search continues
+        // with the following states, skipping those whose constraints
+        // already failed.
+        for (std::size_t i = c->candidate (config, errors);
+            i < c->states.size (); ++i) {
+          if (c->contains (i, config, errors))
+            return c->states[i];
 	}
 	std::stringstream oss;
 	oss << "A configuration has no node:" << model::displayConfig (config);
@@ -59,8 +365,13 @@ namespace hpp {
 
       EdgePtr_t NodeSelector::chooseEdge(const NodePtr_t& node) const
       {
-        const Neighbors_t neighborPicker = node->neighbors();
-        return neighborPicker ();
+        return node->chooseEdge ();
+      }
+
+      EdgePtr_t NodeSelector::chooseEdge(const NodePtr_t& node,
+          RandomGenerator_t& rng) const
+      {
+        return node->chooseEdge (rng);
       }
 
       std::ostream& NodeSelector::dotPrint (std::ostream& os, dot::DrawingAttributes) const
@@ -16,11 +16,16 @@
 
 #include "hpp/manipulation/graph/node.hh"
 
+#include <cstdlib>
+#include <iterator>
+
 #include <hpp/constraints/differentiable-function.hh>
 
 #include "hpp/manipulation/device.hh"
 #include "hpp/manipulation/graph/edge.hh"
 #include "hpp/manipulation/graph/graph.hh"
+#include "hpp/manipulation/graph/node-selector.hh"
+#include "hpp/manipulation/thread-pool.hh"
 
 namespace hpp {
   namespace manipulation {
@@ -52,9 +57,11 @@ namespace hpp {
 			     const Weight_t& w, const bool& isInNodeFrom,
 			     EdgeFactory create)
       {
+        checkNotFrozen ();
         EdgePtr_t newEdge = create(name, graph_.lock ()->steeringMethod (),
 				   graph_, wkPtr_, to);
         neighbors_.insert (newEdge, w);
+        updateAliasTable ();
         newEdge->isInNodeFrom (isInNodeFrom);
         return newEdge;
       }
@@ -110,25 +117,162 @@ namespace hpp {
       ConstraintSetPtr_t Node::configConstraint() const
       {
         if (!*configConstraints_) {
-          std::string n = "(" + name () + ")";
-          GraphPtr_t g = graph_.lock ();
-          ConstraintSetPtr_t constraint = ConstraintSet::create ((const model::DevicePtr_t&)g->robot (), "Set " + n);
-
-          ConfigProjectorPtr_t proj = ConfigProjector::create((const model::DevicePtr_t&)g->robot(), "proj " + n, g->errorThreshold(), g->maxIterations());
-          g->insertNumericalConstraints (proj);
-          insertNumericalConstraints (proj);
-          constraint->addConstraint (proj);
-
-          g->insertLockedJoints (proj);
-          insertLockedJoints (proj);
-          configConstraints_->set (constraint);
+          configConstraints_->set
+            (buildConfigConstraint (ThreadPool::threadSlot ()));
         }
         return configConstraints_->get ();
       }
 
+      ConstraintSetPtr_t Node::buildConfigConstraint
+      (const std::size_t& slot) const
+      {
+        std::string n = "(" + name () + ")";
+        GraphPtr_t g = graph_.lock ();
+        const core::DevicePtr_t robot = g->robot (slot);
+        ConstraintSetPtr_t constraint = ConstraintSet::create (robot, "Set " + n);
+
+        ConfigProjectorPtr_t proj = ConfigProjector::create(robot, "proj " + n, g->errorThreshold(), g->maxIterations());
+        g->insertNumericalConstraints (proj, slot);
+        insertNumericalConstraints (proj, slot);
+        constraint->addConstraint (proj);
+
+        g->insertLockedJoints (proj, slot);
+        insertLockedJoints (proj, slot);
+        return constraint;
+      }
+
+      void Node::buildConstraints (const std::size_t& slot) const
+      {
+        if (!configConstraints_->isSet (slot))
+          configConstraints_->set (slot, buildConfigConstraint (slot));
+      }
+
+      void Node::instantiateConstraints (const std::size_t& slot,
+          const core::DevicePtr_t& robot) const
+      {
+        GraphComponent::instantiateConstraints (slot, robot);
+        configConstraints_->set (slot, ConstraintSetPtr_t ());
+        PathInstances& instances = pathInstances_.at (slot);
+        instances = PathInstances ();
+        if (!robot) return;
+        for (std::size_t i = 0; i < numericalConstraintsForPath_.size (); ++i)
+          instances.constraints.push_back (instantiate (factoriesForPath_ [i],
+                numericalConstraintsForPath_ [i], robot));
+        instances.set = true;
+      }
+
+      void Node::fixSlots (const std::size_t& nbSlots) const
+      {
+        GraphComponent::fixSlots (nbSlots);
+        configConstraints_->fix (nbSlots);
+        pathInstances_.fix (nbSlots);
+      }
+
+      void Node::addNumericalConstraintForPath
+      (const NumericalConstraintFactory_t& factory,
+       const SizeIntervals_t& passiveDofs)
+      {
+        checkNotFrozen ();
+        GraphPtr_t g = graph_.lock ();
+        if (!g)
+          throw std::logic_error ("Node " + name () + " is not in a graph: "
+              "there is no robot to create the constraint for.");
+        numericalConstraintsForPath_.push_back (factory (g->robot ()));
+        passiveDofsForPath_.push_back (passiveDofs);
+        factoriesForPath_.push_back (factory);
+      }
+
+      bool Node::insertNumericalConstraintsForPath
+      (ConfigProjectorPtr_t& proj) const
+      {
+        return insertNumericalConstraintsForPath
+          (proj, ThreadPool::threadSlot ());
+      }
+
+      bool Node::insertNumericalConstraintsForPath (ConfigProjectorPtr_t& proj,
+          const std::size_t& slot) const
+      {
+        assert (numericalConstraintsForPath_.size () == passiveDofsForPath_.size ());
+        const PathInstances& instances = pathInstances_.at (slot);
+        const NumericalConstraints_t& ncs = instances.set ?
+          instances.constraints : numericalConstraintsForPath_;
+        GraphPtr_t g = graph_.lock ();
+        IntervalsContainer_t::const_iterator itpdofs = passiveDofsForPath_.begin ();
+        for (NumericalConstraints_t::const_iterator it = ncs.begin();
+            it != ncs.end(); it++) {
+          proj->add (g ? g->sharedConstraint (*it) : *it, *itpdofs);
+          itpdofs++;
+        }
+        return !ncs.empty ();
+      }
+
+      void Node::invalidate ()
+      {
+        NodeSelectorPtr_t selector = selector_.lock ();
+        if (selector) selector->invalidate ();
+      }
+
       void Node::updateWeight (const EdgePtr_t& e, const Weight_t& w)
       {
         neighbors_.insert (e, w);
+        updateAliasTable ();
+      }
+
+      void Node::updateAliasTable ()
+      {
+        const std::size_t n = std::distance (neighbors_.begin (),
+            neighbors_.end ());
+        aliasEdges_.resize (n);
+        aliasProbabilities_.assign (n, 0);
+        aliases_.assign (n, 0);
+        const value_type total = (value_type) neighbors_.totalWeight ();
+        if (total == 0) return;
+
+        // Vose's algorithm. Columns are split in under-full and over-full
+        // ones, and each under-full column is completed by an over-full one.
+        std::vector < std::size_t > small, large;
+        std::size_t i = 0;
+        for (Neighbors_t::const_iterator it = neighbors_.begin ();
+            it != neighbors_.end (); ++it, ++i) {
+          aliasEdges_ [i] = it->second;
+          aliasProbabilities_ [i] = (value_type) it->first * n / total;
+          if (aliasProbabilities_ [i] < 1) small.push_back (i);
+          else large.push_back (i);
+        }
+        while (!small.empty () && !large.empty ()) {
+          const std::size_t s = small.back (); small.pop_back ();
+          const std::size_t l = large.back ();
+          aliases_ [s] = l;
+          aliasProbabilities_ [l] -= 1 - aliasProbabilities_ [s];
+          if (aliasProbabilities_ [l] < 1) {
+            large.pop_back ();
+            small.push_back (l);
+          }
+        }
+        // Remaining columns are full, up to rounding errors.
+        for (std::size_t j = 0; j < large.size (); ++j)
+          aliasProbabilities_ [large [j]] = 1;
+        for (std::size_t j = 0; j < small.size (); ++j)
+          aliasProbabilities_ [small [j]] = 1;
+      }
+
+      EdgePtr_t Node::chooseEdge () const
+      {
+        const std::size_t n = aliasEdges_.size ();
+        if (n == 0 || neighbors_.totalWeight () == 0) return EdgePtr_t ();
+        const std::size_t i = rand () % n;
+        const value_type u = (value_type) rand () / ((value_type) RAND_MAX + 1);
+        if (u < aliasProbabilities_ [i]) return aliasEdges_ [i];
+        return aliasEdges_ [aliases_ [i]];
+      }
+
+      EdgePtr_t Node::chooseEdge (RandomGenerator_t& rng) const
+      {
+        const std::size_t n = aliasEdges_.size ();
+        if (n == 0 || neighbors_.totalWeight () == 0) return EdgePtr_t ();
+        const std::size_t i = uniformIndex (rng, n);
+        if (uniform01 (rng) < aliasProbabilities_ [i]) return aliasEdges_ [i];
+        return aliasEdges_ [aliases_ [i]];
       }
     } // namespace graph
   } // namespace manipulation
@@ -16,32 +16,38 @@
 
 #include "hpp/manipulation/graph/statistics.hh"
 
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <map>
+#include <boost/unordered_map.hpp>
+#include <boost/bind.hpp>
+#include <boost/functional/hash.hpp>
+
+#include <hpp/core/connected-component.hh>
+
+#include "hpp/manipulation/roadmap-node.hh"
+
 namespace hpp {
   namespace manipulation {
     namespace graph {
-      LeafBin::LeafBin(const vector_t& v, value_type* thr):
-        value_(v), nodes_(), thr_ (thr)
+      LeafBin::LeafBin(const vector_t& v, value_type* thr,
+          const RoadmapNodeArena* arena):
+        value_(v), nodes_(), arena_ (arena), thr_ (thr), index_ (0)
       {}
 
-      void LeafBin::push_back(const core::NodePtr_t& n)
+      void LeafBin::push_back(const RoadmapNodeArena::Index_t& n)
       {
         nodes_.push_back(n);
       }
 
-      bool LeafBin::operator<(const LeafBin& rhs) const
+      bool LeafBin::operator==(const LeafBin& rhs) const
       {
-        const vector_t& v = rhs.value ();
-        assert (value_.size() == v.size());
-        for (int p = 0; p < value_.size(); p++) {
-          if (std::abs (value_[p] - v[p]) >= *thr_)
-            return value_[p] < v[p];
-        }
-        return false;
+        return contains (rhs.value ());
       }
 
-      bool LeafBin::operator==(const LeafBin& rhs) const
+      bool LeafBin::contains (const vector_t& v) const
       {
-        const vector_t& v = rhs.value ();
         assert (value_.size() == v.size());
         for (int p = 0; p < value_.size(); p++) {
           if (std::abs (value_[p] - v[p]) >= *thr_)
@@ -59,11 +65,12 @@ namespace hpp {
       {
         Parent::print (os) << " (";
         /// Sort by connected component.
-        typedef std::list <RoadmapNodes_t> NodesList_t;
+        typedef std::list <core::Nodes_t> NodesList_t;
         NodesList_t l;
         bool found;
-        for (RoadmapNodes_t::const_iterator itn = nodes_.begin ();
-            itn != nodes_.end (); ++itn) {
+        const RoadmapNodes_t n = nodes ();
+        for (RoadmapNodes_t::const_iterator itn = n.begin ();
+            itn != n.end (); ++itn) {
           found = false;
           for (NodesList_t::iterator itc = l.begin ();
               itc != l.end (); ++itc) {
@@ -74,7 +81,7 @@ namespace hpp {
             }
           }
           if (!found) {
-            l.push_back (RoadmapNodes_t (1, *itn));
+            l.push_back (core::Nodes_t (1, *itn));
           }
         }
         for (NodesList_t::iterator itc = l.begin ();
@@ -96,11 +103,11 @@ namespace hpp {
         return os;
       }
 
-      NodeBin::NodeBin(const NodePtr_t& n):
-        node_(n), roadmapNodes_()
+      NodeBin::NodeBin(const NodePtr_t& n, const RoadmapNodeArena* arena):
+        node_(n), roadmapNodes_(), arena_ (arena)
       {}
 
-      void NodeBin::push_back(const core::NodePtr_t& n)
+      void NodeBin::push_back(const RoadmapNodeArena::Index_t& n)
       {
         roadmapNodes_.push_back(n);
       }
@@ -120,15 +127,21 @@ namespace hpp {
         return node_;
       }
 
+      NodeBin::RoadmapNodes_t NodeBin::nodes () const
+      {
+        return RoadmapNodes_t (roadmapNodes_, arena_);
+      }
+
       std::ostream& NodeBin::print (std::ostream& os) const
       {
         Parent::print (os) << " (";
         /// Sort by connected component.
-        typedef std::list <RoadmapNodes_t> NodesList_t;
+        typedef std::list <core::Nodes_t> NodesList_t;
         NodesList_t l;
         bool found;
-        for (RoadmapNodes_t::const_iterator itn = roadmapNodes_.begin ();
-            itn != roadmapNodes_.end (); ++itn) {
+        const RoadmapNodes_t n = nodes ();
+        for (RoadmapNodes_t::const_iterator itn = n.begin ();
+            itn != n.end (); ++itn) {
           found = false;
           for (NodesList_t::iterator itc = l.begin ();
               itc != l.end (); ++itc) {
@@ -139,7 +152,7 @@ namespace hpp {
             }
           }
           if (!found) {
-            l.push_back (RoadmapNodes_t (1, *itn));
+            l.push_back (core::Nodes_t (1, *itn));
           }
         }
         for (NodesList_t::iterator itc = l.begin ();
@@ -153,35 +166,337 @@ namespace hpp {
         return os << "NodeBin (" << node_->name () << ")";
       }
 
+      /// Number of roadmap nodes per leaf, for all the nodes and for the
+      /// nodes of each connected component, stored in Fenwick trees over
+      /// the indexes of the leaves.
+      ///
+      /// The roadmap does not notify merges of connected components. The
+      /// nodes are therefore counted per connected component at insertion
+      /// time, and a group is merged into the one of its representative
+      /// node when they differ, like the buckets of Roadmap.
+      struct LeafHistogram::Counts
+      {
+        typedef std::size_t Count_t;
+        typedef boost::unordered_map < std::size_t, Count_t > Map_t;
+
+        /// Sparse Fenwick tree.
+        struct Tree {
+          /// Number of nodes per leaf.
+          Map_t leaves;
+          /// Partial sums, indexed from 1.
+          Map_t sums;
+          Count_t total;
+
+          Tree () : leaves (), sums (), total (0) {}
+
+          void add (const std::size_t& leaf, const Count_t& n,
+              const std::size_t& capacity)
+          {
+            leaves [leaf] += n;
+            total += n;
+            addToSums (leaf, n, capacity);
+          }
+
+          void addToSums (const std::size_t& leaf, const Count_t& n,
+              const std::size_t& capacity)
+          {
+            for (std::size_t i = leaf + 1; i <= capacity; i += i & (~i + 1))
+              sums [i] += n;
+          }
+
+          Count_t sum (const std::size_t& i) const
+          {
+            Map_t::const_iterator it = sums.find (i);
+            return it == sums.end () ? 0 : it->second;
+          }
+
+          void rebuild (const std::size_t& capacity)
+          {
+            sums.clear ();
+            for (Map_t::const_iterator it = leaves.begin ();
+                it != leaves.end (); ++it)
+              addToSums (it->first, it->second, capacity);
+          }
+        };
+
+        /// Nodes of a connected component.
+        struct Group {
+          core::NodePtr_t representative;
+          Tree tree;
+
+          Group () : representative (NULL), tree () {}
+        };
+        typedef std::map < core::ConnectedComponentPtr_t, Group > Groups_t;
+
+        /// Number of leaves the trees can index. A power of two.
+        std::size_t capacity;
+        /// A roadmap node of each leaf.
+        std::vector < core::NodePtr_t > representatives;
+        Tree all;
+        Groups_t groups;
+        /// Nodes not sorted by connected component yet, with their leaf.
+        typedef std::vector < std::pair < std::size_t, core::NodePtr_t > >
+          Pending_t;
+        Pending_t pending;
+
+        Counts () : capacity (1), representatives (), all (), groups (),
+          pending ()
+        {}
+
+        /// Register a leaf and return its index.
+        std::size_t addLeaf (const core::NodePtr_t& n)
+        {
+          representatives.push_back (n);
+          if (representatives.size () > capacity) {
+            capacity *= 2;
+            all.rebuild (capacity);
+            for (Groups_t::iterator it = groups.begin ();
+                it != groups.end (); ++it)
+              it->second.tree.rebuild (capacity);
+          }
+          return representatives.size () - 1;
+        }
+
+        /// Merge the groups whose connected component was merged.
+        void updateGroups ()
+        {
+          Groups_t::iterator it = groups.begin ();
+          while (it != groups.end ()) {
+            const core::ConnectedComponentPtr_t cc =
+              it->second.representative->connectedComponent ();
+            if (cc == it->first) {
+              ++it;
+              continue;
+            }
+            Groups_t::iterator target = groups.find (cc);
+            if (target == groups.end ()) {
+              groups [cc] = it->second;
+            } else {
+              const Map_t& leaves = it->second.tree.leaves;
+              for (Map_t::const_iterator l = leaves.begin ();
+                  l != leaves.end (); ++l)
+                target->second.tree.add (l->first, l->second, capacity);
+            }
+            groups.erase (it++);
+          }
+        }
+
+        /// Count a node.
+        /// The connected component of the node is read by the next call to
+        /// sample, since add may run in the statistics thread of the
+        /// roadmap while connected components are merged.
+        void add (const std::size_t& leaf, const core::NodePtr_t& n)
+        {
+          all.add (leaf, 1, capacity);
+          pending.push_back (std::make_pair (leaf, n));
+        }
+
+        /// Sort the pending nodes by connected component.
+        void updatePending ()
+        {
+          updateGroups ();
+          for (Pending_t::const_iterator it = pending.begin ();
+              it != pending.end (); ++it) {
+            Group& g = groups [it->second->connectedComponent ()];
+            if (!g.representative) g.representative = it->second;
+            g.tree.add (it->first, 1, capacity);
+          }
+          pending.clear ();
+        }
+
+        /// \param rng the generator to draw from. If NULL, rand is used.
+        core::NodePtr_t sample (const core::ConnectedComponentPtr_t& cc,
+            RandomGenerator_t* rng)
+        {
+          updatePending ();
+          static const Tree empty;
+          Groups_t::const_iterator it = groups.find (cc);
+          const Tree& in = (it == groups.end () ? empty : it->second.tree);
+          const Count_t total = all.total - in.total;
+          if (total == 0) return core::NodePtr_t ();
+
+          // Find the first leaf whose cumulated count exceeds u.
+          Count_t u = rng ? (Count_t) uniformIndex (*rng, total) :
+            (Count_t) rand () % total;
+          std::size_t pos = 0;
+          for (std::size_t step = capacity; step > 0; step /= 2) {
+            const Count_t w = all.sum (pos + step) - in.sum (pos + step);
+            if (w <= u) {
+              pos += step;
+              u -= w;
+            }
+          }
+          assert (pos < representatives.size ());
+          return representatives [pos];
+        }
+      };
+
       LeafHistogramPtr_t LeafHistogram::create (const Foliation f)
       {
         return LeafHistogramPtr_t (new LeafHistogram (f));
       }
 
+      namespace {
+        /// Ratio between the size of the cells of the LeafHistogram grid
+        /// and the threshold. The larger it is, the fewer parameters are
+        /// close to the border of their cell along several coordinates.
+        const value_type cellSizeRatio = 16;
+        /// Maximal number of coordinates along which the neighbouring
+        /// cells are searched. Beyond, the bins of some neighbouring cells
+        /// are missed and a leaf may be split into several bins.
+        const std::size_t maxNeighborCoordinates = 4;
+        const std::size_t emptyEntry = (std::size_t) -1;
+        const std::size_t initialTableSize = 16;
+      }
+
       LeafHistogram::LeafHistogram (const Foliation f) :
-        f_ (f), threshold_ (0)
+        f_ (f), threshold_ (0), bins_ (), numberOfObservations_ (0),
+        cellSize_ (1), table_ (), counts_ (new Counts)
       {
         ConfigProjectorPtr_t p = f_.parametrizer ();
         if (p) {
           threshold_ = p->errorThreshold () / sqrt(p->rightHandSide ().size ());
         }
+        if (threshold_ > 0) cellSize_ = cellSizeRatio * threshold_;
+        Entry e;
+        e.hash = 0;
+        e.bin = emptyEntry;
+        table_.resize (initialTableSize, e);
       }
 
       void LeafHistogram::add (const core::NodePtr_t& n)
       {
-        if (!f_.contains (*n->configuration())) return;
-	iterator it = insert (LeafBin (f_.parameter (*n->configuration()),
-                              &threshold_));
-        it->push_back (n);
+        vector_t value;
+        if (classify (n, value)) add (n, value);
+      }
+
+      bool LeafHistogram::classify (const core::NodePtr_t& n,
+          vector_t& value) const
+      {
+        return f_.classify (*n->configuration(), value);
+      }
+
+      namespace {
+        bool classifyLeaf (const Foliation& f, const core::NodePtr_t& n,
+            vector_t& value)
+        {
+          return f.classify (*n->configuration (), value);
+        }
+      }
+
+      Histogram::Classifier_t LeafHistogram::classifier
+      (const core::DevicePtr_t& robot) const
+      {
+        Foliation f;
+        f.condition (f_.createCondition (robot));
+        f.parametrizer (f_.createParametrizer (robot));
+        return boost::bind (&classifyLeaf, f, _1, _2);
+      }
+
+      void LeafHistogram::add (const core::NodePtr_t& n,
+          const vector_t& value)
+      {
+        const RoadmapNodeArena::Index_t index = this->index (n);
+        boost::mutex::scoped_lock lock (mutex_);
+        ++numberOfObservations_;
+        const std::size_t i = findBin (value);
+        if (i == bins_.size ()) {
+          bins_.push_back (LeafBin (value, &threshold_, arena_.get ()));
+          bins_.back ().index (counts_->addLeaf (n));
+          insertInTable (i);
+        }
+        LeafBin& bin = bins_ [i];
+        bin.freq ()++;
+        bin.push_back (index);
+        counts_->add (bin.index (), n);
         if (numberOfObservations()%10 == 0) {
-          hppDout (info, *this);
+          hppDout (info, "Leaf histogram of foliation "
+              << f_.condition()->name() << ": " << numberOfObservations ()
+              << " observations in " << numberOfBins () << " leaves.");
+        }
+      }
+
+      LeafHistogram::Cell_t LeafHistogram::cell (const vector_t& value) const
+      {
+        Cell_t c (value.size ());
+        for (size_type i = 0; i < value.size (); ++i)
+          c [i] = (long) std::floor (value [i] / cellSize_);
+        return c;
+      }
+
+      std::size_t LeafHistogram::hash (const Cell_t& cell)
+      {
+        return boost::hash_range (cell.begin (), cell.end ());
+      }
+
+      std::size_t LeafHistogram::findBin (const vector_t& value) const
+      {
+        const Cell_t c = cell (value);
+        // A matching bin is in a neighbouring cell only along the
+        // coordinates close to the border of the cell.
+        std::vector < std::size_t > coords;
+        std::vector < long > directions;
+        for (size_type i = 0; i < value.size ()
+            && coords.size () < maxNeighborCoordinates; ++i) {
+          const value_type offset = value [i] - c [i] * cellSize_;
+          if (offset <= threshold_) {
+            coords.push_back (i);
+            directions.push_back (-1);
+          } else if (cellSize_ - offset <= threshold_) {
+            coords.push_back (i);
+            directions.push_back (1);
+          }
+        }
+        std::size_t best = bins_.size ();
+        const std::size_t mask = table_.size () - 1;
+        Cell_t neighbor (c);
+        for (std::size_t n = 0; n < ((std::size_t) 1 << coords.size ()); ++n) {
+          for (std::size_t k = 0; k < coords.size (); ++k)
+            neighbor [coords [k]] = c [coords [k]] + ((n >> k) & 1 ? directions [k] : 0);
+          const std::size_t h = hash (neighbor);
+          for (std::size_t i = h & mask; table_ [i].bin != emptyEntry;
+              i = (i + 1) & mask) {
+            const Entry& e = table_ [i];
+            if (e.hash == h && e.bin < best && bins_ [e.bin].contains (value))
+              best = e.bin;
+          }
+        }
+        return best;
+      }
+
+      void LeafHistogram::insertInTable (const std::size_t& bin)
+      {
+        // Keep the load factor below one half.
+        if (2 * bins_.size () > table_.size ()) {
+          Table_t old;
+          old.swap (table_);
+          Entry e;
+          e.hash = 0;
+          e.bin = emptyEntry;
+          table_.resize (2 * old.size (), e);
+          const std::size_t mask = table_.size () - 1;
+          for (Table_t::const_iterator it = old.begin (); it != old.end (); ++it) {
+            if (it->bin == emptyEntry) continue;
+            std::size_t i = it->hash & mask;
+            while (table_ [i].bin != emptyEntry) i = (i + 1) & mask;
+            table_ [i] = *it;
+          }
         }
+        const std::size_t mask = table_.size () - 1;
+        Entry e;
+        e.hash = hash (cell (bins_ [bin].value ()));
+        e.bin = bin;
+        std::size_t i = e.hash & mask;
+        while (table_ [i].bin != emptyEntry) i = (i + 1) & mask;
+        table_ [i] = e;
       }
 
       std::ostream& LeafHistogram::print (std::ostream& os) const
       {
         os << "Leaf Histogram of foliation " << f_.condition()->name() << std::endl;
-        return Parent::print (os);
+        for (const_iterator it = begin (); it != end (); ++it)
+          it->print (os) << std::endl;
+        return os << "Total number of observations: " << numberOfObservations ();
       }
 
       HistogramPtr_t LeafHistogram::clone () const
@@ -189,15 +504,42 @@ namespace hpp {
         return HistogramPtr_t (new LeafHistogram (f_));
       }
 
+      bool Histogram::classify (const core::NodePtr_t&, vector_t&) const
+      {
+        return true;
+      }
+
+      Histogram::Classifier_t Histogram::classifier
+      (const core::DevicePtr_t&) const
+      {
+        return boost::bind (&Histogram::classify, this, _1, _2);
+      }
+
+      void Histogram::add (const core::NodePtr_t& node, const vector_t&)
+      {
+        add (node);
+      }
+
+      RoadmapNodeArena::Index_t Histogram::index (const core::NodePtr_t& node) const
+      {
+        if (!arena_)
+          throw std::logic_error ("The histogram is not inserted in a Roadmap.");
+        return roadmapNode (node)->index ();
+      }
+
       NodeHistogram::NodeHistogram (const graph::GraphPtr_t& graph) :
         graph_ (graph) {}
 
       void NodeHistogram::add (const core::NodePtr_t& n)
       {
-        iterator it = insert (NodeBin (graph_->getNode (*n->configuration ())));
-        it->push_back (n);
+        const RoadmapNodeArena::Index_t i = index (n);
+        // The state is cached in the node by Roadmap::push_node.
+        iterator it = insert (NodeBin (graph_->getNode (roadmapNode (n)),
+              arena_.get ()));
+        it->push_back (i);
         if (numberOfObservations()%10 == 0) {
-          hppDout (info, *this);
+          hppDout (info, "Graph node histogram: " << numberOfObservations ()
+              << " observations in " << numberOfBins () << " states.");
         }
       }
 
@@ -220,8 +562,9 @@ namespace hpp {
       unsigned int LeafBin::numberOfObsOutOfConnectedComponent (const core::ConnectedComponentPtr_t& cc) const
       {
         unsigned int count = 0;
-        for (RoadmapNodes_t::const_iterator it = nodes_.begin ();
-            it != nodes_.end (); ++it)
+        const RoadmapNodes_t n = nodes ();
+        for (RoadmapNodes_t::const_iterator it = n.begin ();
+            it != n.end (); ++it)
           if ((*it)->connectedComponent () != cc)
             count++;
         return count;
@@ -240,9 +583,23 @@ namespace hpp {
         return distrib;
       }
 
-      const LeafBin::RoadmapNodes_t& LeafBin::nodes () const
+      core::NodePtr_t LeafHistogram::sampleOutOfConnectedComponent
+      (const core::ConnectedComponentPtr_t& cc) const
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        return counts_->sample (cc, NULL);
+      }
+
+      core::NodePtr_t LeafHistogram::sampleOutOfConnectedComponent
+      (const core::ConnectedComponentPtr_t& cc, RandomGenerator_t& rng) const
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        return counts_->sample (cc, &rng);
+      }
+
+      LeafBin::RoadmapNodes_t LeafBin::nodes () const
       {
-        return nodes_;
+        return RoadmapNodes_t (nodes_, arena_);
       }
 
       bool Foliation::contains (ConfigurationIn_t q) const
@@ -258,6 +615,26 @@ namespace hpp {
         return parametrizer_->rightHandSideFromConfig (q);
       }
 
+      bool Foliation::classify (ConfigurationIn_t q, vector_t& parameter) const
+      {
+        if (!condition_->isSatisfied (q)) return false;
+        parameter = parametrizer_->rightHandSideFromConfig (q);
+        return true;
+      }
+
+      void Foliation::classify (const matrix_t& configs,
+          std::vector <bool>& contains, matrix_t& parameters) const
+      {
+        const size_type n = configs.cols ();
+        contains.resize (n);
+        parameters.resize (parametrizer_->rightHandSide ().size (), n);
+        vector_t p;
+        for (size_type i = 0; i < n; ++i) {
+          contains [i] = classify (configs.col (i), p);
+          if (contains [i]) parameters.col (i) = p;
+        }
+      }
+
       ConfigProjectorPtr_t Foliation::condition () const
       {
         return condition_;
@@ -266,6 +643,23 @@ namespace hpp {
       void Foliation::condition (const ConfigProjectorPtr_t c)
       {
         condition_ = c;
+        conditionFactory_ = ProjectorFactory_t ();
+      }
+
+      void Foliation::condition (const ProjectorFactory_t& factory,
+          const core::DevicePtr_t& robot)
+      {
+        condition_ = factory (robot);
+        conditionFactory_ = factory;
+      }
+
+      ConfigProjectorPtr_t Foliation::createCondition
+      (const core::DevicePtr_t& robot) const
+      {
+        if (conditionFactory_.empty ())
+          throw std::logic_error ("The condition of the foliation was set "
+              "without factory. It cannot be evaluated by several threads.");
+        return conditionFactory_ (robot);
       }
 
       ConfigProjectorPtr_t Foliation::parametrizer () const
@@ -276,6 +670,23 @@ namespace hpp {
       void Foliation::parametrizer (const ConfigProjectorPtr_t p)
       {
         parametrizer_ = p;
+        parametrizerFactory_ = ProjectorFactory_t ();
+      }
+
+      void Foliation::parametrizer (const ProjectorFactory_t& factory,
+          const core::DevicePtr_t& robot)
+      {
+        parametrizer_ = factory (robot);
+        parametrizerFactory_ = factory;
+      }
+
+      ConfigProjectorPtr_t Foliation::createParametrizer
+      (const core::DevicePtr_t& robot) const
+      {
+        if (parametrizerFactory_.empty ())
+          throw std::logic_error ("The parametrizer of the foliation was set "
+              "without factory. It cannot be evaluated by several threads.");
+        return parametrizerFactory_ (robot);
       }
     } // namespace graph
   } // namespace manipulation
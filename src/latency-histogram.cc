@@ -0,0 +1,82 @@
+// Copyright (c) 2015, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#include "hpp/manipulation/latency-histogram.hh"
+
+#include <algorithm>
+
+namespace hpp {
+  namespace manipulation {
+    LatencyHistogram::LatencyHistogram ()
+    {
+      clear ();
+    }
+
+    void LatencyHistogram::clear ()
+    {
+      count_ = 0;
+      total_ = 0;
+      min_ = 0;
+      max_ = 0;
+      std::fill (buckets_, buckets_ + nbBuckets, 0);
+    }
+
+    std::size_t LatencyHistogram::bucketIndex (const value_type& duration)
+    {
+      if (!(duration >= 2e-6)) return 0;
+      std::size_t us = (std::size_t) (duration * 1e6);
+      std::size_t i = 0;
+      while (us > 1 && i < nbBuckets - 1) {
+        us >>= 1;
+        ++i;
+      }
+      return i;
+    }
+
+    void LatencyHistogram::add (const value_type& duration)
+    {
+      if (count_ == 0 || duration < min_) min_ = duration;
+      if (duration > max_) max_ = duration;
+      ++count_;
+      total_ += duration;
+      ++buckets_ [bucketIndex (duration)];
+    }
+
+    void LatencyHistogram::merge (const LatencyHistogram& other)
+    {
+      if (other.count_ == 0) return;
+      if (count_ == 0 || other.min_ < min_) min_ = other.min_;
+      if (other.max_ > max_) max_ = other.max_;
+      count_ += other.count_;
+      total_ += other.total_;
+      for (std::size_t i = 0; i < nbBuckets; ++i)
+        buckets_ [i] += other.buckets_ [i];
+    }
+
+    std::ostream& LatencyHistogram::printJSON (std::ostream& os) const
+    {
+      os << "{\"count\": " << count_ << ", \"total\": " << total_
+        << ", \"mean\": " << mean () << ", \"min\": " << min ()
+        << ", \"max\": " << max_ << ", \"buckets\": [";
+      // Trailing empty buckets are omitted.
+      std::size_t n = nbBuckets;
+      while (n > 0 && buckets_ [n - 1] == 0) --n;
+      for (std::size_t i = 0; i < n; ++i)
+        os << (i > 0 ? ", " : "") << buckets_ [i];
+      return os << "]}";
+    }
+  } // namespace manipulation
+} // namespace hpp
@@ -16,6 +16,20 @@
 
 #include "hpp/manipulation/manipulation-planner.hh"
 
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <sstream>
+#include <stdexcept>
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/lockfree/queue.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
 #include <hpp/util/assertion.hh>
 
 #include <hpp/core/path-validation.hh>
@@ -25,7 +39,14 @@
 #include "hpp/manipulation/graph/statistics.hh"
 #include "hpp/manipulation/device.hh"
 #include "hpp/manipulation/problem.hh"
+#include "hpp/manipulation/roadmap.hh"
+#include "hpp/manipulation/roadmap-node.hh"
+#include "hpp/manipulation/seeded-configuration-shooter.hh"
+#include "hpp/manipulation/graph-steering-method.hh"
+#include "hpp/manipulation/graph-path-validation.hh"
 #include "hpp/manipulation/graph/edge.hh"
+#include "hpp/manipulation/graph/node-selector.hh"
+#include "hpp/manipulation/thread-pool.hh"
 
 namespace hpp {
   namespace manipulation {
@@ -53,78 +74,375 @@ namespace hpp {
       return false;
     }
 
+    namespace {
+      inline boost::posix_time::ptime now ()
+      {
+        return boost::posix_time::microsec_clock::universal_time ();
+      }
+
+      /// Print a string as a JSON string.
+      std::ostream& printJSONString (std::ostream& os, const std::string& s)
+      {
+        os << '"';
+        for (std::string::const_iterator c = s.begin (); c != s.end (); ++c) {
+          switch (*c) {
+            case '"':  os << "\\\""; break;
+            case '\\': os << "\\\\"; break;
+            case '\n': os << "\\n"; break;
+            case '\t': os << "\\t"; break;
+            default:
+              if ((unsigned char) *c < 0x20) continue;
+              os << *c;
+          }
+        }
+        return os << '"';
+      }
+
+      /// Maximal number of nodes tried per connected component by the lazy
+      /// connection, if maxConnectionsPerComponent is not set.
+      const std::size_t lazyConnectionsPerComponent = 5;
+    }
+
+    /// Measure the duration of a stage, from the constructor to stop or to
+    /// the destructor. Does nothing if the latencies are not measured.
+    class ManipulationPlanner::StageTimer
+    {
+      public:
+        StageTimer (ManipulationPlanner& planner, const Stage& stage,
+            const graph::EdgePtr_t& edge = graph::EdgePtr_t ()) :
+          planner_ (planner), stage_ (stage), edge_ (edge),
+          running_ (planner.measureLatencies_)
+        {
+          if (running_) start_ = now ();
+        }
+
+        ~StageTimer ()
+        {
+          stop ();
+        }
+
+        void stop ()
+        {
+          if (!running_) return;
+          running_ = false;
+          planner_.addLatency (stage_, edge_, 1e-6 *
+              (value_type) (now () - start_).total_microseconds ());
+        }
+
+      private:
+        ManipulationPlanner& planner_;
+        Stage stage_;
+        graph::EdgePtr_t edge_;
+        bool running_;
+        boost::posix_time::ptime start_;
+    };
+
+    /// Get the state of a roadmap node, from its cache if possible.
+    inline graph::NodePtr_t getState (const graph::GraphPtr_t& graph,
+        const core::NodePtr_t& node)
+    {
+      RoadmapNodePtr_t n = dynamic_cast <RoadmapNodePtr_t> (node);
+      if (n) return graph->getNode (n);
+      return graph->getNode (*node->configuration ());
+    }
+
+    void ManipulationPlanner::startSolve ()
+    {
+      initializeThreads ();
+      core::PathPlanner::startSolve ();
+      // Extensions of a previous resolution are discarded.
+      if (pipeline_) pipeline_->drain ();
+      // The query nodes may link the lazy edges.
+      lazySearchNeeded_ = true;
+      if (goalDirectedEdgeChoice_) updateCostsToGoal ();
+      core::Nodes_t queryNodes (roadmap ()->goalNodes ());
+      queryNodes.push_front (roadmap ()->initNode ());
+      if (roadmap ()->nodes ().size () <= queryNodes.size ()) return;
+      hppDout (info, "Connecting the query to a roadmap of "
+          << roadmap ()->nodes ().size () << " nodes.");
+      tryConnect (queryNodes);
+      if (lazyConnection_) validateLazyEdges ();
+    }
+
+    namespace {
+      /// Reset the deadline of solve when it returns.
+      struct DeadlineGuard
+      {
+        DeadlineGuard (boost::posix_time::ptime& deadline,
+            const boost::posix_time::ptime& value) : deadline_ (deadline)
+        {
+          deadline_ = value;
+        }
+
+        ~DeadlineGuard ()
+        {
+          deadline_ = boost::posix_time::ptime ();
+        }
+
+        boost::posix_time::ptime& deadline_;
+      };
+    }
+
+    core::PathVectorPtr_t ManipulationPlanner::solve ()
+    {
+      if (timeBudget_ <= 0) return core::PathPlanner::solve ();
+      DeadlineGuard guard (deadline_, now () +
+          boost::posix_time::microseconds ((long) (1e6 * timeBudget_)));
+      startSolve ();
+      tryDirectPath ();
+      while (!roadmap ()->pathExists ()) {
+        if (deadlineReached ()) {
+          std::ostringstream oss;
+          oss << "No path found within " << timeBudget_ << " s, "
+            << roadmap ()->nodes ().size () << " nodes in the roadmap.";
+          throw std::runtime_error (oss.str ());
+        }
+        oneStep ();
+      }
+      return finishSolve (computePath ());
+    }
+
+    bool ManipulationPlanner::deadlineReached () const
+    {
+      return !deadline_.is_not_a_date_time () && now () >= deadline_;
+    }
+
+    void ManipulationPlanner::timeBudget (const value_type& seconds)
+    {
+      if (!(seconds >= 0))
+        throw std::invalid_argument ("The time budget must be positive.");
+      timeBudget_ = seconds;
+    }
+
+    void ManipulationPlanner::seed (const std::size_t& s)
+    {
+      seed_ = s;
+      step_ = 0;
+      rng_.seed (deriveSeed (s, 0, 0));
+      shooter_->seed (deriveSeed (s, 0, 1));
+    }
+
     void ManipulationPlanner::oneStep ()
     {
+      initializeThreads ();
+      ++step_;
+      if (pipeline_) {
+        pipelinedStep ();
+        return;
+      }
       DevicePtr_t robot = HPP_DYNAMIC_PTR_CAST(Device, problem ().robot ());
       HPP_ASSERT(robot);
-      core::Nodes_t newNodes;
-      core::PathPtr_t path;
 
       // Pick a random node
+      StageTimer shootTimer (*this, SHOOT);
       ConfigurationPtr_t q_rand = shooter_->shoot();
+      shootTimer.stop ();
+
+      RoadmapPtr_t r = HPP_DYNAMIC_PTR_CAST (Roadmap, roadmap ());
+      if (r) {
+        // LevelSetEdge samples its targets from the histograms.
+        r->sync ();
+      }
+      const graph::Nodes_t states = extendableStates (r);
 
       // Extend each connected component
-      for (core::ConnectedComponents_t::const_iterator itcc =
-          roadmap ()->connectedComponents ().begin ();
-          itcc != roadmap ()->connectedComponents ().end (); ++itcc) {
-        // Find the nearest neighbor.
-        core::value_type distance;
-        core::NodePtr_t near = roadmap ()->nearestNode (q_rand, *itcc, distance);
-
-        bool pathIsValid = extend (near, q_rand, path);
-        // Insert new path to q_near in roadmap
-        if (pathIsValid) {
-          value_type t_final = path->timeRange ().second;
-          if (t_final != path->timeRange ().first) {
-            ConfigurationPtr_t q_new (new Configuration_t
-                ((*path) (t_final)));
-            if (!belongs (q_new, newNodes)) {
-              newNodes.push_back (roadmap ()->addNodeAndEdges
-                  (near, q_new, path));
-            } else {
-              core::NodePtr_t newNode = roadmap ()->addNode (q_new);
-              roadmap ()->addEdge (near, newNode, path);
-              core::interval_t timeRange = path->timeRange ();
-              roadmap ()->addEdge (newNode, near, path->extract
-                  (core::interval_t (timeRange.second ,
-                                     timeRange.first)));
-            }
+      const ConnectedComponentVector_t ccs
+        (roadmap ()->connectedComponents ().begin (),
+         roadmap ()->connectedComponents ().end ());
+      Extensions_t extensions (ccs.size ());
+      ThreadPool::Task_t task = boost::bind
+        (&ManipulationPlanner::extendConnectedComponent, this, _1,
+         boost::cref (ccs), q_rand, boost::cref (r),
+         boost::cref (states), boost::ref (extensions));
+      if (threadPool_)
+        threadPool_->run (ccs.size (), task);
+      else
+        for (std::size_t i = 0; i < ccs.size (); ++i) task (i);
+
+      insertExtensions (extensions);
+    }
+
+    graph::Nodes_t ManipulationPlanner::extendableStates
+    (const RoadmapPtr_t& r) const
+    {
+      // Only nodes lying in a state with outgoing transitions can be
+      // extended.
+      graph::Nodes_t extendableStates;
+      if (!r) return extendableStates;
+      graph::Nodes_t states = r->states ();
+      for (graph::Nodes_t::const_iterator it = states.begin ();
+          it != states.end (); ++it)
+        if ((*it)->neighbors ().totalWeight () > 0)
+          extendableStates.push_back (*it);
+      return extendableStates;
+    }
+
+    core::NodePtr_t ManipulationPlanner::nearestNode
+    (const ConfigurationPtr_t& q_rand, const core::ConnectedComponentPtr_t& cc,
+     const RoadmapPtr_t& r, const graph::Nodes_t& extendableStates)
+    {
+      core::value_type distance;
+      StageTimer nearestTimer (*this, NEAREST_NEIGHBOR);
+      if (r) return r->nearestNode (q_rand, cc, extendableStates, distance);
+      return roadmap ()->nearestNode (q_rand, cc, distance);
+    }
+
+    void ManipulationPlanner::insertExtensions (const Extensions_t& extensions)
+    {
+      core::Nodes_t newNodes;
+      // Insert new paths to q_near in roadmap, in the order of the connected
+      // components.
+      StageTimer insertTimer (*this, INSERT_IN_ROADMAP);
+      for (Extensions_t::const_iterator itExt = extensions.begin ();
+          itExt != extensions.end (); ++itExt) {
+        if (!itExt->valid) continue;
+        const core::NodePtr_t& near = itExt->near;
+        const core::PathPtr_t& path = itExt->path;
+        value_type t_final = path->timeRange ().second;
+        if (t_final != path->timeRange ().first) {
+          ConfigurationPtr_t q_new (new Configuration_t
+              ((*path) (t_final)));
+          if (!belongs (q_new, newNodes)) {
+            newNodes.push_back (roadmap ()->addNodeAndEdges
+                (near, q_new, path));
+          } else {
+            core::NodePtr_t newNode = roadmap ()->addNode (q_new);
+            roadmap ()->addEdge (near, newNode, path);
+            core::interval_t timeRange = path->timeRange ();
+            roadmap ()->addEdge (newNode, near, path->extract
+                (core::interval_t (timeRange.second ,
+                                   timeRange.first)));
           }
         }
       }
 
+      insertTimer.stop ();
+
+      if (adaptiveEdgeWeights_) updateEdgeWeights ();
+      if (goalDirectedEdgeChoice_) updateCostsToGoal ();
+
       // Try to connect the new nodes together
+      StageTimer connectTimer (*this, CONNECT);
       tryConnect (newNodes);
+      if (lazyConnection_) validateLazyEdges ();
+    }
+
+    void ManipulationPlanner::extendConnectedComponent (const std::size_t& i,
+        const ConnectedComponentVector_t& ccs,
+        const ConfigurationPtr_t& q_rand, const RoadmapPtr_t& r,
+        const graph::Nodes_t& extendableStates, Extensions_t& extensions)
+    {
+      Extension& ext = extensions [i];
+      // The remaining connected components are not extended after the
+      // deadline.
+      if (deadlineReached ()) return;
+      // Find the nearest neighbor.
+      ext.near = nearestNode (q_rand, ccs [i], r, extendableStates);
+      if (!ext.near) return;
+      // The random choices do not depend on the thread.
+      RandomGenerator_t rng (deriveSeed (seed_, step_, i));
+      if (threadPool_) {
+        Configuration_t qProj (q_rand->size ());
+        ext.valid = extend (ext.near, q_rand, ext.path, qProj, rng);
+      } else {
+        ext.valid = extend (ext.near, q_rand, ext.path, qProj_, rng);
+      }
     }
 
     bool ManipulationPlanner::extend(
         const core::NodePtr_t& n_near,
         const ConfigurationPtr_t& q_rand,
         core::PathPtr_t& validPath)
+    {
+      return extend (n_near, q_rand, validPath, qProj_, rng_);
+    }
+
+    bool ManipulationPlanner::extend(
+        const core::NodePtr_t& n_near,
+        const ConfigurationPtr_t& q_rand,
+        core::PathPtr_t& validPath,
+        Configuration_t& qProj,
+        RandomGenerator_t& rng)
     {
       graph::GraphPtr_t graph = problem_.constraintGraph ();
-      PathProjectorPtr_t pathProjector = problem_.pathProjector ();
       // Select next node in the constraint graph.
-      const ConfigurationPtr_t q_near = n_near->configuration ();
-      graph::NodePtr_t node = graph->getNode (*q_near);
+      graph::NodePtr_t node = getState (graph, n_near);
       if (node->neighbors ().totalWeight () == 0) {
         return false;
       }
-      graph::EdgePtr_t edge = graph->chooseEdge (node);
-      qProj_ = *q_rand;
-      if (!edge->applyConstraints (n_near, qProj_)) {
+      graph::EdgePtr_t edge = chooseEdge (node, rng);
+      const boost::posix_time::ptime start = now ();
+      bool valid = extendAlongEdge (edge, n_near, q_rand, validPath, qProj,
+          rng);
+      const boost::posix_time::time_duration duration = now () - start;
+      addTrial (edge, valid && validPath->length () > 0,
+          1e-6 * (value_type) duration.total_microseconds ());
+      return valid;
+    }
+
+    graph::EdgePtr_t ManipulationPlanner::chooseEdge
+    (const graph::NodePtr_t& state, RandomGenerator_t& rng)
+    {
+      StageTimer chooseTimer (*this, CHOOSE_EDGE);
+      graph::EdgePtr_t edge;
+      if (goalDirectedEdgeChoice_ && uniform01 (rng) >= explorationRatio_)
+        edge = edgeTowardGoal (state);
+      if (!edge) edge = problem_.constraintGraph ()->chooseEdge (state, rng);
+      return edge;
+    }
+
+    bool ManipulationPlanner::extendAlongEdge(
+        const graph::EdgePtr_t& edge,
+        const core::NodePtr_t& n_near,
+        const ConfigurationPtr_t& q_rand,
+        core::PathPtr_t& validPath,
+        Configuration_t& qProj,
+        RandomGenerator_t& rng)
+    {
+      const Configuration_t& q_near = *(n_near->configuration ());
+      qProj = *q_rand;
+      if (!applyConstraints (edge, q_near, edge->sampleTarget (n_near, rng),
+            qProj))
+        return false;
+      core::PathPtr_t projPath;
+      if (!buildPath (edge, q_near, qProj, projPath)) return false;
+      validatePath (edge, projPath, validPath);
+      return true;
+    }
+
+    bool ManipulationPlanner::applyConstraints (const graph::EdgePtr_t& edge,
+        const Configuration_t& q_near, const ConfigurationPtr_t& target,
+        Configuration_t& qProj)
+    {
+      StageTimer applyTimer (*this, APPLY_CONSTRAINTS, edge);
+      const bool applied = edge->applyConstraints (q_near, target, qProj);
+      applyTimer.stop ();
+      if (!applied) {
         addFailure (PROJECTION, edge);
         return false;
       }
+      return true;
+    }
+
+    bool ManipulationPlanner::buildPath (const graph::EdgePtr_t& edge,
+        const Configuration_t& q_near, const Configuration_t& qProj,
+        core::PathPtr_t& projPath)
+    {
+      PathProjectorPtr_t pathProjector = problem_.pathProjector ();
       GraphSteeringMethodPtr_t sm = problem_.steeringMethod();
       core::PathPtr_t path;
-      if (!edge->build (path, *q_near, qProj_, *(sm->distance ()))) {
+      StageTimer buildTimer (*this, BUILD_PATH, edge);
+      const bool built = edge->build (path, q_near, qProj, *(sm->distance ()));
+      buildTimer.stop ();
+      if (!built) {
         addFailure (STEERING_METHOD, edge);
         return false;
       }
-      core::PathPtr_t projPath;
       if (pathProjector) {
-        if (!pathProjector->apply (path, projPath)) {
+        StageTimer projectTimer (*this, PROJECT_PATH, edge);
+        const bool projected = pathProjector->apply (path, projPath);
+        projectTimer.stop ();
+        if (!projected) {
           if (!projPath || projPath->length () == 0) {
             addFailure (PATH_PROJECTION_ZERO, edge);
             return false;
@@ -132,21 +450,306 @@ namespace hpp {
           addFailure (PATH_PROJECTION_SHORTER, edge);
         }
       } else projPath = path;
-      GraphPathValidationPtr_t pathValidation (problem_.pathValidation ());
-      pathValidation->validate (projPath, false, validPath);
+      return true;
+    }
+
+    void ManipulationPlanner::validatePath (const graph::EdgePtr_t& edge,
+        const core::PathPtr_t& projPath, core::PathPtr_t& validPath)
+    {
+      const core::PathValidationPtr_t validation (pathValidation ());
+      StageTimer validateTimer (*this, VALIDATE_PATH, edge);
+      validation->validate (projPath, false, validPath);
+      validateTimer.stop ();
       if (validPath->length () == 0)
         addFailure (PATH_VALIDATION, edge);
       else {
+        boost::mutex::scoped_lock lock (statisticsMutex_);
         extendStatistics_.addSuccess ();
         hppDout (info, "Extension:" << std::endl
             << extendStatistics_);
-        graph->getNode ((*validPath) (validPath->length ()));
       }
-      return true;
+    }
+
+    /// Extensions being computed by the workers of the pipeline.
+    struct ManipulationPlanner::Pipeline
+    {
+      /// An extension, with copies of everything the workers need from
+      /// the roadmap. near is only accessed by the thread calling oneStep.
+      struct Job {
+        graph::EdgePtr_t edge;
+        core::NodePtr_t near;
+        Configuration_t qNear;
+        /// See graph::Edge::sampleTarget.
+        ConfigurationPtr_t target;
+        Configuration_t qProj;
+        core::PathPtr_t path, validPath;
+        bool valid;
+        /// Time spent in the stages, in seconds.
+        value_type time;
+        /// Message of the exception thrown by a stage, if any.
+        std::string error;
+      };
+
+      /// Bounded lock-free queue of jobs. The consumers block on a
+      /// condition variable only when it is empty, so that the workers of
+      /// a busy pipeline never lock. It holds at most capacity jobs, the
+      /// number of jobs in the pipeline, so that pushing never blocks.
+      class Queue_t
+      {
+        public:
+          Queue_t (const std::size_t& capacity) :
+            jobs_ (capacity), waiting_ (0), closed_ (false)
+          {}
+
+          void push (Job* job)
+          {
+            while (!jobs_.bounded_push (job)) boost::this_thread::yield ();
+            // A consumer increments waiting_ before checking the queue a
+            // last time, so it either gets the job or this notification.
+            if (waiting_ > 0) {
+              boost::mutex::scoped_lock lock (mutex_);
+              nonEmpty_.notify_one ();
+            }
+          }
+
+          /// Wait for a job.
+          /// \return false if the queue was closed.
+          bool pop (Job*& job)
+          {
+            if (!closed_ && jobs_.pop (job)) return true;
+            boost::mutex::scoped_lock lock (mutex_);
+            ++waiting_;
+            while (!closed_ && !jobs_.pop (job)) nonEmpty_.wait (lock);
+            --waiting_;
+            return !closed_;
+          }
+
+          /// Get a job, if any, without waiting.
+          bool tryPop (Job*& job)
+          {
+            return jobs_.pop (job);
+          }
+
+          /// Wake up the consumers and make pop fail.
+          void close ()
+          {
+            boost::mutex::scoped_lock lock (mutex_);
+            closed_ = true;
+            nonEmpty_.notify_all ();
+          }
+
+          /// Delete the remaining jobs.
+          void clear ()
+          {
+            Job* job;
+            while (jobs_.pop (job)) delete job;
+          }
+
+        private:
+          boost::lockfree::queue < Job* > jobs_;
+          boost::atomic < std::size_t > waiting_;
+          boost::atomic < bool > closed_;
+          boost::mutex mutex_;
+          boost::condition_variable nonEmpty_;
+      };
+
+      Pipeline (ManipulationPlanner& planner,
+          const std::size_t& projectionThreads,
+          const std::size_t& steeringThreads,
+          const std::size_t& validationThreads, const std::size_t& queueSize);
+
+      /// Stop the workers and delete the jobs.
+      ~Pipeline ();
+
+      /// Main loop of the workers of a stage.
+      void work (const Stage stage);
+
+      /// Wait for the jobs in the pipeline and delete them.
+      void drain ();
+
+      ManipulationPlanner& planner;
+      /// Maximal number of jobs in the pipeline.
+      const std::size_t capacity;
+      Queue_t toProject, toBuild, toValidate, done;
+      /// Number of jobs in the pipeline, only accessed by the thread
+      /// calling oneStep.
+      std::size_t inFlight;
+      boost::thread_group threads;
+
+      /// Slots of the workers, set when they start.
+      std::vector < std::size_t > slots;
+      boost::mutex slotsMutex;
+      boost::condition_variable started;
+    };
+
+    ManipulationPlanner::Pipeline::Pipeline (ManipulationPlanner& p,
+        const std::size_t& projectionThreads,
+        const std::size_t& steeringThreads,
+        const std::size_t& validationThreads, const std::size_t& queueSize) :
+      planner (p), capacity (queueSize), toProject (queueSize),
+      toBuild (queueSize), toValidate (queueSize), done (queueSize),
+      inFlight (0)
+    {
+      for (std::size_t i = 0; i < projectionThreads; ++i)
+        threads.create_thread (boost::bind (&Pipeline::work, this,
+              APPLY_CONSTRAINTS));
+      for (std::size_t i = 0; i < steeringThreads; ++i)
+        threads.create_thread (boost::bind (&Pipeline::work, this,
+              BUILD_PATH));
+      for (std::size_t i = 0; i < validationThreads; ++i)
+        threads.create_thread (boost::bind (&Pipeline::work, this,
+              VALIDATE_PATH));
+      const std::size_t n = projectionThreads + steeringThreads
+        + validationThreads;
+      boost::mutex::scoped_lock lock (slotsMutex);
+      while (slots.size () < n) started.wait (lock);
+    }
+
+    ManipulationPlanner::Pipeline::~Pipeline ()
+    {
+      toProject.close ();
+      toBuild.close ();
+      toValidate.close ();
+      threads.join_all ();
+      toProject.clear ();
+      toBuild.clear ();
+      toValidate.clear ();
+      done.clear ();
+    }
+
+    void ManipulationPlanner::Pipeline::work (const Stage stage)
+    {
+      {
+        boost::mutex::scoped_lock lock (slotsMutex);
+        slots.push_back (ThreadPool::threadSlot ());
+      }
+      started.notify_one ();
+      Queue_t& input = (stage == APPLY_CONSTRAINTS) ? toProject :
+        (stage == BUILD_PATH) ? toBuild : toValidate;
+      Job* job;
+      while (input.pop (job)) {
+        const boost::posix_time::ptime start = now ();
+        Queue_t* output = &done;
+        try {
+          switch (stage) {
+            case APPLY_CONSTRAINTS:
+              if (planner.applyConstraints (job->edge, job->qNear,
+                    job->target, job->qProj))
+                output = &toBuild;
+              break;
+            case BUILD_PATH:
+              if (planner.buildPath (job->edge, job->qNear, job->qProj,
+                    job->path))
+                output = &toValidate;
+              break;
+            default:
+              planner.validatePath (job->edge, job->path, job->validPath);
+              job->valid = true;
+          }
+        } catch (const std::exception& e) {
+          job->error = e.what ();
+          output = &done;
+        }
+        job->time += 1e-6 * (value_type) (now () - start).total_microseconds ();
+        output->push (job);
+      }
+    }
+
+    void ManipulationPlanner::Pipeline::drain ()
+    {
+      Job* job;
+      while (inFlight > 0 && done.pop (job)) {
+        --inFlight;
+        delete job;
+      }
+    }
+
+    void ManipulationPlanner::pipeline (const std::size_t& projectionThreads,
+        const std::size_t& steeringThreads,
+        const std::size_t& validationThreads, const std::size_t& queueSize)
+    {
+      pipeline_.reset ();
+      threadsInitialized_ = false;
+      if (projectionThreads == 0 || steeringThreads == 0
+          || validationThreads == 0 || queueSize == 0)
+        return;
+      pipeline_.reset (new Pipeline (*this, projectionThreads,
+            steeringThreads, validationThreads, queueSize));
+    }
+
+    void ManipulationPlanner::pipelinedStep ()
+    {
+      typedef Pipeline::Job Job;
+      Pipeline& p = *pipeline_;
+      graph::GraphPtr_t graph = problem_.constraintGraph ();
+      RoadmapPtr_t r = HPP_DYNAMIC_PTR_CAST (Roadmap, roadmap ());
+      if (r) r->sync ();
+      const graph::Nodes_t states = extendableStates (r);
+      const ConnectedComponentVector_t ccs
+        (roadmap ()->connectedComponents ().begin (),
+         roadmap ()->connectedComponents ().end ());
+
+      // Queue the extensions of each connected component toward random
+      // configurations, while the pipeline has room.
+      std::size_t nbJobs = 0;
+      while (p.inFlight < p.capacity && !deadlineReached ()) {
+        StageTimer shootTimer (*this, SHOOT);
+        ConfigurationPtr_t q_rand = shooter_->shoot ();
+        shootTimer.stop ();
+        std::size_t queued = 0;
+        for (std::size_t i = 0; i < ccs.size () && p.inFlight < p.capacity;
+            ++i) {
+          core::NodePtr_t near = nearestNode (q_rand, ccs [i], r, states);
+          if (!near) continue;
+          graph::NodePtr_t state = getState (graph, near);
+          if (state->neighbors ().totalWeight () == 0) continue;
+          RandomGenerator_t rng (deriveSeed (seed_, step_, nbJobs++));
+          Job* job = new Job;
+          job->edge = chooseEdge (state, rng);
+          job->near = near;
+          job->qNear = *(near->configuration ());
+          job->target = job->edge->sampleTarget (near, rng);
+          job->qProj = *q_rand;
+          job->valid = false;
+          job->time = 0;
+          p.toProject.push (job);
+          ++p.inFlight;
+          ++queued;
+        }
+        if (queued == 0) break;
+      }
+
+      // Insert the extensions completed so far, waiting for at least one.
+      Extensions_t extensions;
+      std::string error;
+      std::size_t nbDone = 0;
+      Job* job;
+      while (p.inFlight > 0) {
+        if (nbDone == 0) p.done.pop (job);
+        else if (!p.done.tryPop (job)) break;
+        --p.inFlight;
+        ++nbDone;
+        if (!job->error.empty ()) {
+          // The other extensions are inserted before throwing.
+          if (error.empty ()) error = job->error;
+        } else {
+          addTrial (job->edge, job->valid && job->validPath->length () > 0,
+              job->time);
+          Extension ext;
+          ext.near = job->near;
+          ext.path = job->validPath;
+          ext.valid = job->valid;
+          extensions.push_back (ext);
+        }
+        delete job;
+      }
+      insertExtensions (extensions);
+      if (!error.empty ()) throw std::runtime_error (error);
     }
 
     void ManipulationPlanner::addFailure (TypeOfFailure t, const graph::EdgePtr_t& edge)
     {
+      boost::mutex::scoped_lock lock (statisticsMutex_);
       EdgeReasonMap::iterator it = failureReasons_.find (edge);
       if (it == failureReasons_.end ()) {
         std::string edgeStr = edge->name () + " - ";
@@ -164,32 +767,218 @@ namespace hpp {
       hppDout (info, "Extension failed." << std::endl << extendStatistics_);
     }
 
+    core::Nodes_t ManipulationPlanner::connectionCandidates
+    (const core::NodePtr_t& node, const graph::Nodes_t& targets,
+     const core::ConnectedComponentPtr_t& cc) const
+    {
+      RoadmapPtr_t r = HPP_DYNAMIC_PTR_CAST (Roadmap, roadmap ());
+      const std::size_t k = (lazyConnection_ && maxConnectionsPerComponent_
+          == 0) ? lazyConnectionsPerComponent : maxConnectionsPerComponent_;
+      if (r)
+        return r->nearestNodes (node->configuration (), cc, targets, k,
+            connectionRadius_);
+      return cc->nodes ();
+    }
+
+    void ManipulationPlanner::addTrial (const graph::EdgePtr_t& edge,
+        const bool& success, const value_type& time)
+    {
+      boost::mutex::scoped_lock lock (statisticsMutex_);
+      EdgeStatistics& s = edgeStatistics_ [edge];
+      ++s.trials;
+      if (success) ++s.successes;
+      s.time += time;
+      statesToUpdate_.insert (edge->from ());
+    }
+
+    void ManipulationPlanner::adaptiveEdgeWeights (const bool& enable)
+    {
+      adaptiveEdgeWeights_ = enable;
+      if (enable) return;
+      for (Weights_t::const_iterator it = priors_.begin ();
+          it != priors_.end (); ++it)
+        it->first->from ()->updateWeight (it->first, it->second);
+      priors_.clear ();
+    }
+
+    void ManipulationPlanner::updateEdgeWeights ()
+    {
+      // Scale of the weights of the edges with the highest score.
+      const value_type scale = 100;
+      boost::mutex::scoped_lock lock (statisticsMutex_);
+      for (std::set < graph::NodePtr_t >::const_iterator itState =
+          statesToUpdate_.begin (); itState != statesToUpdate_.end ();
+          ++itState) {
+        const graph::Neighbors_t& neighbors = (*itState)->neighbors ();
+        // Store the initial weights and the statistics of the state.
+        std::size_t nbTrials = 0;
+        value_type totalTime = 0;
+        for (graph::Neighbors_t::const_iterator it = neighbors.begin ();
+            it != neighbors.end (); ++it) {
+          if (priors_.find (it->second) == priors_.end ())
+            priors_ [it->second] = it->first;
+          const EdgeStatistics& s = edgeStatistics_ [it->second];
+          nbTrials += s.trials;
+          totalTime += s.time;
+        }
+        if (nbTrials == 0) continue;
+        const value_type meanTime = std::max (totalTime / nbTrials,
+            std::numeric_limits <value_type>::epsilon ());
+
+        std::vector < std::pair < graph::EdgePtr_t, value_type > > scores;
+        value_type maxScore = 0;
+        for (graph::Neighbors_t::const_iterator it = neighbors.begin ();
+            it != neighbors.end (); ++it) {
+          const graph::Weight_t prior = priors_ [it->second];
+          if (prior == 0) continue;
+          const EdgeStatistics& s = edgeStatistics_ [it->second];
+          value_type rate = (value_type) (s.successes + 1) / (s.trials + 2)
+            + explorationFactor_ * std::sqrt
+            (std::log ((value_type) nbTrials + 1) / (s.trials + 1));
+          if (rate > 1) rate = 1;
+          const value_type time = (s.trials > 0 && s.time > 0) ?
+            s.time / s.trials : meanTime;
+          const value_type score = prior * rate / time;
+          scores.push_back (std::make_pair (it->second, score));
+          if (score > maxScore) maxScore = score;
+        }
+        for (std::size_t i = 0; i < scores.size (); ++i) {
+          graph::Weight_t w = (graph::Weight_t)
+            (scale * scores [i].second / maxScore + 0.5);
+          (*itState)->updateWeight (scores [i].first, std::max
+              (w, (graph::Weight_t) 1));
+        }
+      }
+      statesToUpdate_.clear ();
+    }
+
+    namespace {
+      value_type edgeCost (const std::map < graph::EdgePtr_t, value_type >&
+          costs, const graph::EdgePtr_t& edge)
+      {
+        std::map < graph::EdgePtr_t, value_type >::const_iterator it =
+          costs.find (edge);
+        if (it == costs.end ())
+          return std::numeric_limits <value_type>::infinity ();
+        return it->second;
+      }
+    }
+
+    void ManipulationPlanner::updateCostsToGoal ()
+    {
+      graph::GraphPtr_t graph = problem_.constraintGraph ();
+      graph::Nodes_t goals;
+      for (core::Nodes_t::const_iterator it = roadmap ()->goalNodes ().begin ();
+          it != roadmap ()->goalNodes ().end (); ++it)
+        goals.push_back (getState (graph, *it));
+      {
+        boost::mutex::scoped_lock lock (statisticsMutex_);
+        edgeCosts_.clear ();
+        const graph::Nodes_t& states = graph->nodeSelector ()->getNodes ();
+        for (graph::Nodes_t::const_iterator itState = states.begin ();
+            itState != states.end (); ++itState) {
+          for (graph::Neighbors_t::const_iterator it =
+              (*itState)->neighbors ().begin ();
+              it != (*itState)->neighbors ().end (); ++it) {
+            EdgeStatisticsMap_t::const_iterator itStat =
+              edgeStatistics_.find (it->second);
+            const std::size_t successes = itStat == edgeStatistics_.end () ?
+              0 : itStat->second.successes;
+            const std::size_t trials = itStat == edgeStatistics_.end () ?
+              0 : itStat->second.trials;
+            edgeCosts_ [it->second] = - std::log
+              ((value_type) (successes + 1) / (trials + 2));
+          }
+        }
+      }
+      costsToGoal_ = graph->costsTo (goals,
+          boost::bind (&edgeCost, boost::cref (edgeCosts_), _1));
+    }
+
+    value_type ManipulationPlanner::costToGoal
+    (const graph::NodePtr_t& state) const
+    {
+      graph::Graph::StateCosts_t::const_iterator it = costsToGoal_.find (state);
+      if (it == costsToGoal_.end ())
+        return std::numeric_limits <value_type>::infinity ();
+      return it->second;
+    }
+
+    graph::EdgePtr_t ManipulationPlanner::edgeTowardGoal
+    (const graph::NodePtr_t& state) const
+    {
+      graph::EdgePtr_t edge;
+      const value_type current = costToGoal (state);
+      value_type best = std::numeric_limits <value_type>::infinity ();
+      for (graph::Neighbors_t::const_iterator it = state->neighbors ().begin ();
+          it != state->neighbors ().end (); ++it) {
+        if (it->first == 0) continue;
+        const value_type remaining = costToGoal (it->second->to ());
+        if (remaining >= current) continue;
+        const value_type cost = edgeCost (edgeCosts_, it->second) + remaining;
+        if (cost < best) {
+          best = cost;
+          edge = it->second;
+        }
+      }
+      return edge;
+    }
+
     inline void ManipulationPlanner::tryConnect (const core::Nodes_t nodes)
     {
-      const core::SteeringMethodPtr_t& sm (problem ().steeringMethod ());
+      GraphSteeringMethodPtr_t sm (problem_.steeringMethod ());
       core::PathValidationPtr_t pathValidation (problem ().pathValidation ());
       PathProjectorPtr_t pathProjector (problem().pathProjector ());
       core::PathPtr_t path, projPath, validPath;
       graph::GraphPtr_t graph = problem_.constraintGraph ();
       bool connectSucceed = false;
+      std::size_t nbTries = 0;
+      if (lazyConnection_) discardStaleLazyEdges ();
       for (core::Nodes_t::const_iterator itn1 = nodes.begin ();
           itn1 != nodes.end (); ++itn1) {
         ConfigurationPtr_t q1 ((*itn1)->configuration ());
+        graph::NodePtr_t s1 = getState (graph, *itn1);
+        // States reachable from s1 by one transition.
+        graph::Nodes_t targets;
+        for (graph::Neighbors_t::const_iterator itEdge =
+            s1->neighbors ().begin ();
+            itEdge != s1->neighbors ().end (); ++itEdge) {
+          graph::NodePtr_t to = itEdge->second->to ();
+          if (std::find (targets.begin (), targets.end (), to) ==
+              targets.end ())
+            targets.push_back (to);
+        }
         connectSucceed = false;
         for (core::ConnectedComponents_t::const_iterator itcc =
             roadmap ()->connectedComponents ().begin ();
             itcc != roadmap ()->connectedComponents ().end (); ++itcc) {
           if (*itcc == (*itn1)->connectedComponent ())
             continue;
-          for (core::Nodes_t::const_iterator itn2 = (*itcc)->nodes().begin ();
-              itn2 != (*itcc)->nodes ().end (); ++itn2) {
+          const core::Nodes_t candidates =
+            connectionCandidates (*itn1, targets, *itcc);
+          for (core::Nodes_t::const_iterator itn2 = candidates.begin ();
+              itn2 != candidates.end (); ++itn2) {
+            if ((connectionBudget_ > 0 && nbTries >= connectionBudget_)
+                || deadlineReached ())
+              return;
+            ++nbTries;
             ConfigurationPtr_t q2 ((*itn2)->configuration ());
             assert (*q1 != *q2);
-            path = (*sm) (*q1, *q2);
+            path = sm->compute (*q1, s1, *q2, getState (graph, *itn2));
             if (!path) continue;
             if (pathProjector) {
               if (!pathProjector->apply (path, projPath)) continue;
             } else projPath = path;
+            if (lazyConnection_) {
+              // Every candidate is kept, so that the others remain when
+              // one of them is found invalid.
+              LazyEdge edge = { *itn1, *itn2, projPath };
+              if (maxLazyEdges_ > 0 && lazyEdges_.size () >= maxLazyEdges_)
+                lazyEdges_.pop_front ();
+              lazyEdges_.push_back (edge);
+              lazySearchNeeded_ = true;
+              continue;
+            }
             if (pathValidation->validate (projPath, false, validPath)) {
               roadmap ()->addEdge (*itn1, *itn2, projPath);
               core::interval_t timeRange = projPath->timeRange ();
@@ -205,12 +994,329 @@ namespace hpp {
       }
     }
 
+    void ManipulationPlanner::validateLazyEdges ()
+    {
+      typedef core::ConnectedComponentPtr_t CC_t;
+      core::PathValidationPtr_t pathValidation (problem ().pathValidation ());
+      core::PathPtr_t validPath;
+      std::size_t nbValid = 0, nbInvalid = 0;
+      discardStaleLazyEdges ();
+      // The roadmap edges may have merged connected components.
+      if (!lazySearchNeeded_ && roadmap ()->edges ().size () == lazySearchEdges_)
+        return;
+      while (!lazyEdges_.empty () && !roadmap ()->pathExists ()) {
+        // The search remains needed.
+        if (deadlineReached ()) return;
+        // Connected components linked by the lazy edges. Edges inside a
+        // connected component are useless and discarded.
+        typedef std::map < CC_t, std::vector < LazyEdges_t::iterator > >
+          Adjacency_t;
+        Adjacency_t adjacency;
+        LazyEdges_t::iterator it = lazyEdges_.begin ();
+        while (it != lazyEdges_.end ()) {
+          const CC_t cc1 = it->from->connectedComponent ();
+          const CC_t cc2 = it->to->connectedComponent ();
+          if (cc1 == cc2) {
+            it = lazyEdges_.erase (it);
+            continue;
+          }
+          adjacency [cc1].push_back (it);
+          adjacency [cc2].push_back (it);
+          ++it;
+        }
+
+        // Breadth first search, from the connected component of the init
+        // node, of the one of a goal node.
+        std::set < CC_t > goals;
+        for (core::Nodes_t::const_iterator itGoal =
+            roadmap ()->goalNodes ().begin ();
+            itGoal != roadmap ()->goalNodes ().end (); ++itGoal)
+          goals.insert ((*itGoal)->connectedComponent ());
+        const CC_t start = roadmap ()->initNode ()->connectedComponent ();
+        std::map < CC_t, LazyEdges_t::iterator > parents;
+        std::set < CC_t > visited;
+        std::deque < CC_t > queue (1, start);
+        visited.insert (start);
+        CC_t reached;
+        while (!queue.empty ()) {
+          const CC_t cc = queue.front ();
+          queue.pop_front ();
+          if (goals.count (cc) > 0) {
+            reached = cc;
+            break;
+          }
+          const std::vector < LazyEdges_t::iterator >& edges = adjacency [cc];
+          for (std::size_t i = 0; i < edges.size (); ++i) {
+            const CC_t next = edges [i]->from->connectedComponent () == cc ?
+              edges [i]->to->connectedComponent () :
+              edges [i]->from->connectedComponent ();
+            if (visited.insert (next).second) {
+              parents [next] = edges [i];
+              queue.push_back (next);
+            }
+          }
+        }
+        if (!reached) break;
+
+        // The connected components change as valid edges are inserted, so
+        // the candidate solution is extracted before validation.
+        std::vector < LazyEdges_t::iterator > solution;
+        for (CC_t cc = reached; cc != start;) {
+          const LazyEdges_t::iterator edge = parents [cc];
+          solution.push_back (edge);
+          cc = edge->from->connectedComponent () == cc ?
+            edge->to->connectedComponent () :
+            edge->from->connectedComponent ();
+        }
+        for (std::size_t i = 0; i < solution.size (); ++i) {
+          const LazyEdge& edge = *solution [i];
+          if (pathValidation->validate (edge.path, false, validPath)) {
+            roadmap ()->addEdge (edge.from, edge.to, edge.path);
+            core::interval_t timeRange = edge.path->timeRange ();
+            roadmap ()->addEdge (edge.to, edge.from, edge.path->extract
+                (core::interval_t (timeRange.second, timeRange.first)));
+            ++nbValid;
+          } else ++nbInvalid;
+          lazyEdges_.erase (solution [i]);
+        }
+      }
+      lazySearchNeeded_ = false;
+      lazySearchEdges_ = roadmap ()->edges ().size ();
+      hppDout (info, "Lazy validation: " << nbValid << " valid and "
+          << nbInvalid << " invalid edges, " << lazyEdges_.size ()
+          << " remaining.");
+    }
+
+    void ManipulationPlanner::discardStaleLazyEdges ()
+    {
+      RoadmapPtr_t r = HPP_DYNAMIC_PTR_CAST (Roadmap, roadmap ());
+      if (!r || r->clearCount () == roadmapClears_) return;
+      lazyEdges_.clear ();
+      roadmapClears_ = r->clearCount ();
+    }
+
     ManipulationPlanner::ManipulationPlanner (const Problem& problem,
         const core::RoadmapPtr_t& roadmap) :
       core::PathPlanner (problem, roadmap),
-      shooter_ (new core::BasicConfigurationShooter (problem.robot ())),
-      problem_ (problem), qProj_ (problem.robot ()->configSize ())
-    {}
+      shooter_ (SeededConfigurationShooter::create (problem.robot ())),
+      problem_ (problem), qProj_ (problem.robot ()->configSize ()),
+      seed_ (0), step_ (0), rng_ (0), timeBudget_ (0), deadline_ (),
+      maxConnectionsPerComponent_ (0),
+      connectionRadius_ (std::numeric_limits <value_type>::infinity ()),
+      connectionBudget_ (0), lazyConnection_ (false), lazyEdges_ (),
+      maxLazyEdges_ (10000), lazySearchNeeded_ (false), lazySearchEdges_ (0),
+      roadmapClears_ (0),
+      goalDirectedEdgeChoice_ (false),
+      explorationRatio_ (.5), edgeCosts_ (), costsToGoal_ (),
+      adaptiveEdgeWeights_ (false),
+      explorationFactor_ (std::sqrt (2.)), measureLatencies_ (false),
+      threadLatencies_ (), otherLatencies_ (new ThreadLatencies),
+      pathValidationFactory_ (), pathValidations_ (),
+      threadsInitialized_ (false), pipeline_ ()
+    {
+      seed (seed_);
+    }
+
+    const char* ManipulationPlanner::stageName (const Stage& stage)
+    {
+      switch (stage) {
+        case SHOOT:             return "shoot";
+        case NEAREST_NEIGHBOR:  return "nearestNeighbor";
+        case CHOOSE_EDGE:       return "chooseEdge";
+        case APPLY_CONSTRAINTS: return "applyConstraints";
+        case BUILD_PATH:        return "buildPath";
+        case PROJECT_PATH:      return "projectPath";
+        case VALIDATE_PATH:     return "validatePath";
+        case INSERT_IN_ROADMAP: return "insertInRoadmap";
+        case CONNECT:           return "connect";
+        case NB_STAGES:         break;
+      }
+      return "unknown";
+    }
+
+    void ManipulationPlanner::addLatency (const Stage& stage,
+        const graph::EdgePtr_t& edge, const value_type& duration)
+    {
+      const std::size_t slot = ThreadPool::threadSlot ();
+      ThreadLatencies& l = (slot < threadLatencies_.size ()
+          && threadLatencies_ [slot]) ? *threadLatencies_ [slot] :
+        *otherLatencies_;
+      boost::mutex::scoped_lock lock (l.mutex);
+      l.stages [stage].add (duration);
+      if (!edge) return;
+      const std::size_t id = (std::size_t) edge->id ();
+      if (id >= l.edges.size ()) l.edges.resize (id + 1);
+      if (l.edges [id].empty ()) l.edges [id].resize (NB_STAGES);
+      l.edges [id][stage].add (duration);
+    }
+
+    void ManipulationPlanner::mergeLatencies (Latencies_t& stages,
+        std::vector < Latencies_t >& edges) const
+    {
+      stages.assign (NB_STAGES, LatencyHistogram ());
+      edges.clear ();
+      std::vector < ThreadLatenciesPtr_t > threads (threadLatencies_);
+      threads.push_back (otherLatencies_);
+      for (std::size_t t = 0; t < threads.size (); ++t) {
+        if (!threads [t]) continue;
+        ThreadLatencies& l = *threads [t];
+        boost::mutex::scoped_lock lock (l.mutex);
+        for (std::size_t i = 0; i < NB_STAGES; ++i)
+          stages [i].merge (l.stages [i]);
+        if (l.edges.size () > edges.size ()) edges.resize (l.edges.size ());
+        for (std::size_t id = 0; id < l.edges.size (); ++id) {
+          if (l.edges [id].empty ()) continue;
+          if (edges [id].empty ()) edges [id].resize (NB_STAGES);
+          for (std::size_t i = 0; i < NB_STAGES; ++i)
+            edges [id][i].merge (l.edges [id][i]);
+        }
+      }
+    }
+
+    LatencyHistogram ManipulationPlanner::latency (const Stage& stage) const
+    {
+      Latencies_t stages;
+      std::vector < Latencies_t > edges;
+      mergeLatencies (stages, edges);
+      return stages [stage];
+    }
+
+    LatencyHistogram ManipulationPlanner::latency (const Stage& stage,
+        const graph::EdgePtr_t& edge) const
+    {
+      Latencies_t stages;
+      std::vector < Latencies_t > edges;
+      mergeLatencies (stages, edges);
+      const std::size_t id = (std::size_t) edge->id ();
+      if (id >= edges.size () || edges [id].empty ())
+        return LatencyHistogram ();
+      return edges [id][stage];
+    }
+
+    void ManipulationPlanner::clearLatencies ()
+    {
+      std::vector < ThreadLatenciesPtr_t > threads (threadLatencies_);
+      threads.push_back (otherLatencies_);
+      for (std::size_t t = 0; t < threads.size (); ++t) {
+        if (!threads [t]) continue;
+        ThreadLatencies& l = *threads [t];
+        boost::mutex::scoped_lock lock (l.mutex);
+        for (std::size_t i = 0; i < NB_STAGES; ++i) l.stages [i].clear ();
+        l.edges.clear ();
+      }
+    }
+
+    std::ostream& ManipulationPlanner::printLatenciesJSON
+    (std::ostream& os) const
+    {
+      Latencies_t stages;
+      std::vector < Latencies_t > edges;
+      mergeLatencies (stages, edges);
+      os << "{\"stages\": {";
+      for (std::size_t i = 0; i < NB_STAGES; ++i) {
+        os << (i > 0 ? ", " : "") << '"' << stageName ((Stage) i) << "\": ";
+        stages [i].printJSON (os);
+      }
+      os << "}, \"edges\": {";
+      bool firstEdge = true;
+      for (std::size_t id = 0; id < edges.size (); ++id) {
+        if (edges [id].empty ()) continue;
+        // The edges of a deleted graph are skipped.
+        const graph::GraphComponentPtr_t edge =
+          graph::GraphComponent::get ((int) id).lock ();
+        if (!edge) continue;
+        if (!firstEdge) os << ", ";
+        firstEdge = false;
+        printJSONString (os, edge->name ()) << ": {";
+        bool first = true;
+        for (std::size_t i = 0; i < NB_STAGES; ++i) {
+          if (edges [id][i].count () == 0) continue;
+          os << (first ? "" : ", ") << '"' << stageName ((Stage) i) << "\": ";
+          edges [id][i].printJSON (os);
+          first = false;
+        }
+        os << "}";
+      }
+      return os << "}}";
+    }
+
+    void ManipulationPlanner::numberOfThreads (const std::size_t& n)
+    {
+      if (n == numberOfThreads ()) return;
+      if (n <= 1) threadPool_.reset ();
+      else threadPool_ = ThreadPool::create (n);
+      threadsInitialized_ = false;
+    }
+
+    std::size_t ManipulationPlanner::numberOfThreads () const
+    {
+      if (threadPool_) return threadPool_->size ();
+      return 1;
+    }
+
+    std::vector < std::size_t > ManipulationPlanner::threadSlots () const
+    {
+      std::vector < std::size_t > slots (1, ThreadPool::threadSlot ());
+      if (threadPool_)
+        slots.insert (slots.end (), threadPool_->slots ().begin (),
+            threadPool_->slots ().end ());
+      if (pipeline_)
+        slots.insert (slots.end (), pipeline_->slots.begin (),
+            pipeline_->slots.end ());
+      return slots;
+    }
+
+    void ManipulationPlanner::initializeThreads ()
+    {
+      if (threadsInitialized_) return;
+      // The workers of the pipeline may still be validating paths.
+      if (pipeline_) pipeline_->drain ();
+      pathValidations_.clear ();
+      graph::GraphPtr_t graph = problem_.constraintGraph ();
+      const std::vector < std::size_t > slots = threadSlots ();
+      // The durations recorded so far are kept.
+      for (std::size_t i = 0; i < slots.size (); ++i) {
+        if (slots [i] >= threadLatencies_.size ())
+          threadLatencies_.resize (slots [i] + 1);
+        if (!threadLatencies_ [slots [i]])
+          threadLatencies_ [slots [i]].reset (new ThreadLatencies);
+      }
+      if (!threadPool_ && !pipeline_) {
+        // A graph initialized by another planner may not know this thread.
+        if (graph->frozen ()) graph->initialize (slots);
+        threadsInitialized_ = true;
+        return;
+      }
+      if (pathValidationFactory_.empty ())
+        throw std::logic_error ("Several threads extend the roadmap. Each of "
+            "them needs a path validation: set pathValidationFactory.");
+      // Only the threads that are new to the graph are initialized.
+      graph->initialize (slots);
+
+      const std::size_t caller = ThreadPool::threadSlot ();
+      const core::ObjectVector_t& obstacles = problem_.collisionObstacles ();
+      for (std::size_t i = 0; i < slots.size (); ++i) {
+        if (slots [i] == caller) continue;
+        GraphPathValidationPtr_t validation =
+          pathValidationFactory_ (graph->robot (slots [i]));
+        validation->constraintGraph (graph);
+        for (core::ObjectVector_t::const_iterator it = obstacles.begin ();
+            it != obstacles.end (); ++it)
+          validation->addObstacle (*it);
+        if (slots [i] >= pathValidations_.size ())
+          pathValidations_.resize (slots [i] + 1);
+        pathValidations_ [slots [i]] = validation;
+      }
+      threadsInitialized_ = true;
+    }
+
+    core::PathValidationPtr_t ManipulationPlanner::pathValidation () const
+    {
+      const std::size_t slot = ThreadPool::threadSlot ();
+      if (slot < pathValidations_.size () && pathValidations_ [slot])
+        return pathValidations_ [slot];
+      return problem_.pathValidation ();
+    }
 
     void ManipulationPlanner::init (const ManipulationPlannerWkPtr_t& weak)
     {
@@ -0,0 +1,203 @@
+// Copyright (c) 2015, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#include "hpp/manipulation/metric-tree.hh"
+
+#include <algorithm>
+
+#include <hpp/core/distance.hh>
+
+namespace hpp {
+  namespace manipulation {
+    namespace {
+      typedef std::pair < value_type, std::size_t > DistanceAndIndex_t;
+
+      bool closer (const DistanceAndIndex_t& a, const DistanceAndIndex_t& b)
+      {
+        return a.first < b.first;
+      }
+
+      bool closerNode (const MetricTree::Neighbors_t::value_type& a,
+          const MetricTree::Neighbors_t::value_type& b)
+      {
+        return a.first < b.first;
+      }
+
+      /// Distance beyond which the nodes are not added to neighbors.
+      value_type bound (const MetricTree::Neighbors_t& neighbors,
+          const std::size_t& k, const value_type& radius)
+      {
+        if (k > 0 && neighbors.size () >= k)
+          return std::min (radius, neighbors.front ().first);
+        return radius;
+      }
+    }
+
+    MetricTree::MetricTree (const core::DistancePtr_t& distance) :
+      distance_ (distance), trees_ (), size_ (0), front_ ()
+    {}
+
+    void MetricTree::insert (const core::NodePtr_t& node)
+    {
+      if (size_ == 0) front_ = node;
+      ++size_;
+      Item item;
+      item.node = node;
+      item.threshold = 0;
+      Tree_t carry (1, item);
+      std::size_t i = 0;
+      for (; i < trees_.size () && !trees_ [i].empty (); ++i) {
+        carry.insert (carry.end (), trees_ [i].begin (), trees_ [i].end ());
+        trees_ [i].clear ();
+      }
+      if (i == trees_.size ()) trees_.resize (i + 1);
+      build (carry, 0, carry.size ());
+      trees_ [i].swap (carry);
+    }
+
+    void MetricTree::merge (const MetricTree& other)
+    {
+      for (std::size_t i = 0; i < other.trees_.size (); ++i)
+        for (std::size_t j = 0; j < other.trees_ [i].size (); ++j)
+          insert (other.trees_ [i][j].node);
+    }
+
+    void MetricTree::clear ()
+    {
+      trees_.clear ();
+      size_ = 0;
+      front_ = core::NodePtr_t ();
+    }
+
+    core::Nodes_t MetricTree::nodes () const
+    {
+      core::Nodes_t nodes;
+      for (std::size_t i = 0; i < trees_.size (); ++i)
+        for (std::size_t j = 0; j < trees_ [i].size (); ++j)
+          nodes.push_back (trees_ [i][j].node);
+      return nodes;
+    }
+
+    value_type MetricTree::distance (const core::NodePtr_t& node,
+        ConfigurationIn_t configuration) const
+    {
+      return (*distance_) (*node->configuration (), configuration);
+    }
+
+    void MetricTree::build (Tree_t& tree, const std::size_t& begin,
+        const std::size_t& end) const
+    {
+      if (end - begin <= 1) return;
+      // The first item is the vantage point. Sort the others by distance
+      // to it around the median.
+      const Configuration_t& vantage = *tree [begin].node->configuration ();
+      std::vector < DistanceAndIndex_t > d (end - begin - 1);
+      for (std::size_t i = begin + 1; i < end; ++i)
+        d [i - begin - 1] = DistanceAndIndex_t
+          ((*distance_) (*tree [i].node->configuration (), vantage), i);
+      const std::size_t half = d.size () / 2;
+      std::nth_element (d.begin (), d.begin () + half, d.end (), closer);
+      Tree_t sorted (d.size ());
+      for (std::size_t i = 0; i < d.size (); ++i)
+        sorted [i] = tree [d [i].second];
+      std::copy (sorted.begin (), sorted.end (), tree.begin () + begin + 1);
+      tree [begin].threshold = d [half].first;
+
+      const std::size_t mid = begin + 1 + half;
+      build (tree, begin + 1, mid);
+      build (tree, mid, end);
+    }
+
+    void MetricTree::nearest (ConfigurationIn_t configuration,
+        core::NodePtr_t& nearest, value_type& minDistance) const
+    {
+      for (std::size_t i = 0; i < trees_.size (); ++i)
+        search (trees_ [i], 0, trees_ [i].size (), configuration, nearest,
+            minDistance);
+    }
+
+    void MetricTree::nearest (ConfigurationIn_t configuration,
+        const std::size_t& k, const value_type& radius,
+        Neighbors_t& neighbors) const
+    {
+      for (std::size_t i = 0; i < trees_.size (); ++i)
+        search (trees_ [i], 0, trees_ [i].size (), configuration, k, radius,
+            neighbors);
+    }
+
+    void MetricTree::keep (Neighbors_t& neighbors, const std::size_t& k,
+        const value_type& distance, const core::NodePtr_t& node)
+    {
+      if (k == 0 || neighbors.size () < k) {
+        neighbors.push_back (std::make_pair (distance, node));
+        std::push_heap (neighbors.begin (), neighbors.end (), closerNode);
+      } else if (distance < neighbors.front ().first) {
+        std::pop_heap (neighbors.begin (), neighbors.end (), closerNode);
+        neighbors.back () = std::make_pair (distance, node);
+        std::push_heap (neighbors.begin (), neighbors.end (), closerNode);
+      }
+    }
+
+    void MetricTree::search (const Tree_t& tree, const std::size_t& begin,
+        const std::size_t& end, ConfigurationIn_t configuration,
+        const std::size_t& k, const value_type& radius,
+        Neighbors_t& neighbors) const
+    {
+      if (begin >= end) return;
+      const Item& item = tree [begin];
+      const value_type d = distance (item.node, configuration);
+      if (d <= radius) keep (neighbors, k, d, item.node);
+      const std::size_t mid = begin + 1 + (end - begin - 1) / 2;
+      // See search (const Tree_t&, const std::size_t&, const std::size_t&,
+      // ConfigurationIn_t, core::NodePtr_t&, value_type&) const.
+      if (d <= item.threshold) {
+        search (tree, begin + 1, mid, configuration, k, radius, neighbors);
+        if (d + bound (neighbors, k, radius) >= item.threshold)
+          search (tree, mid, end, configuration, k, radius, neighbors);
+      } else {
+        search (tree, mid, end, configuration, k, radius, neighbors);
+        if (d - bound (neighbors, k, radius) <= item.threshold)
+          search (tree, begin + 1, mid, configuration, k, radius, neighbors);
+      }
+    }
+
+    void MetricTree::search (const Tree_t& tree, const std::size_t& begin,
+        const std::size_t& end, ConfigurationIn_t configuration,
+        core::NodePtr_t& nearest, value_type& minDistance) const
+    {
+      if (begin >= end) return;
+      const Item& item = tree [begin];
+      const value_type d = distance (item.node, configuration);
+      if (d < minDistance) {
+        minDistance = d;
+        nearest = item.node;
+      }
+      const std::size_t mid = begin + 1 + (end - begin - 1) / 2;
+      // By the triangle inequality, the nodes of the inner half are at
+      // least at d - threshold and those of the outer half at
+      // threshold - d. Search first the half containing configuration.
+      if (d <= item.threshold) {
+        search (tree, begin + 1, mid, configuration, nearest, minDistance);
+        if (d + minDistance >= item.threshold)
+          search (tree, mid, end, configuration, nearest, minDistance);
+      } else {
+        search (tree, mid, end, configuration, nearest, minDistance);
+        if (d - minDistance <= item.threshold)
+          search (tree, begin + 1, mid, configuration, nearest, minDistance);
+      }
+    }
+  } // namespace manipulation
+} // namespace hpp
@@ -124,9 +124,20 @@ namespace hpp {
     {
       if (!problem ())
         throw std::runtime_error ("The problem is not defined.");
+      const core::PathValidationPtr_t validation =
+        problem ()->core::Problem::pathValidation ();
+      if (multiQuery_ && roadmap () && roadmapGraph_ == constraintGraph_
+          && roadmapValidation_ == validation) {
+        hppDout (info, "Keeping the roadmap of " << roadmap ()->nodes ().size ()
+            << " nodes for the next query.");
+        roadmap ()->resetGoalNodes ();
+        return;
+      }
       RoadmapPtr_t r (Roadmap::create (problem ()->distance (), problem ()->robot ()));
       if (constraintGraph_) r->constraintGraph (constraintGraph_);
       roadmap (r);
+      roadmapGraph_ = constraintGraph_;
+      roadmapValidation_ = validation;
     }
   } // namespace manipulation
 } // namespace hpp
@@ -16,12 +16,220 @@
 
 #include "hpp/manipulation/roadmap.hh"
 
+#include <limits>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
 #include <hpp/util/pointer.hh>
 
+#include <hpp/core/distance.hh>
+#include <hpp/core/weighed-distance.hh>
+#include <hpp/core/connected-component.hh>
+#include <hpp/core/edge.hh>
+#include <hpp/core/path.hh>
+#include <hpp/core/path-vector.hh>
+#include <hpp/core/path-projector.hh>
+#include <hpp/core/path-validation.hh>
+
+#include "hpp/manipulation/device.hh"
+#include "hpp/manipulation/graph/graph.hh"
+#include "hpp/manipulation/graph/node.hh"
+#include "hpp/manipulation/graph/edge.hh"
+#include "hpp/manipulation/graph/node-selector.hh"
+#include "hpp/manipulation/roadmap-node.hh"
+
 namespace hpp {
   namespace manipulation {
+    namespace {
+      /// Capacity of the queue of the statistics thread. push_node waits
+      /// when it is full.
+      const std::size_t statQueueSize = 1024;
+
+      /// Header of the files written by Roadmap::save. It is followed by
+      /// \li the names of the states and of the edges of the constraint
+      ///     graph, each one as its length and its characters,
+      /// \li the configurations of the nodes,
+      /// \li the index of the state of each node in the names,
+      /// \li the edges of the roadmap.
+      /// Each section starts at a multiple of 8 bytes.
+      struct FileHeader {
+        char magic [8];
+        boost::uint32_t version;
+        /// fileByteOrder, in the byte order of the writer.
+        boost::uint32_t byteOrder;
+        boost::uint64_t configSize;
+        boost::uint64_t nbNodes;
+        boost::uint64_t nbEdges;
+        boost::uint64_t nbStateNames;
+        boost::uint64_t nbEdgeNames;
+        /// Size in bytes of the names, padding included.
+        boost::uint64_t namesSize;
+      };
+
+      struct EdgeRecord {
+        boost::uint64_t from;
+        boost::uint64_t to;
+        /// Index of the edge of the constraint graph in the edge names.
+        boost::uint32_t edge;
+        /// Whether the roadmap also contains the reverse edge.
+        boost::uint16_t bothWays;
+        /// Whether the edge of the constraint graph goes from the state of
+        /// to to the one of from. Its path is then built from to to from
+        /// and reversed.
+        boost::uint16_t backward;
+      };
+
+      const char fileMagic [8] = { 'H', 'P', 'P', 'M', 'R', 'M', 'A', 'P' };
+      const boost::uint32_t fileVersion = 2;
+      const boost::uint32_t fileByteOrder = 0x01020304;
+      const boost::uint32_t noName =
+        std::numeric_limits <boost::uint32_t>::max ();
+
+      std::size_t padding (const std::size_t& size)
+      {
+        return (8 - size % 8) % 8;
+      }
+
+      void write (std::ostream& os, const void* data, const std::size_t& size)
+      {
+        os.write (static_cast <const char*> (data), size);
+      }
+
+      void writePadding (std::ostream& os, const std::size_t& size)
+      {
+        const char zeros [8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+        os.write (zeros, padding (size));
+      }
+
+      /// Index the names of graph components in the order of first use.
+      template < typename ComponentPtr_t > struct Names
+      {
+        typedef std::map < ComponentPtr_t, boost::uint32_t > Indexes_t;
+
+        boost::uint32_t operator() (const ComponentPtr_t& c)
+        {
+          if (!c) return noName;
+          std::pair < typename Indexes_t::iterator, bool > res =
+            indexes.insert (std::make_pair (c, (boost::uint32_t) names.size ()));
+          if (res.second) names.push_back (c->name ());
+          return res.first->second;
+        }
+
+        void write (std::string& buffer) const
+        {
+          for (std::size_t i = 0; i < names.size (); ++i) {
+            boost::uint32_t length = (boost::uint32_t) names [i].size ();
+            buffer.append (reinterpret_cast <const char*> (&length),
+                sizeof (length));
+            buffer.append (names [i]);
+          }
+        }
+
+        Indexes_t indexes;
+        std::vector < std::string > names;
+      };
+
+      /// Read names written by Names::write.
+      /// \param[in,out] data position of the first name, moved after the
+      ///                 last one.
+      std::vector < std::string > readNames (const char*& data,
+          const char* end, const std::size_t& n)
+      {
+        std::vector < std::string > names (n);
+        for (std::size_t i = 0; i < n; ++i) {
+          boost::uint32_t length;
+          if (end - data < (std::ptrdiff_t) sizeof (length))
+            throw std::runtime_error ("Roadmap file is corrupted.");
+          std::memcpy (&length, data, sizeof (length));
+          data += sizeof (length);
+          if (end - data < (std::ptrdiff_t) length)
+            throw std::runtime_error ("Roadmap file is corrupted.");
+          names [i].assign (data, length);
+          data += length;
+        }
+        return names;
+      }
+
+      /// Names of the constraint sets of the paths composing a path.
+      /// The paths of waypoint edges and of path projectors are path
+      /// vectors, whose constraints are the ones of their sub-paths.
+      void constraintNames (const core::PathPtr_t& path,
+          std::set < std::string >& names)
+      {
+        core::PathVectorPtr_t pv =
+          HPP_DYNAMIC_PTR_CAST (core::PathVector, path);
+        if (pv) {
+          for (std::size_t i = 0; i < pv->numberPaths (); ++i)
+            constraintNames (pv->pathAtRank (i), names);
+          return;
+        }
+        ConstraintSetPtr_t constraints = path->constraints ();
+        if (constraints) names.insert (constraints->name ());
+      }
+
+      /// Edge of the constraint graph that built the path of a roadmap
+      /// edge.
+      /// The paths of the edges of the constraint graph are constrained by
+      /// their path constraint, which identifies the edge among the ones
+      /// linking the states of the roadmap nodes. The path of a waypoint
+      /// edge ends with a path constrained by the waypoint edge.
+      /// \retval backward whether the edge of the constraint graph goes
+      ///         from the state of edge->to () to the one of edge->from ().
+      /// \throw std::runtime_error if no edge of the constraint graph built
+      ///        the path.
+      graph::EdgePtr_t graphEdge (const graph::GraphPtr_t& graph,
+          const core::EdgePtr_t& edge, bool& backward)
+      {
+        graph::NodePtr_t from =
+          graph->getNode (roadmapNode (edge->from ()));
+        graph::NodePtr_t to =
+          graph->getNode (roadmapNode (edge->to ()));
+        std::set < std::string > names;
+        constraintNames (edge->path (), names);
+        if (!names.empty ()) {
+          // The reverse edges of the roadmap are built by the edge of the
+          // constraint graph going the other way.
+          for (std::size_t i = 0; i < 2; ++i) {
+            backward = (i == 1);
+            const graph::Edges_t candidates = backward ?
+              graph->getEdges (to, from) : graph->getEdges (from, to);
+            for (graph::Edges_t::const_iterator it = candidates.begin ();
+                it != candidates.end (); ++it)
+              if (names.count (graph->pathConstraint (*it)->name ()))
+                return *it;
+          }
+        }
+        throw std::runtime_error ("An edge of the roadmap was not built by "
+            "the constraint graph.");
+      }
+
+      core::PathPtr_t reversed (const core::PathPtr_t& path)
+      {
+        core::interval_t timeRange = path->timeRange ();
+        return path->extract
+          (core::interval_t (timeRange.second, timeRange.first));
+      }
+    }
+
     Roadmap::Roadmap (const core::DistancePtr_t& distance, const core::DevicePtr_t& robot) :
-      core::Roadmap (distance, robot) {}
+      core::Roadmap (distance, robot), statQueue_ (statQueueSize),
+      statThread_ (), statPushed_ (0), statProcessed_ (0), statStop_ (false),
+      robot_ (robot), statRobot_ (), statClassifiers_ (),
+      nodeArena_ (RoadmapNodeArena::create ()),
+      graph_ (), loadedState_ (), distance_ (distance), stateIndex_ (),
+      clearCount_ (0) {}
+
+    Roadmap::~Roadmap ()
+    {
+      asynchronousStatistics (false);
+    }
 
     RoadmapPtr_t Roadmap::create (const core::DistancePtr_t& distance, const core::DevicePtr_t& robot)
     {
@@ -30,36 +238,281 @@ namespace hpp {
 
     void Roadmap::clear ()
     {
+      sync ();
       Parent::clear ();
+      nodeArena_->clear ();
       Histograms newHistograms;
       Histograms::iterator it;
       for (it = histograms_.begin(); it != histograms_.end(); ++it) {
         newHistograms.push_back ((*it)->clone ());
+        newHistograms.back ()->nodeArena (nodeArena_);
       }
       histograms_ = newHistograms;
+      statCreateClassifiers ();
+      stateIndex_.clear ();
+      ++clearCount_;
+    }
+
+    core::NodePtr_t Roadmap::createNode
+      (const ConfigurationPtr_t& configuration) const
+    {
+      return new RoadmapNode (configuration);
     }
 
     void Roadmap::push_node (const core::NodePtr_t& n)
     {
-      statInsert (n);
+      RoadmapNodePtr_t node = roadmapNode (n);
+      if (loadedState_) node->graphNode (loadedState_);
+      if (graph_) graph_->getNode (node);
+      nodeArena_->push_back (node);
+      if (statThread_) {
+        // The statistics thread classifies the node on its copy of the
+        // robot.
+        StatisticsJob* job = new StatisticsJob;
+        job->node = n;
+        while (!statQueue_.push (job)) boost::this_thread::yield ();
+        ++statPushed_;
+        // The thread checks the queue under the mutex before waiting, so
+        // that this notification cannot be missed.
+        boost::mutex::scoped_lock lock (statMutex_);
+        statAvailable_.notify_one ();
+      } else {
+        StatisticsJob job;
+        statClassify (n, job);
+        statInsert (job);
+      }
       Parent::push_node (n);
+      if (graph_) addToIndex (n, node->graphNode ());
+    }
+
+    void Roadmap::addToIndex (const core::NodePtr_t& node,
+        const graph::NodePtr_t& state)
+    {
+      ConnectedComponentBuckets_t& buckets = stateIndex_ [state];
+      updateBuckets (buckets);
+      ConnectedComponentBuckets_t::iterator it =
+        buckets.find (node->connectedComponent ());
+      if (it == buckets.end ())
+        it = buckets.insert (std::make_pair (node->connectedComponent (),
+              MetricTree (distance_))).first;
+      it->second.insert (node);
+    }
+
+    void Roadmap::updateBuckets (ConnectedComponentBuckets_t& buckets)
+    {
+      ConnectedComponentBuckets_t::iterator it = buckets.begin ();
+      while (it != buckets.end ()) {
+        ConnectedComponentPtr_t cc = it->second.front ()->connectedComponent ();
+        if (cc == it->first) {
+          ++it;
+          continue;
+        }
+        ConnectedComponentBuckets_t::iterator target = buckets.find (cc);
+        if (target == buckets.end ())
+          buckets.insert (std::make_pair (cc, it->second));
+        else {
+          // Insert the nodes of the smaller index in the larger one.
+          if (target->second.size () < it->second.size ())
+            std::swap (target->second, it->second);
+          target->second.merge (it->second);
+        }
+        buckets.erase (it++);
+      }
+    }
+
+    core::NodePtr_t Roadmap::nearestNode (const ConfigurationPtr_t& configuration,
+        const ConnectedComponentPtr_t& connectedComponent,
+        const graph::NodePtr_t& state, value_type& minDistance) const
+    {
+      return nearestNode (configuration, connectedComponent,
+          graph::Nodes_t (1, state), minDistance);
+    }
+
+    core::NodePtr_t Roadmap::nearestNode (const ConfigurationPtr_t& configuration,
+        const ConnectedComponentPtr_t& connectedComponent,
+        const graph::Nodes_t& states, value_type& minDistance) const
+    {
+      if (!graph_)
+        return Parent::nearestNode (configuration, connectedComponent,
+            minDistance);
+      core::NodePtr_t nearest = core::NodePtr_t ();
+      minDistance = std::numeric_limits <value_type>::infinity ();
+      for (graph::Nodes_t::const_iterator itState = states.begin ();
+          itState != states.end (); ++itState) {
+        StateIndex_t::const_iterator buckets = stateIndex_.find (*itState);
+        if (buckets == stateIndex_.end ()) continue;
+        // Buckets whose connected component was merged are not sorted yet.
+        for (ConnectedComponentBuckets_t::const_iterator it =
+            buckets->second.begin (); it != buckets->second.end (); ++it) {
+          if (it->second.front ()->connectedComponent () == connectedComponent)
+            it->second.nearest (*configuration, nearest, minDistance);
+        }
+      }
+      return nearest;
+    }
+
+    namespace {
+      bool closer (const MetricTree::Neighbors_t::value_type& a,
+          const MetricTree::Neighbors_t::value_type& b)
+      {
+        return a.first < b.first;
+      }
+    }
+
+    core::Nodes_t Roadmap::nearestNodes (const ConfigurationPtr_t& configuration,
+        const ConnectedComponentPtr_t& connectedComponent,
+        const graph::Nodes_t& states, const std::size_t& k,
+        const value_type& radius) const
+    {
+      // The buckets share the heap of the nearest nodes, so that each one
+      // is only searched closer than the k-th nearest node found so far.
+      MetricTree::Neighbors_t neighbors;
+      if (!graph_) {
+        // The nodes are not indexed.
+        for (core::Nodes_t::const_iterator it =
+            connectedComponent->nodes ().begin ();
+            it != connectedComponent->nodes ().end (); ++it) {
+          const value_type d = (*distance_)
+            (*(*it)->configuration (), *configuration);
+          if (d <= radius) MetricTree::keep (neighbors, k, d, *it);
+        }
+      } else {
+        for (graph::Nodes_t::const_iterator itState = states.begin ();
+            itState != states.end (); ++itState) {
+          StateIndex_t::const_iterator buckets = stateIndex_.find (*itState);
+          if (buckets == stateIndex_.end ()) continue;
+          for (ConnectedComponentBuckets_t::const_iterator it =
+              buckets->second.begin (); it != buckets->second.end (); ++it) {
+            if (it->second.front ()->connectedComponent () ==
+                connectedComponent)
+              it->second.nearest (*configuration, k, radius, neighbors);
+          }
+        }
+      }
+      std::sort_heap (neighbors.begin (), neighbors.end (), closer);
+      core::Nodes_t nodes;
+      for (std::size_t i = 0; i < neighbors.size (); ++i)
+        nodes.push_back (neighbors [i].second);
+      return nodes;
+    }
+
+    graph::Nodes_t Roadmap::states () const
+    {
+      graph::Nodes_t states;
+      for (StateIndex_t::const_iterator it = stateIndex_.begin ();
+          it != stateIndex_.end (); ++it)
+        states.push_back (it->first);
+      return states;
+    }
+
+    void Roadmap::statClassify (const core::NodePtr_t& n,
+        StatisticsJob& job) const
+    {
+      job.node = n;
+      job.added.resize (histograms_.size ());
+      job.values.resize (histograms_.size ());
+      std::size_t i = 0;
+      Histograms::const_iterator it;
+      for (it = histograms_.begin(); it != histograms_.end(); ++it, ++i)
+        job.added [i] = (*it)->classify (n, job.values [i]);
     }
 
-    void Roadmap::statInsert (const core::NodePtr_t& n)
+    void Roadmap::statInsert (const StatisticsJob& job)
     {
+      std::size_t i = 0;
       Histograms::iterator it;
-      for (it = histograms_.begin(); it != histograms_.end(); ++it) {
-        (*it)->add (n);
+      for (it = histograms_.begin(); it != histograms_.end(); ++it, ++i) {
+        if (job.added [i]) (*it)->add (job.node, job.values [i]);
+      }
+    }
+
+    void Roadmap::statCreateClassifiers ()
+    {
+      Classifiers_t classifiers;
+      if (statRobot_) {
+        Histograms::const_iterator it;
+        for (it = histograms_.begin(); it != histograms_.end(); ++it)
+          classifiers.push_back ((*it)->classifier (statRobot_));
+      }
+      statClassifiers_.swap (classifiers);
+    }
+
+    void Roadmap::asynchronousStatistics (const bool& enable)
+    {
+      if (enable == (bool) statThread_) return;
+      if (enable) {
+        statRobot_ = robot_->clone ();
+        try {
+          statCreateClassifiers ();
+        } catch (...) {
+          statRobot_.reset ();
+          throw;
+        }
+        statStop_ = false;
+        statThread_.reset (new boost::thread
+            (boost::bind (&Roadmap::processStatistics, this)));
+        return;
+      }
+      {
+        boost::mutex::scoped_lock lock (statMutex_);
+        statStop_ = true;
+      }
+      statAvailable_.notify_one ();
+      // The thread empties the queue before returning.
+      statThread_->join ();
+      statThread_.reset ();
+      statRobot_.reset ();
+      statCreateClassifiers ();
+    }
+
+    void Roadmap::sync ()
+    {
+      if (!statThread_) return;
+      boost::mutex::scoped_lock lock (statMutex_);
+      while (statProcessed_ < statPushed_) statDone_.wait (lock);
+    }
+
+    void Roadmap::processStatistics ()
+    {
+      StatisticsJob* job;
+      while (true) {
+        std::size_t processed = 0;
+        while (statQueue_.pop (job)) {
+          job->added.resize (statClassifiers_.size ());
+          job->values.resize (statClassifiers_.size ());
+          for (std::size_t i = 0; i < statClassifiers_.size (); ++i)
+            job->added [i] = statClassifiers_ [i] (job->node, job->values [i]);
+          statInsert (*job);
+          delete job;
+          ++processed;
+        }
+        boost::mutex::scoped_lock lock (statMutex_);
+        if (processed > 0) {
+          statProcessed_ += processed;
+          statDone_.notify_all ();
+        }
+        while (statQueue_.read_available () == 0 && !statStop_)
+          statAvailable_.wait (lock);
+        // The queue is emptied before stopping.
+        if (statQueue_.read_available () == 0) return;
       }
     }
 
     void Roadmap::insertHistogram (const graph::HistogramPtr_t hist)
     {
+      sync ();
+      // Create the classifier first, so that the roadmap is not modified
+      // if it throws.
+      graph::Histogram::Classifier_t classifier;
+      if (statRobot_) classifier = hist->classifier (statRobot_);
+      hist->nodeArena (nodeArena_);
       histograms_.push_back (hist);
+      if (statRobot_) statClassifiers_.push_back (classifier);
     }
 
     void Roadmap::constraintGraph (const graph::GraphPtr_t& graph)
     {
+      sync ();
       Histograms::iterator it = histograms_.begin();
       for (; it != histograms_.end();) {
         if (HPP_DYNAMIC_PTR_CAST (graph::NodeHistogram, *it))
@@ -67,7 +520,235 @@ namespace hpp {
         else
           ++it;
       }
+      statCreateClassifiers ();
       insertHistogram (graph::HistogramPtr_t (new graph::NodeHistogram (graph)));
+
+      graph_ = graph;
+      stateIndex_.clear ();
+      for (core::Nodes_t::const_iterator it = nodes ().begin ();
+          it != nodes ().end (); ++it) {
+        RoadmapNodePtr_t node = roadmapNode (*it);
+        node->resetCache ();
+        addToIndex (*it, graph_->getNode (node));
+      }
+    }
+
+    void Roadmap::save (const std::string& filename) const
+    {
+      if (!graph_)
+        throw std::runtime_error ("The constraint graph of the roadmap is not set.");
+      const std::size_t configSize = graph_->robot ()->configSize ();
+
+      // Nodes are indexed by their index in the arena, which is their
+      // position in nodes ().
+      Names < graph::NodePtr_t > states;
+      std::vector < boost::uint32_t > nodeStates;
+      nodeStates.reserve (nodes ().size ());
+      for (core::Nodes_t::const_iterator it = nodes ().begin ();
+          it != nodes ().end (); ++it) {
+        if ((std::size_t) (*it)->configuration ()->size () != configSize)
+          throw std::runtime_error ("Configuration size of a roadmap node does not match the robot.");
+        nodeStates.push_back (states
+            (roadmapNode (*it)->graphNode ()));
+      }
+
+      // The edges going both ways are stored once.
+      typedef std::pair < boost::uint64_t, boost::uint64_t > NodePair_t;
+      typedef std::map < NodePair_t, std::size_t > Records_t;
+      Names < graph::EdgePtr_t > edges;
+      std::vector < EdgeRecord > records;
+      Records_t recordIndexes;
+      for (core::Edges_t::const_iterator it = this->edges ().begin ();
+          it != this->edges ().end (); ++it) {
+        EdgeRecord record;
+        record.from = roadmapNode ((*it)->from ())->index ();
+        record.to = roadmapNode ((*it)->to ())->index ();
+        Records_t::const_iterator reverse =
+          recordIndexes.find (NodePair_t (record.to, record.from));
+        if (reverse != recordIndexes.end ()
+            && !records [reverse->second].bothWays) {
+          records [reverse->second].bothWays = 1;
+          continue;
+        }
+        bool backward;
+        record.edge = edges (graphEdge (graph_, *it, backward));
+        record.bothWays = 0;
+        record.backward = backward;
+        recordIndexes [NodePair_t (record.from, record.to)] = records.size ();
+        records.push_back (record);
+      }
+
+      std::string names;
+      states.write (names);
+      edges.write (names);
+      names.append (padding (names.size ()), '\0');
+
+      FileHeader header;
+      std::memcpy (header.magic, fileMagic, sizeof (fileMagic));
+      header.version = fileVersion;
+      header.byteOrder = fileByteOrder;
+      header.configSize = configSize;
+      header.nbNodes = nodeStates.size ();
+      header.nbEdges = records.size ();
+      header.nbStateNames = states.names.size ();
+      header.nbEdgeNames = edges.names.size ();
+      header.namesSize = names.size ();
+
+      std::ofstream file (filename.c_str (),
+          std::ios::out | std::ios::binary | std::ios::trunc);
+      if (!file.is_open ())
+        throw std::runtime_error ("Could not open " + filename);
+      write (file, &header, sizeof (header));
+      write (file, names.data (), names.size ());
+      for (core::Nodes_t::const_iterator it = nodes ().begin ();
+          it != nodes ().end (); ++it)
+        write (file, (*it)->configuration ()->data (),
+            configSize * sizeof (value_type));
+      write (file, nodeStates.data (),
+          nodeStates.size () * sizeof (boost::uint32_t));
+      writePadding (file, nodeStates.size () * sizeof (boost::uint32_t));
+      write (file, records.data (), records.size () * sizeof (EdgeRecord));
+      file.close ();
+      if (file.fail ())
+        throw std::runtime_error ("Could not write " + filename);
+      hppDout (info, "Saved " << header.nbNodes << " nodes and "
+          << header.nbEdges << " edges in " << filename);
+    }
+
+    void Roadmap::load (const std::string& filename,
+        const core::PathValidationPtr_t& validation,
+        const PathProjectorPtr_t& projector)
+    {
+      namespace bip = boost::interprocess;
+      if (!graph_)
+        throw std::runtime_error ("The constraint graph of the roadmap is not set.");
+      const std::size_t configSize = graph_->robot ()->configSize ();
+
+      bip::mapped_region region;
+      try {
+        bip::file_mapping mapping (filename.c_str (), bip::read_only);
+        bip::mapped_region (mapping, bip::read_only).swap (region);
+      } catch (const bip::interprocess_exception& e) {
+        throw std::runtime_error ("Could not map " + filename + ": " + e.what ());
+      }
+      const char* data = static_cast <const char*> (region.get_address ());
+      const char* end = data + region.get_size ();
+
+      FileHeader header;
+      if (region.get_size () < sizeof (header))
+        throw std::runtime_error (filename + " is not a roadmap file.");
+      std::memcpy (&header, data, sizeof (header));
+      if (std::memcmp (header.magic, fileMagic, sizeof (fileMagic)) != 0)
+        throw std::runtime_error (filename + " is not a roadmap file.");
+      if (header.version != fileVersion)
+        throw std::runtime_error ("Unsupported version of " + filename);
+      if (header.byteOrder != fileByteOrder)
+        throw std::runtime_error (filename + " was written with another byte order.");
+      if (header.configSize != configSize)
+        throw std::runtime_error (filename + " is a roadmap of another robot.");
+
+      // Check the size of the sections before reading them.
+      const std::size_t statesSize = header.nbNodes * sizeof (boost::uint32_t);
+      const std::size_t expectedSize = sizeof (header) + header.namesSize
+        + header.nbNodes * configSize * sizeof (value_type)
+        + statesSize + padding (statesSize)
+        + header.nbEdges * sizeof (EdgeRecord);
+      if (region.get_size () != expectedSize)
+        throw std::runtime_error ("Roadmap file is corrupted.");
+
+      const char* names = data + sizeof (header);
+      const std::vector < std::string > stateNames =
+        readNames (names, end, header.nbStateNames);
+      const std::vector < std::string > edgeNames =
+        readNames (names, end, header.nbEdgeNames);
+
+      // Components of the constraint graph, by name.
+      std::map < std::string, graph::NodePtr_t > statesByName;
+      std::map < std::string, graph::EdgePtr_t > edgesByName;
+      const graph::Nodes_t& graphStates = graph_->nodeSelector ()->getNodes ();
+      for (graph::Nodes_t::const_iterator it = graphStates.begin ();
+          it != graphStates.end (); ++it) {
+        statesByName [(*it)->name ()] = *it;
+        for (graph::Neighbors_t::const_iterator itE =
+            (*it)->neighbors ().begin (); itE != (*it)->neighbors ().end ();
+            ++itE)
+          edgesByName [itE->second->name ()] = itE->second;
+      }
+      graph::Nodes_t states (stateNames.size ());
+      for (std::size_t i = 0; i < stateNames.size (); ++i)
+        states [i] = statesByName [stateNames [i]];
+      graph::Edges_t edges (edgeNames.size ());
+      for (std::size_t i = 0; i < edgeNames.size (); ++i)
+        edges [i] = edgesByName [edgeNames [i]];
+
+      // The mapped file is 8 bytes aligned.
+      const value_type* configs = reinterpret_cast <const value_type*>
+        (data + sizeof (header) + header.namesSize);
+      const boost::uint32_t* nodeStates =
+        reinterpret_cast <const boost::uint32_t*>
+        (configs + header.nbNodes * configSize);
+      const EdgeRecord* records = reinterpret_cast <const EdgeRecord*>
+        (reinterpret_cast <const char*> (nodeStates)
+         + statesSize + padding (statesSize));
+      std::vector < Configuration_t > q (header.nbNodes);
+      for (std::size_t i = 0; i < header.nbNodes; ++i)
+        q [i] = Eigen::Map < const Configuration_t >
+          (configs + i * configSize, configSize);
+
+      // Rebuild the paths before modifying the roadmap, so that it is left
+      // unchanged if one of them fails.
+      core::WeighedDistancePtr_t distance =
+        HPP_DYNAMIC_PTR_CAST (core::WeighedDistance, distance_);
+      if (!distance) distance = core::WeighedDistance::create (graph_->robot ());
+      std::vector < core::PathPtr_t > paths (header.nbEdges);
+      for (std::size_t i = 0; i < header.nbEdges; ++i) {
+        const EdgeRecord& record = records [i];
+        if (record.from >= header.nbNodes || record.to >= header.nbNodes
+            || record.edge >= edges.size ())
+          throw std::runtime_error ("Roadmap file is corrupted.");
+        const graph::EdgePtr_t& edge = edges [record.edge];
+        if (!edge)
+          throw std::runtime_error ("The constraint graph has no edge "
+              + edgeNames [record.edge]);
+        // The states of the nodes are checked when the file names them.
+        boost::uint64_t from = record.from, to = record.to;
+        if (record.backward) std::swap (from, to);
+        if ((nodeStates [from] < states.size () && states [nodeStates [from]]
+              && states [nodeStates [from]] != edge->from ())
+            || (nodeStates [to] < states.size () && states [nodeStates [to]]
+              && states [nodeStates [to]] != edge->to ()))
+          throw std::runtime_error ("Edge " + edge->name () + " does not "
+              "link the states of the nodes of " + filename);
+        core::PathPtr_t path, projected, valid;
+        if (!edge->build (path, q [from], q [to], *distance))
+          throw std::runtime_error ("Could not rebuild a path of " + filename
+              + " with edge " + edge->name ());
+        if (projector) {
+          if (!projector->apply (path, projected))
+            throw std::runtime_error ("Could not project a path of "
+                + filename);
+          path = projected;
+        }
+        if (validation && !validation->validate (path, false, valid))
+          throw std::runtime_error ("A path of " + filename
+              + " is not valid.");
+        paths [i] = record.backward ? reversed (path) : path;
+      }
+
+      std::vector < core::NodePtr_t > loaded (header.nbNodes);
+      for (std::size_t i = 0; i < header.nbNodes; ++i) {
+        if (nodeStates [i] < states.size ()) loadedState_ = states [nodeStates [i]];
+        loaded [i] = addNode (ConfigurationPtr_t (new Configuration_t (q [i])));
+        loadedState_.reset ();
+      }
+      for (std::size_t i = 0; i < header.nbEdges; ++i) {
+        const core::NodePtr_t& from = loaded [records [i].from];
+        const core::NodePtr_t& to = loaded [records [i].to];
+        addEdge (from, to, paths [i]);
+        if (records [i].bothWays) addEdge (to, from, reversed (paths [i]));
+      }
+      hppDout (info, "Loaded " << header.nbNodes << " nodes and "
+          << header.nbEdges << " edges from " << filename);
     }
   } // namespace manipulation
 } // namespace hpp
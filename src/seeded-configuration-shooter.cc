@@ -0,0 +1,87 @@
+// Copyright (c) 2015, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#include "hpp/manipulation/seeded-configuration-shooter.hh"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include <hpp/model/device.hh>
+#include <hpp/model/joint.hh>
+#include <hpp/model/joint-configuration.hh>
+
+namespace hpp {
+  namespace manipulation {
+    SeededConfigurationShooterPtr_t SeededConfigurationShooter::create
+      (const core::DevicePtr_t& robot)
+    {
+      return SeededConfigurationShooterPtr_t
+        (new SeededConfigurationShooter (robot));
+    }
+
+    SeededConfigurationShooter::SeededConfigurationShooter
+      (const core::DevicePtr_t& robot) : robot_ (robot), rng_ (0)
+    {}
+
+    ConfigurationPtr_t SeededConfigurationShooter::shoot () const
+    {
+      ConfigurationPtr_t config (new Configuration_t (robot_->configSize ()));
+      const model::JointVector_t& jv = robot_->getJointVector ();
+      for (model::JointVector_t::const_iterator it = jv.begin ();
+          it != jv.end (); ++it) {
+        const size_type rank = (*it)->rankInConfiguration ();
+        const size_type size = (*it)->configSize ();
+        model::JointConfiguration* jc = (*it)->configuration ();
+        if (size == 4) {
+          // Uniform unit quaternion of a SO3 joint.
+          const value_type u1 = uniform01 (rng_), u2 = uniform01 (rng_),
+                u3 = uniform01 (rng_);
+          const value_type a = std::sqrt (1 - u1), b = std::sqrt (u1);
+          (*config) [rank] = a * std::sin (2 * M_PI * u2);
+          (*config) [rank + 1] = a * std::cos (2 * M_PI * u2);
+          (*config) [rank + 2] = b * std::sin (2 * M_PI * u3);
+          (*config) [rank + 3] = b * std::cos (2 * M_PI * u3);
+          continue;
+        }
+        for (size_type i = 0; i < size; ++i) {
+          value_type lower, upper;
+          if (jc->isBounded (i)) {
+            lower = jc->lowerBound (i);
+            upper = jc->upperBound (i);
+          } else if (dynamic_cast <model::JointRotation*> (*it)) {
+            lower = -M_PI;
+            upper = M_PI;
+          } else {
+            throw std::runtime_error ("Cannot uniformly sample the unbounded "
+                "joint " + (*it)->name ());
+          }
+          (*config) [rank + i] = lower + (upper - lower) * uniform01 (rng_);
+        }
+      }
+      const model::ExtraConfigSpace& ecs = robot_->extraConfigSpace ();
+      const size_type offset = robot_->configSize () - ecs.dimension ();
+      for (size_type i = 0; i < ecs.dimension (); ++i) {
+        const value_type range = ecs.upper (i) - ecs.lower (i);
+        if (range < 0 || range == std::numeric_limits <value_type>::infinity ())
+          throw std::runtime_error ("Cannot uniformly sample the unbounded "
+              "extra configuration variables.");
+        (*config) [offset + i] = ecs.lower (i) + range * uniform01 (rng_);
+      }
+      return config;
+    }
+  } // namespace manipulation
+} // namespace hpp
@@ -0,0 +1,140 @@
+// Copyright (c) 2015, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#include "hpp/manipulation/thread-pool.hh"
+
+#include <set>
+#include <stdexcept>
+#include <boost/bind.hpp>
+#include <boost/thread/tss.hpp>
+
+namespace hpp {
+  namespace manipulation {
+    namespace {
+      boost::mutex slotMutex;
+      std::size_t nextSlot = 0;
+      /// Slots of the threads that exited.
+      std::set < std::size_t > freeSlots;
+
+      /// Called when a thread having a slot exits.
+      void releaseSlot (std::size_t* s)
+      {
+        boost::mutex::scoped_lock lock (slotMutex);
+        freeSlots.insert (*s);
+        delete s;
+      }
+
+      // Declared after the members used by releaseSlot, so that it is
+      // destroyed before them.
+      boost::thread_specific_ptr < std::size_t > slot (&releaseSlot);
+    }
+
+    std::size_t ThreadPool::threadSlot ()
+    {
+      if (!slot.get ()) {
+        boost::mutex::scoped_lock lock (slotMutex);
+        if (freeSlots.empty ()) {
+          slot.reset (new std::size_t (nextSlot++));
+        } else {
+          slot.reset (new std::size_t (*freeSlots.begin ()));
+          freeSlots.erase (freeSlots.begin ());
+        }
+      }
+      return *slot;
+    }
+
+    ThreadPoolPtr_t ThreadPool::create (const std::size_t& nbThreads)
+    {
+      return ThreadPoolPtr_t (new ThreadPool (nbThreads));
+    }
+
+    ThreadPool::ThreadPool (const std::size_t& nbThreads) :
+      threads_ (), slots_ (), task_ (NULL), nbTasks_ (0), nextTask_ (0),
+      nbDone_ (0), error_ (), stop_ (false)
+    {
+      for (std::size_t i = 0; i < nbThreads; ++i)
+        threads_.create_thread (boost::bind (&ThreadPool::work, this));
+      // Wait until the workers registered their slot.
+      boost::mutex::scoped_lock lock (mutex_);
+      while (slots_.size () < nbThreads) workDone_.wait (lock);
+    }
+
+    ThreadPool::~ThreadPool ()
+    {
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        stop_ = true;
+      }
+      workAvailable_.notify_all ();
+      threads_.join_all ();
+    }
+
+    std::size_t ThreadPool::size () const
+    {
+      return threads_.size ();
+    }
+
+    void ThreadPool::run (const std::size_t& nbTasks, const Task_t& task)
+    {
+      if (nbTasks == 0) return;
+      if (threads_.size () == 0) {
+        for (std::size_t i = 0; i < nbTasks; ++i) task (i);
+        return;
+      }
+      boost::mutex::scoped_lock runLock (runMutex_);
+      boost::mutex::scoped_lock lock (mutex_);
+      task_ = &task;
+      nbTasks_ = nbTasks;
+      nextTask_ = 0;
+      nbDone_ = 0;
+      error_.clear ();
+      workAvailable_.notify_all ();
+      while (nbDone_ < nbTasks_) workDone_.wait (lock);
+      task_ = NULL;
+      nbTasks_ = 0;
+      nextTask_ = 0;
+      if (!error_.empty ())
+        throw std::runtime_error (error_);
+    }
+
+    void ThreadPool::work ()
+    {
+      const std::size_t slot = threadSlot ();
+      boost::mutex::scoped_lock lock (mutex_);
+      slots_.push_back (slot);
+      workDone_.notify_all ();
+      while (true) {
+        while (!stop_ && nextTask_ >= nbTasks_) workAvailable_.wait (lock);
+        if (stop_) return;
+        const std::size_t i = nextTask_++;
+        const Task_t& task = *task_;
+        lock.unlock ();
+        std::string error;
+        try {
+          task (i);
+        } catch (const std::exception& e) {
+          error = e.what ();
+          if (error.empty ()) error = "Unknown exception in ThreadPool task";
+        } catch (...) {
+          error = "Unknown exception in ThreadPool task";
+        }
+        lock.lock ();
+        if (!error.empty () && error_.empty ()) error_ = error;
+        if (++nbDone_ == nbTasks_) workDone_.notify_all ();
+      }
+    }
+  } // namespace manipulation
+} // namespace hpp
@@ -18,8 +18,6 @@
 #include <hpp/core/steering-method-straight.hh>
 #include <hpp/core/numerical-constraint.hh>
 
-#define ARM_LENGTH 1
-#define FOREARM_LENGTH 1
 #define STEP_PATH (value_type)0.01
 
 #include <math.h>
@@ -35,6 +33,8 @@
 #include <hpp/model/configuration.hh>
 #include <hpp/model/object-factory.hh>
 
+#include "toy-robot.hh"
+
 #include <hpp/constraints/position.hh>
 
 #define REQUIRE_MESSAGE(b,m) do {\
@@ -77,50 +77,7 @@ using hpp::core::pathProjector::Progressive;
 
 static matrix3_t identity () { matrix3_t R; R.setIdentity (); return R;}
 
-hpp::model::ObjectFactory objectFactory;
-
 namespace hpp_test {
-  DevicePtr_t createRobot ()
-  {
-    DevicePtr_t robot = Device::create ("test");
-    BodyPtr_t body;
-    fcl::Transform3f pos;
-    fcl::Matrix3f orient;
-    orient (0,0) = 1; orient (0,1) = 0; orient (0,2) = 0;
-    orient (1,0) = 0; orient (1,1) = 1; orient (1,2) = 0;
-    orient (2,0) = 0; orient (2,1) = 0; orient (2,2) = 1;
-    pos.setRotation (orient);
-    // Arm joint
-    pos.setTranslation (fcl::Vec3f (0, 0, 0));
-    JointPtr_t arm = objectFactory.createBoundedJointRotation (pos);
-    robot->rootJoint (arm);
-    arm->name ("ARM");
-    body = objectFactory.createBody ();
-    body->name ("ARM_BODY");
-    arm->setLinkedBody (body);
-    // Forearm joint
-    pos.setTranslation (fcl::Vec3f (0, ARM_LENGTH, 0));
-    JointPtr_t forearm = objectFactory.createBoundedJointRotation (pos);
-    forearm->name ("FOREARM");
-    arm->addChildJoint (forearm);
-    body = objectFactory.createBody ();
-    body->name ("FOREARM_BODY");
-    forearm->setLinkedBody (body);
-    // End effector joint
-    pos.setTranslation (fcl::Vec3f (0, FOREARM_LENGTH, 0));
-    JointPtr_t ee = objectFactory.createJointAnchor (pos);
-    ee->name ("EE");
-    body = objectFactory.createBody ();
-    body->name ("EE");
-    ee->setLinkedBody (body);
-    forearm->addChildJoint (ee);
-    //body = objectFactory.createBody ();
-    //body->name ("RLEG_BODY2");
-    //joint->setLinkedBody (body);
-
-    return robot;
-  }
-
   std::ostream& print (std::ostream& os, const Configuration_t& c)
   {
     os << "[ \t";
@@ -17,7 +17,27 @@
 #include <hpp/util/pointer.hh>
 #include <hpp/model/urdf/util.hh>
 
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <limits>
+#include <algorithm>
+#include <boost/bind.hpp>
+#include <boost/assign/list_of.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <hpp/model/joint.hh>
+
 #include <hpp/core/steering-method-straight.hh>
+#include <hpp/core/numerical-constraint.hh>
+#include <hpp/core/comparison-type.hh>
+#include <hpp/core/config-projector.hh>
+#include <hpp/core/discretized-collision-checking.hh>
+#include <hpp/core/weighed-distance.hh>
+#include <hpp/core/straight-path.hh>
+#include <hpp/core/connected-component.hh>
+#include <hpp/core/path-vector.hh>
+#include <hpp/core/path-projector/progressive.hh>
 
 #include <hpp/constraints/position.hh>
 #include <hpp/constraints/relative-com.hh>
@@ -26,9 +46,19 @@
 #include "hpp/manipulation/graph/node-selector.hh"
 #include "hpp/manipulation/graph/graph.hh"
 #include "hpp/manipulation/graph/edge.hh"
+#include "hpp/manipulation/graph/node-cache.hh"
+#include "hpp/manipulation/graph/statistics.hh"
+#include "hpp/manipulation/graph/per-thread.hh"
+#include "hpp/manipulation/thread-pool.hh"
 #include "hpp/manipulation/device.hh"
 #include "hpp/manipulation/problem.hh"
+#include "hpp/manipulation/problem-solver.hh"
 #include "hpp/manipulation/graph-path-validation.hh"
+#include "hpp/manipulation/roadmap.hh"
+#include "hpp/manipulation/roadmap-node.hh"
+#include "hpp/manipulation/manipulation-planner.hh"
+
+#include "toy-robot.hh"
 
 #include <boost/test/unit_test.hpp>
 
@@ -84,6 +114,265 @@ namespace hpp_test {
     q1 << 1,1,1,0,2.5,-1.9;
     q2 << 2,0,1,0,2.5,-1.9;
   }
+
+  value_type edgeCost (const EdgePtr_t& edge)
+  {
+    return edge == e12 ? 2 : 1;
+  }
+
+  /// Constraint on the y coordinate of the tip of the arm of addArm.
+  NumericalConstraintPtr_t tipHeight (const hpp::core::DevicePtr_t& r,
+      const value_type& y)
+  {
+    hpp::constraints::matrix3_t R; R.setIdentity ();
+    const hpp::constraints::vector3_t origin (0, FOREARM_LENGTH, 0),
+          target (0, y, 0);
+    return hpp::core::NumericalConstraint::create
+      (hpp::constraints::Position::create (r, r->getJointByName ("FOREARM"),
+        origin, target, R, boost::assign::list_of (false)(true)(false)));
+  }
+
+  /// Constraint on the x coordinate of the tip of the arm of addArm.
+  NumericalConstraintPtr_t tipAbscissa (const hpp::core::DevicePtr_t& r,
+      const value_type& x)
+  {
+    hpp::constraints::matrix3_t R; R.setIdentity ();
+    const hpp::constraints::vector3_t origin (0, FOREARM_LENGTH, 0),
+          target (x, 0, 0);
+    return hpp::core::NumericalConstraint::create
+      (hpp::constraints::Position::create (r, r->getJointByName ("FOREARM"),
+        origin, target, R, boost::assign::list_of (true)(false)(false)));
+  }
+
+  /// Condition of armFoliation: no constraint.
+  ConfigProjectorPtr_t everywhere (const hpp::core::DevicePtr_t& arm)
+  {
+    return ConfigProjector::create (arm, "everywhere", 1e-4, 20);
+  }
+
+  /// Parametrizer of armFoliation: the height of the elbow.
+  ConfigProjectorPtr_t elbowHeight (const hpp::core::DevicePtr_t& arm)
+  {
+    hpp::constraints::matrix3_t R; R.setIdentity ();
+    const hpp::constraints::vector3_t zero (0, 0, 0);
+    ConfigProjectorPtr_t param =
+      ConfigProjector::create (arm, "elbow-height", 1e-4, 20);
+    param->add (hpp::core::NumericalConstraint::create
+        (hpp::constraints::Position::create (arm,
+          arm->getJointByName ("FOREARM"), zero, zero, R,
+          boost::assign::list_of (false)(true)(false))));
+    return param;
+  }
+
+  /// Foliation of the arm of addArm whose leaves are the configurations
+  /// with the same angle of joint ARM. The parameter of a leaf is the
+  /// height of the elbow, ARM_LENGTH * cos (q [0]).
+  /// The projectors are set with factories.
+  Foliation armFoliation (const DevicePtr_t& arm)
+  {
+    Foliation f;
+    f.condition (&everywhere, arm);
+    f.parametrizer (&elbowHeight, arm);
+    return f;
+  }
+
+  /// Configuration of the arm whose elbow is at a given height.
+  /// \sa armFoliation
+  ConfigurationPtr_t elbowConfig (const value_type& height,
+      const value_type& forearm)
+  {
+    ConfigurationPtr_t q (new Configuration_t (2));
+    (*q) [0] = std::acos (height / ARM_LENGTH);
+    (*q) [1] = forearm;
+    return q;
+  }
+
+  GraphPathValidationPtr_t collisionChecking (const hpp::core::DevicePtr_t& r)
+  {
+    return GraphPathValidation::create <
+      hpp::core::DiscretizedCollisionChecking > (r, .05);
+  }
+
+  /// Arm of addArm, whose joints are bounded to [-pi, pi].
+  DevicePtr_t createArm ()
+  {
+    DevicePtr_t arm = Device::create ("arm");
+    addArm (arm);
+    for (std::size_t i = 0; i < 2; ++i) {
+      hpp::model::JointPtr_t joint =
+        arm->getJointByName (i == 0 ? "ARM" : "FOREARM");
+      joint->lowerBound (0, -M_PI);
+      joint->upperBound (0, M_PI);
+    }
+    return arm;
+  }
+
+  /// Graph of the arm with a state grasp, where the tip is at height 1,
+  /// and a state free, linked by all the possible edges.
+  GraphPtr_t createArmGraph (const DevicePtr_t& arm)
+  {
+    GraphPtr_t g = Graph::create ("arm-graph", arm,
+        SteeringMethodStraight::create (arm));
+    g->maxIterations (20);
+    g->errorThreshold (1e-4);
+    NodeSelectorPtr_t selector = g->createNodeSelector ("selector");
+    NodePtr_t graspState = selector->createNode ("grasp");
+    NodePtr_t freeState = selector->createNode ("free");
+    graspState->addNumericalConstraint
+      (GraphComponent::NumericalConstraintFactory_t
+       (boost::bind (&tipHeight, _1, 1.)));
+    freeState->linkTo ("loop-free", freeState);
+    freeState->linkTo ("free-grasp", graspState);
+    graspState->linkTo ("grasp-free", freeState);
+    graspState->linkTo ("loop-grasp", graspState);
+    return g;
+  }
+
+  /// Random configuration of the arm of createArm.
+  ConfigurationPtr_t randomArmConfig (RandomGenerator_t& rng)
+  {
+    ConfigurationPtr_t q (new Configuration_t (2));
+    (*q) [0] = M_PI * (2 * uniform01 (rng) - 1);
+    (*q) [1] = M_PI * (2 * uniform01 (rng) - 1);
+    return q;
+  }
+
+  /// Add random configurations to a roadmap. The even ones are linked to
+  /// the first one, in a same connected component. The odd ones are each
+  /// in their own connected component.
+  hpp::core::Nodes_t fillRoadmap (const RoadmapPtr_t& r,
+      const DevicePtr_t& arm, const std::size_t& n)
+  {
+    RandomGenerator_t rng (0);
+    hpp::core::Nodes_t nodes;
+    const hpp::core::NodePtr_t first = r->addNode (randomArmConfig (rng));
+    nodes.push_back (first);
+    for (std::size_t i = 1; i < n; ++i) {
+      const ConfigurationPtr_t q = randomArmConfig (rng);
+      if (i % 2 == 1) nodes.push_back (r->addNode (q));
+      else
+        nodes.push_back (r->addNodeAndEdges (first, q,
+              hpp::core::StraightPath::create (arm, *first->configuration (),
+                *q, 1)));
+    }
+    return nodes;
+  }
+
+  /// First state containing a configuration, by a linear scan.
+  NodePtr_t linearGetNode (const Nodes_t& states, const Configuration_t& q)
+  {
+    for (Nodes_t::const_iterator it = states.begin (); it != states.end ();
+        ++it)
+      if ((*it)->contains (q)) return *it;
+    return NodePtr_t ();
+  }
+
+  /// Nearest node of a connected component, by a linear scan.
+  hpp::core::NodePtr_t linearNearest (const hpp::core::Nodes_t& nodes,
+      const hpp::core::Distance& distance, const Configuration_t& q,
+      const hpp::core::ConnectedComponentPtr_t& cc, value_type& minDistance)
+  {
+    hpp::core::NodePtr_t nearest = NULL;
+    minDistance = std::numeric_limits <value_type>::infinity ();
+    for (hpp::core::Nodes_t::const_iterator it = nodes.begin ();
+        it != nodes.end (); ++it) {
+      if ((*it)->connectedComponent () != cc) continue;
+      const value_type d = distance (*(*it)->configuration (), q);
+      if (d < minDistance) {
+        minDistance = d;
+        nearest = *it;
+      }
+    }
+    return nearest;
+  }
+
+  /// Plan between the states free and grasp of the arm of addArm and
+  /// return the roadmap.
+  /// \param queueSize if not 0, the steps are pipelined with one thread
+  ///        per stage.
+  RoadmapPtr_t planArm (const std::size_t& nbThreads,
+      const std::size_t& nbSteps, const std::size_t& queueSize = 0,
+      const std::size_t& seed = 1)
+  {
+    DevicePtr_t arm = createArm ();
+    GraphPtr_t g = createArmGraph (arm);
+
+    Problem problem (arm);
+    problem.pathValidation (collisionChecking (arm));
+    problem.constraintGraph (g);
+    ConfigurationPtr_t qInit (new Configuration_t
+        (Configuration_t::Zero (arm->configSize ())));
+    ConfigurationPtr_t qGoal (new Configuration_t (*qInit));
+    (*qGoal) [1] = M_PI / 2;
+    problem.initConfig (qInit);
+    problem.addGoalConfig (qGoal);
+    RoadmapPtr_t roadmap = Roadmap::create (problem.distance (), arm);
+    roadmap->constraintGraph (g);
+    ManipulationPlannerPtr_t planner =
+      ManipulationPlanner::create (problem, roadmap);
+    planner->numberOfThreads (nbThreads);
+    if (queueSize > 0) planner->pipeline (1, 1, 1, queueSize);
+    planner->pathValidationFactory (&collisionChecking);
+    planner->seed (seed);
+    planner->startSolve ();
+    for (std::size_t i = 0; i < nbSteps; ++i) planner->oneStep ();
+    return roadmap;
+  }
+
+  /// Path validation rejecting the paths that pass close to a
+  /// configuration.
+  class AvoidConfiguration : public hpp::core::PathValidation
+  {
+    public:
+      AvoidConfiguration (const Configuration_t& q, const value_type& radius)
+        : q_ (q), radius_ (radius)
+      {}
+
+      bool validate (const hpp::core::PathPtr_t& path, bool reverse,
+          hpp::core::PathPtr_t& validPart)
+      {
+        const hpp::core::interval_t& range = path->timeRange ();
+        Configuration_t q (path->outputSize ());
+        for (std::size_t i = 0; i <= 100; ++i) {
+          (*path) (q, range.first + (range.second - range.first) * i / 100);
+          if ((q - q_).norm () < radius_) {
+            const value_type t = reverse ? range.second : range.first;
+            validPart = path->extract (hpp::core::interval_t (t, t));
+            return false;
+          }
+        }
+        validPart = path;
+        return true;
+      }
+
+      bool validate (const hpp::core::PathPtr_t& path, bool reverse,
+          hpp::core::PathPtr_t& validPart, hpp::core::ValidationReport&)
+      {
+        return validate (path, reverse, validPart);
+      }
+
+    private:
+      Configuration_t q_;
+      value_type radius_;
+  };
+
+  /// Configurations of the nodes of a roadmap, in their order of
+  /// insertion.
+  std::vector <Configuration_t> configurations (const RoadmapPtr_t& r)
+  {
+    std::vector <Configuration_t> configs;
+    for (hpp::core::Nodes_t::const_iterator it = r->nodes ().begin ();
+        it != r->nodes ().end (); ++it)
+      configs.push_back (*(*it)->configuration ());
+    return configs;
+  }
+
+  /// Task of a ThreadPool classifying a configuration.
+  void classify (const std::size_t&, const GraphPtr_t& g,
+      const Configuration_t& q)
+  {
+    g->getNode (q);
+  }
 }
 
 BOOST_AUTO_TEST_CASE (GraphStructure)
@@ -117,6 +406,1146 @@ BOOST_AUTO_TEST_CASE (GraphStructure)
   BOOST_CHECK (edge->from() == n1);
 }
 
+BOOST_AUTO_TEST_CASE (NodeCacheTest)
+{
+  using namespace hpp_test;
+  initialize (false);
+
+  NodeCachePtr_t cache = NodeCache::create (2, 1e-3);
+  NodePtr_t node;
+  BOOST_CHECK (!cache->get (q1, node));
+  cache->insert (q1, n1);
+  cache->insert (q2, n2);
+  BOOST_CHECK (cache->get (q1, node));
+  BOOST_CHECK (node == n1);
+
+  // q2 is the least recently used entry.
+  Configuration_t q3 = q1; q3 [0] = 10;
+  cache->insert (q3, n2);
+  BOOST_CHECK (cache->size () == 2);
+  BOOST_CHECK (!cache->get (q2, node));
+  BOOST_CHECK (cache->get (q3, node));
+  BOOST_CHECK (node == n2);
+  BOOST_CHECK (cache->hits () == 2);
+  BOOST_CHECK (cache->misses () == 2);
+
+  // A close configuration is found across the border of a cell, but only
+  // in a state that contains it.
+  DevicePtr_t arm = createArm ();
+  GraphPtr_t g = createArmGraph (arm);
+  NodeCachePtr_t armCache = NodeCache::create (10, 1e-3);
+  Configuration_t qGrasp (2), qFree (2), q;
+  qGrasp << 0, M_PI / 2;
+  qFree << -2e-4, .3;
+  const NodePtr_t graspState = g->getNode (qGrasp),
+        freeState = g->getNode (qFree);
+  BOOST_CHECK (graspState != freeState);
+  armCache->insert (qGrasp, graspState);
+  armCache->insert (qFree, freeState);
+  q = qGrasp; q [1] += 5e-4;
+  BOOST_CHECK (!graspState->contains (q));
+  BOOST_CHECK (!armCache->get (q, node));
+  q = qFree; q [0] = 2e-4;
+  BOOST_CHECK (armCache->get (q, node));
+  BOOST_CHECK (node == freeState);
+  BOOST_CHECK (armCache->hits () == 1);
+  BOOST_CHECK (armCache->misses () == 1);
+
+  // A grasp configuration close to a cached free one is not classified
+  // free, although free contains it: grasp comes first.
+  NodeCachePtr_t nearCache = NodeCache::create (10, 1e-3);
+  q = qGrasp; q [1] += 5e-4;
+  BOOST_REQUIRE (g->getNode (q) == freeState);
+  nearCache->insert (q, freeState);
+  BOOST_CHECK (!nearCache->get (qGrasp, node));
+  g->nodeCache (nearCache);
+  BOOST_CHECK (g->getNode (qGrasp) == graspState);
+  BOOST_CHECK (g->getNode (qGrasp) == graspState);
+  BOOST_CHECK (nearCache->hits () == 1);
+
+  graph_->nodeCache (cache);
+  graph_->errorThreshold (1e-4);
+  BOOST_CHECK (cache->size () == 0);
+}
+
+BOOST_AUTO_TEST_CASE (CostsTo)
+{
+  using namespace hpp_test;
+  using hpp_test::graph_;
+  initialize (false);
+
+  Graph::StateCosts_t costs = graph_->costsTo (Nodes_t (1, n1), &edgeCost);
+  BOOST_CHECK (costs.size () == 2);
+  BOOST_CHECK (costs [n1] == 0);
+  BOOST_CHECK (costs [n2] == 1);
+  costs = graph_->costsTo (Nodes_t (1, n2), &edgeCost);
+  BOOST_CHECK (costs [n2] == 0);
+  BOOST_CHECK (costs [n1] == 2);
+}
+
+BOOST_AUTO_TEST_CASE (EdgeChoice)
+{
+  using namespace hpp_test;
+  DevicePtr_t arm = createArm ();
+  GraphPtr_t g = Graph::create ("edge-choice", arm,
+      SteeringMethodStraight::create (arm));
+  NodeSelectorPtr_t selector = g->createNodeSelector ("selector");
+  NodePtr_t state = selector->createNode ("state");
+  std::vector <EdgePtr_t> edges;
+  std::vector <Weight_t> weights = boost::assign::list_of (1)(2)(0)(5)(2);
+  for (std::size_t i = 0; i < weights.size (); ++i) {
+    std::ostringstream name;
+    name << "edge-" << i;
+    edges.push_back (state->linkTo (name.str (), state, weights [i]));
+  }
+
+  // The frequency of each edge is its weight over the total weight.
+  const std::size_t nbDraws = 100000;
+  RandomGenerator_t rng (3);
+  for (std::size_t k = 0; k < 2; ++k) {
+    if (k == 1) {
+      // The alias table is rebuilt when a weight changes.
+      weights [0] = 7;
+      state->updateWeight (edges [0], weights [0]);
+    }
+    value_type total = 0;
+    for (std::size_t i = 0; i < weights.size (); ++i) total += weights [i];
+    std::vector <std::size_t> counts (edges.size (), 0);
+    for (std::size_t j = 0; j < nbDraws; ++j) {
+      const EdgePtr_t e = state->chooseEdge (rng);
+      const std::size_t i =
+        std::find (edges.begin (), edges.end (), e) - edges.begin ();
+      BOOST_REQUIRE (i < edges.size ());
+      ++counts [i];
+    }
+    for (std::size_t i = 0; i < edges.size (); ++i) {
+      const value_type p = weights [i] / total;
+      // Within 5 standard deviations.
+      BOOST_CHECK_MESSAGE (std::abs ((value_type) counts [i] / nbDraws - p)
+          <= 5 * std::sqrt (p * (1 - p) / nbDraws),
+          "Edge " << i << " drawn " << counts [i] << " times out of "
+          << nbDraws << ", expected probability " << p);
+    }
+    BOOST_CHECK (counts [2] == 0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE (Initialize)
+{
+  using namespace hpp_test;
+  using hpp_test::graph_;
+  initialize (false);
+
+  graph_->initialize (std::vector <std::size_t> (), 2);
+  BOOST_CHECK (graph_->frozen ());
+  BOOST_CHECK (graph_->initializationTimes ().count (n1->id ()) == 1);
+  BOOST_CHECK (graph_->initializationTimes ().count (e12->id ()) == 1);
+  BOOST_CHECK_THROW (ns->createNode ("node 3"), std::logic_error);
+  BOOST_CHECK_THROW (n1->linkTo ("edge 13", n2), std::logic_error);
+}
+
+BOOST_AUTO_TEST_CASE (ThreadSlots)
+{
+  using namespace hpp_test;
+
+  // A fixed storage does not grow anymore.
+  PerThread <int> values (1);
+  values.at (0) = 2;
+  values.fix (3);
+  BOOST_CHECK (values.at (0) == 2);
+  BOOST_CHECK (values.at (2) == 1);
+  BOOST_CHECK_THROW (values.at (3), std::logic_error);
+  values.reset (4);
+  BOOST_CHECK (values.at (2) == 4);
+  BOOST_CHECK_THROW (values.at (3), std::logic_error);
+
+  // The slots of the threads that exited are given to the next ones.
+  std::vector <std::size_t> slots;
+  {
+    ThreadPoolPtr_t pool = ThreadPool::create (3);
+    slots = pool->slots ();
+  }
+  ThreadPoolPtr_t pool = ThreadPool::create (3);
+  BOOST_CHECK (*std::max_element (pool->slots ().begin (),
+        pool->slots ().end ()) <= *std::max_element (slots.begin (),
+          slots.end ()));
+
+  // A thread that was not given to initialize cannot use the graph.
+  DevicePtr_t arm = createArm ();
+  GraphPtr_t g = createArmGraph (arm);
+  g->initialize (std::vector <std::size_t> (), 1);
+  const Configuration_t q (Configuration_t::Zero (2));
+  BOOST_CHECK_THROW (pool->run (1, boost::bind (&classify, _1, g,
+          boost::cref (q))), std::runtime_error);
+  g->getNode (q);
+
+  // Initializing it again adds the threads, on their copy of the robot,
+  // but the structure remains frozen.
+  const std::vector <std::size_t> before (g->threadSlots ());
+  g->initialize (pool->slots (), 1);
+  BOOST_CHECK (g->threadSlots ().size () == before.size () + 3);
+  BOOST_CHECK (std::includes (g->threadSlots ().begin (),
+        g->threadSlots ().end (), before.begin (), before.end ()));
+  for (std::size_t i = 0; i < pool->slots ().size (); ++i)
+    BOOST_CHECK (g->robot (pool->slots () [i]) != g->robot ());
+  BOOST_CHECK (g->robot (ThreadPool::threadSlot ()) == g->robot ());
+  pool->run (3, boost::bind (&classify, _1, g, boost::cref (q)));
+  BOOST_CHECK (g->frozen ());
+  BOOST_CHECK_THROW (g->nodeSelector ()->createNode ("other"),
+      std::logic_error);
+  g->initialize (pool->slots (), 1);
+  BOOST_CHECK (g->threadSlots ().size () == before.size () + 3);
+}
+
+BOOST_AUTO_TEST_CASE (NodeSelection)
+{
+  using namespace hpp_test;
+  DevicePtr_t arm = createArm ();
+  GraphPtr_t g = Graph::create ("selection", arm,
+      SteeringMethodStraight::create (arm));
+  g->maxIterations (20);
+  g->errorThreshold (1e-4);
+  NodeSelectorPtr_t selector = g->createNodeSelector ("selector");
+  // States sharing constraints. A configuration of corner is also in high
+  // and right, and all of them are in free.
+  const NumericalConstraintPtr_t high = tipHeight (arm, 1),
+        right = tipAbscissa (arm, .5), low = tipHeight (arm, .5);
+  NodePtr_t corner = selector->createNode ("corner");
+  corner->addNumericalConstraint (high);
+  corner->addNumericalConstraint (right);
+  selector->createNode ("high")->addNumericalConstraint (high);
+  selector->createNode ("right")->addNumericalConstraint (right);
+  selector->createNode ("low")->addNumericalConstraint (low);
+  selector->createNode ("free");
+  const Nodes_t& states = selector->getNodes ();
+
+  // Random configurations and their projections onto each state.
+  RandomGenerator_t rng (2);
+  std::vector <Configuration_t> configs;
+  for (std::size_t i = 0; i < 20; ++i) {
+    const ConfigurationPtr_t q = randomArmConfig (rng);
+    configs.push_back (*q);
+    for (Nodes_t::const_iterator it = states.begin (); it != states.end ();
+        ++it) {
+      Configuration_t qProj (*q);
+      if (g->configConstraint (*it)->apply (qProj)) configs.push_back (qProj);
+    }
+  }
+
+  // getNode returns the first state containing the configuration, as a
+  // linear scan, with the whole decision tree or a truncated one.
+  const std::size_t maxSizes [] = { selector->classifierMaxSize (), 1, 2, 3 };
+  for (std::size_t k = 0; k < 4; ++k) {
+    selector->classifierMaxSize (maxSizes [k]);
+    for (std::size_t i = 0; i < configs.size (); ++i) {
+      BOOST_CHECK_MESSAGE (selector->getNode (configs [i])
+          == linearGetNode (states, configs [i]),
+          "Wrong state of configuration " << i << " with at most "
+          << maxSizes [k] << " vertices");
+    }
+  }
+  BOOST_CHECK_THROW (selector->classifierMaxSize (0), std::invalid_argument);
+  selector->classifierMaxSize (maxSizes [0]);
+
+  // Configurations near corner satisfying high and right separately but
+  // not together, since the errors of the constraints of a state add up.
+  // getNode rejects corner and returns high.
+  std::size_t c = 0;
+  while (c < configs.size () && !corner->contains (configs [c])) ++c;
+  BOOST_REQUIRE (c < configs.size ());
+  std::size_t nbNear = 0;
+  for (std::size_t i = 0; i < 2000; ++i) {
+    Configuration_t q (configs [c]);
+    q [0] += 2e-4 * (2 * uniform01 (rng) - 1);
+    q [1] += 2e-4 * (2 * uniform01 (rng) - 1);
+    if (corner->contains (q) || !states [1]->contains (q)
+        || !states [2]->contains (q)) continue;
+    ++nbNear;
+    BOOST_CHECK (selector->getNode (q) == states [1]);
+  }
+  BOOST_CHECK (nbNear > 0);
+
+  // The constraints of the graph are in every state.
+  g->addNumericalConstraint (high);
+  for (std::size_t i = 0; i < configs.size (); ++i) {
+    const NodePtr_t state = linearGetNode (states, configs [i]);
+    if (state) BOOST_CHECK (selector->getNode (configs [i]) == state);
+    else BOOST_CHECK_THROW (selector->getNode (configs [i]),
+        std::logic_error);
+  }
+
+  // After initialize, the lookups use the tree built by initialize.
+  g->initialize (std::vector <std::size_t> (), 1);
+  for (std::size_t i = 0; i < configs.size (); ++i) {
+    const NodePtr_t state = linearGetNode (states, configs [i]);
+    if (state) BOOST_CHECK (selector->getNode (configs [i]) == state);
+    else BOOST_CHECK_THROW (selector->getNode (configs [i]),
+        std::logic_error);
+  }
+}
+
+BOOST_AUTO_TEST_CASE (SharedEvaluation)
+{
+  using namespace hpp_test;
+  DevicePtr_t arm = createArm ();
+  // The same graph without and with shared evaluation. The loops also
+  // keep the height of the tip, with the function of the constraint of
+  // grasp, so that the projectors have different right hand sides for the
+  // same function.
+  GraphPtr_t graphs [2] = { createArmGraph (arm), createArmGraph (arm) };
+  graphs [1]->shareConstraintEvaluation (true);
+  std::vector <NodePtr_t> states [2];
+  std::vector <EdgePtr_t> edges [2];
+  for (std::size_t k = 0; k < 2; ++k) {
+    states [k] = graphs [k]->nodeSelector ()->getNodes ();
+    const DifferentiableFunctionPtr_t height =
+      states [k] [0]->numericalConstraints () [0]->functionPtr ();
+    for (std::size_t i = 0; i < states [k].size (); ++i)
+      for (Neighbors_t::const_iterator it = states [k] [i]->neighbors ().begin ();
+          it != states [k] [i]->neighbors ().end (); ++it) {
+        edges [k].push_back (it->second);
+        if (it->second->from () == it->second->to ())
+          it->second->addNumericalConstraint
+            (hpp::core::NumericalConstraint::create
+             (height, hpp::core::Equality::create ()));
+      }
+  }
+  BOOST_REQUIRE (edges [0].size () == edges [1].size ());
+
+  // The states and the projections are the same.
+  RandomGenerator_t rng (7);
+  for (std::size_t j = 0; j < 20; ++j) {
+    const ConfigurationPtr_t q = randomArmConfig (rng),
+          qOffset = randomArmConfig (rng);
+    NodePtr_t state [2];
+    for (std::size_t k = 0; k < 2; ++k) state [k] = graphs [k]->getNode (*q);
+    BOOST_CHECK (state [0]->name () == state [1]->name ());
+    for (std::size_t i = 0; i < states [0].size (); ++i) {
+      Configuration_t proj [2] = { *q, *q };
+      bool applied [2];
+      for (std::size_t k = 0; k < 2; ++k)
+        applied [k] = graphs [k]->configConstraint (states [k] [i])
+          ->apply (proj [k]);
+      BOOST_CHECK (applied [0] == applied [1]);
+      if (applied [0]) BOOST_CHECK ((proj [0] - proj [1]).norm () < 1e-10);
+    }
+    for (std::size_t i = 0; i < edges [0].size (); ++i) {
+      Configuration_t proj [2] = { *q, *q };
+      bool applied [2];
+      for (std::size_t k = 0; k < 2; ++k)
+        applied [k] = edges [k] [i]->applyConstraints (*qOffset, proj [k]);
+      BOOST_CHECK (applied [0] == applied [1]);
+      if (applied [0]) BOOST_CHECK ((proj [0] - proj [1]).norm () < 1e-10);
+    }
+  }
+
+  // Each projector keeps its right hand side: setting the one of a loop
+  // changes neither the other loop nor the state grasp.
+  const GraphPtr_t& g = graphs [1];
+  const NodePtr_t grasp = states [1] [0];
+  EdgePtr_t loopGrasp, loopFree;
+  for (std::size_t i = 0; i < edges [1].size (); ++i) {
+    if (edges [1] [i]->from () != edges [1] [i]->to ()) continue;
+    if (edges [1] [i]->from () == grasp) loopGrasp = edges [1] [i];
+    else loopFree = edges [1] [i];
+  }
+  BOOST_REQUIRE (loopGrasp && loopFree);
+  const ConfigurationPtr_t q1 = elbowConfig (.3, .1);
+  Configuration_t q (*q1);
+  BOOST_REQUIRE (loopFree->applyConstraints (*q1, q));
+  const vector_t rhs = g->configConstraint (loopFree)->configProjector ()
+    ->rightHandSide ();
+  BOOST_CHECK (rhs.norm () > 0);
+  Configuration_t q2 (*q1);
+  BOOST_REQUIRE (g->configConstraint (grasp)->apply (q2));
+  BOOST_CHECK (grasp->contains (q2));
+  q = q2;
+  BOOST_REQUIRE (loopGrasp->applyConstraints (q2, q));
+  BOOST_CHECK (g->configConstraint (loopFree)->configProjector ()
+      ->rightHandSide () == rhs);
+  q = *q1;
+  BOOST_REQUIRE (loopFree->applyConstraints (*q1, q));
+  BOOST_CHECK (!grasp->contains (q));
+}
+
+BOOST_AUTO_TEST_CASE (LeafSampling)
+{
+  using namespace hpp_test;
+  DevicePtr_t arm = createArm ();
+  RoadmapPtr_t r = Roadmap::create
+    (hpp::core::WeighedDistance::create (arm), arm);
+  LeafHistogramPtr_t hist = LeafHistogram::create (armFoliation (arm));
+  r->insertHistogram (hist);
+
+  // Five leaves. Every third node is linked to the first one, the others
+  // are alone in their connected component.
+  RandomGenerator_t rng (4);
+  const value_type heights [] = { -.8, -.3, 0, .4, .9 };
+  const hpp::core::NodePtr_t first =
+    r->addNode (elbowConfig (heights [0], 0));
+  hpp::core::Nodes_t alone;
+  for (std::size_t i = 1; i < 60; ++i) {
+    const ConfigurationPtr_t q = elbowConfig (heights [i % 5],
+        M_PI * (2 * uniform01 (rng) - 1));
+    if (i % 3 == 0)
+      r->addNodeAndEdges (first, q, hpp::core::StraightPath::create
+          (arm, *first->configuration (), *q, 1));
+    else alone.push_back (r->addNode (q));
+  }
+  BOOST_REQUIRE (hist->numberOfBins () == 5);
+
+  const std::size_t nbDraws = 50000;
+  for (std::size_t k = 0; k < 3; ++k) {
+    // Then merge some connected components.
+    if (k > 0) {
+      for (std::size_t i = 0; i < 10 && !alone.empty (); ++i) {
+        const hpp::core::NodePtr_t n = alone.front ();
+        alone.pop_front ();
+        r->addEdge (first, n, hpp::core::StraightPath::create
+            (arm, *first->configuration (), *n->configuration (), 1));
+        r->addEdge (n, first, hpp::core::StraightPath::create
+            (arm, *n->configuration (), *first->configuration (), 1));
+      }
+    }
+    const hpp::core::ConnectedComponentPtr_t ccs [] =
+      { first->connectedComponent (), alone.front ()->connectedComponent () };
+    for (std::size_t c = 0; c < 2; ++c) {
+      const hpp::core::ConnectedComponentPtr_t& cc = ccs [c];
+      // The weights of getDistribOutOfConnectedComponent.
+      std::map <hpp::core::NodePtr_t, unsigned int> weights;
+      unsigned int total = 0;
+      for (LeafHistogram::const_iterator bin = hist->begin ();
+          bin != hist->end (); ++bin) {
+        const unsigned int w = bin->numberOfObsOutOfConnectedComponent (cc);
+        if (w == 0) continue;
+        weights [bin->nodes ().front ()] = w;
+        total += w;
+      }
+      const hpp::statistics::DiscreteDistribution <hpp::core::NodePtr_t>
+        distrib = hist->getDistribOutOfConnectedComponent (cc);
+      BOOST_CHECK (distrib.size () == weights.size ());
+      BOOST_CHECK (distrib.totalWeight () == total);
+
+      std::map <hpp::core::NodePtr_t, std::size_t> counts;
+      for (std::size_t j = 0; j < nbDraws; ++j) {
+        const hpp::core::NodePtr_t n =
+          hist->sampleOutOfConnectedComponent (cc, rng);
+        BOOST_REQUIRE (weights.count (n) == 1);
+        ++counts [n];
+      }
+      for (std::map <hpp::core::NodePtr_t, unsigned int>::const_iterator
+          it = weights.begin (); it != weights.end (); ++it) {
+        const value_type p = (value_type) it->second / total;
+        BOOST_CHECK_MESSAGE (std::abs ((value_type) counts [it->first]
+              / nbDraws - p) <= 5 * std::sqrt (p * (1 - p) / nbDraws),
+            "Leaf drawn " << counts [it->first] << " times out of "
+            << nbDraws << ", expected probability " << p);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE (LeafGrid)
+{
+  using namespace hpp_test;
+  DevicePtr_t arm = createArm ();
+  RoadmapPtr_t r = Roadmap::create
+    (hpp::core::WeighedDistance::create (arm), arm);
+  const Foliation f = armFoliation (arm);
+  LeafHistogramPtr_t hist = LeafHistogram::create (f);
+  r->insertHistogram (hist);
+  // Threshold of the leaves and size of the cells of the grid.
+  const value_type threshold = 1e-4, cellSize = 16 * threshold;
+
+  // Parameters on both sides of the borders of a few cells, in random
+  // order.
+  const value_type offsets [] = { -1.5e-4, -.9e-4, -.5e-4, -1e-5, 0, 1e-5,
+    .5e-4, .9e-4, 1.5e-4 };
+  std::vector <value_type> heights;
+  for (long k = 250; k < 254; ++k)
+    for (std::size_t i = 0; i < 9; ++i)
+      heights.push_back (k * cellSize + offsets [i]);
+  RandomGenerator_t rng (5);
+  for (std::size_t i = heights.size () - 1; i > 0; --i)
+    std::swap (heights [i], heights [uniformIndex (rng, i + 1)]);
+
+  // The leaves of a linear scan of the previous leaves.
+  std::vector <value_type> leaves;
+  std::vector <hpp::core::Nodes_t> leafNodes;
+  for (std::size_t i = 0; i < heights.size (); ++i) {
+    const hpp::core::NodePtr_t n = r->addNode (elbowConfig (heights [i], 0));
+    const value_type p = f.parameter (*n->configuration ()) [0];
+    std::size_t leaf = 0;
+    while (leaf < leaves.size () && std::abs (leaves [leaf] - p) >= threshold)
+      ++leaf;
+    if (leaf == leaves.size ()) {
+      leaves.push_back (p);
+      leafNodes.push_back (hpp::core::Nodes_t ());
+    }
+    leafNodes [leaf].push_back (n);
+  }
+
+  BOOST_REQUIRE (hist->numberOfBins () == leaves.size ());
+  std::size_t leaf = 0;
+  for (LeafHistogram::const_iterator bin = hist->begin ();
+      bin != hist->end (); ++bin, ++leaf) {
+    BOOST_CHECK (bin->value () [0] == leaves [leaf]);
+    BOOST_REQUIRE (bin->nodes ().size () == leafNodes [leaf].size ());
+    hpp::core::Nodes_t::const_iterator n = leafNodes [leaf].begin ();
+    for (LeafBin::RoadmapNodes_t::const_iterator it = bin->nodes ().begin ();
+        it != bin->nodes ().end (); ++it, ++n)
+      BOOST_CHECK (*it == *n);
+  }
+}
+
+BOOST_AUTO_TEST_CASE (AsynchronousStatistics)
+{
+  using namespace hpp_test;
+  DevicePtr_t arm = createArm ();
+  RoadmapPtr_t r = Roadmap::create
+    (hpp::core::WeighedDistance::create (arm), arm);
+  RoadmapPtr_t reference = Roadmap::create
+    (hpp::core::WeighedDistance::create (arm), arm);
+  LeafHistogramPtr_t hist = LeafHistogram::create (armFoliation (arm));
+  LeafHistogramPtr_t refHist = LeafHistogram::create (armFoliation (arm));
+  r->insertHistogram (hist);
+  reference->insertHistogram (refHist);
+
+  // A foliation set without factories cannot be evaluated by the
+  // statistics thread.
+  Foliation noFactory;
+  noFactory.condition (everywhere (arm));
+  noFactory.parametrizer (elbowHeight (arm));
+  RoadmapPtr_t other = Roadmap::create
+    (hpp::core::WeighedDistance::create (arm), arm);
+  other->insertHistogram (LeafHistogram::create (noFactory));
+  BOOST_CHECK_THROW (other->asynchronousStatistics (true), std::logic_error);
+  BOOST_CHECK (!other->asynchronousStatistics ());
+
+  r->asynchronousStatistics (true);
+  BOOST_REQUIRE (r->asynchronousStatistics ());
+  BOOST_CHECK_THROW (r->insertHistogram (LeafHistogram::create (noFactory)),
+      std::logic_error);
+
+  // The same nodes in both roadmaps. The statistics of r are up to date
+  // after sync.
+  RandomGenerator_t rng (6);
+  for (std::size_t i = 0; i < 300; ++i) {
+    const ConfigurationPtr_t q = elbowConfig
+      (.9 * ARM_LENGTH * (2 * uniform01 (rng) - 1), 0);
+    r->addNode (q);
+    reference->addNode (q);
+    if (i == 99) {
+      r->sync ();
+      BOOST_CHECK (hist->numberOfObservations () == 100);
+    }
+  }
+  r->sync ();
+  BOOST_CHECK (hist->numberOfObservations () == 300);
+  BOOST_REQUIRE (hist->numberOfBins () == refHist->numberOfBins ());
+  for (LeafHistogram::const_iterator bin = hist->begin (),
+      refBin = refHist->begin (); bin != hist->end (); ++bin, ++refBin) {
+    BOOST_CHECK (bin->value () == refBin->value ());
+    BOOST_CHECK (bin->nodes ().size () == refBin->nodes ().size ());
+  }
+
+  // Stopping the thread inserts the queued nodes.
+  for (std::size_t i = 0; i < 20; ++i)
+    r->addNode (elbowConfig (.5, 0));
+  r->asynchronousStatistics (false);
+  BOOST_CHECK (!r->asynchronousStatistics ());
+  BOOST_CHECK (hist->numberOfObservations () == 320);
+}
+
+BOOST_AUTO_TEST_CASE (NearestNode)
+{
+  using namespace hpp_test;
+  DevicePtr_t arm = createArm ();
+  hpp::core::DistancePtr_t distance = hpp::core::WeighedDistance::create (arm);
+  RandomGenerator_t rng (1);
+
+  // Without constraint graph, the nearest node of the connected component.
+  RoadmapPtr_t r = Roadmap::create (distance, arm);
+  hpp::core::Nodes_t nodes = fillRoadmap (r, arm, 200);
+  const hpp::core::ConnectedComponentPtr_t cc =
+    nodes.front ()->connectedComponent ();
+  for (std::size_t i = 0; i < 50; ++i) {
+    const ConfigurationPtr_t q = randomArmConfig (rng);
+    value_type d, expectedD;
+    const hpp::core::NodePtr_t expected =
+      linearNearest (nodes, *distance, *q, cc, expectedD);
+    BOOST_CHECK (r->nearestNode (q, cc, Nodes_t (), d) == expected);
+    BOOST_CHECK_CLOSE (d, expectedD, 1e-10);
+  }
+
+  // With a constraint graph, the nodes are searched in the given states.
+  GraphPtr_t g = createArmGraph (arm);
+  const Nodes_t& states = g->nodeSelector ()->getNodes ();
+  const NodePtr_t graspState = states [0], freeState = states [1];
+  r = Roadmap::create (distance, arm);
+  r->constraintGraph (g);
+  nodes = fillRoadmap (r, arm, 200);
+  BOOST_REQUIRE (g->getNode (*nodes.front ()->configuration ()) == freeState);
+  const hpp::core::ConnectedComponentPtr_t linked =
+    nodes.front ()->connectedComponent ();
+  const hpp::core::NodePtr_t alone = *++nodes.begin ();
+  for (std::size_t i = 0; i < 50; ++i) {
+    const ConfigurationPtr_t q = randomArmConfig (rng);
+    value_type d, expectedD;
+    const hpp::core::NodePtr_t expected =
+      linearNearest (nodes, *distance, *q, linked, expectedD);
+    BOOST_CHECK (r->nearestNode (q, linked, freeState, d) == expected);
+    BOOST_CHECK_CLOSE (d, expectedD, 1e-10);
+    BOOST_CHECK (r->nearestNode (q, alone->connectedComponent (), freeState,
+          d) == alone);
+    BOOST_CHECK (r->nearestNode (q, linked, graspState, d) == NULL);
+
+    // The k nearest nodes within a radius, by increasing distance.
+    std::vector < std::pair <value_type, hpp::core::NodePtr_t> > sorted;
+    for (hpp::core::Nodes_t::const_iterator it = nodes.begin ();
+        it != nodes.end (); ++it)
+      if ((*it)->connectedComponent () == linked)
+        sorted.push_back (std::make_pair
+            ((*distance) (*(*it)->configuration (), *q), *it));
+    std::sort (sorted.begin (), sorted.end ());
+    const value_type radius = 1.;
+    const hpp::core::Nodes_t neighbors =
+      r->nearestNodes (q, linked, Nodes_t (1, freeState), 5, radius);
+    std::size_t j = 0;
+    for (hpp::core::Nodes_t::const_iterator it = neighbors.begin ();
+        it != neighbors.end (); ++it, ++j) {
+      BOOST_CHECK (*it == sorted [j].second);
+      BOOST_CHECK (sorted [j].first <= radius);
+    }
+    BOOST_CHECK (j == 5 || j == sorted.size () || sorted [j].first > radius);
+    BOOST_CHECK (j <= 5);
+  }
+}
+
+BOOST_AUTO_TEST_CASE (ParallelExtension)
+{
+  using namespace hpp_test;
+  const std::vector <Configuration_t>
+    sequential = configurations (planArm (1, 20)),
+    parallel = configurations (planArm (3, 20));
+  BOOST_CHECK (sequential.size () > 2);
+  BOOST_REQUIRE (sequential.size () == parallel.size ());
+  for (std::size_t i = 0; i < sequential.size (); ++i)
+    BOOST_CHECK_MESSAGE (sequential [i] == parallel [i],
+        "Roadmap node " << i << " differs with several threads");
+}
+
+BOOST_AUTO_TEST_CASE (Reproducibility)
+{
+  using namespace hpp_test;
+  // The same seed gives the same roadmap, another seed another one.
+  const std::vector <Configuration_t> first = configurations (planArm (1, 20)),
+    second = configurations (planArm (1, 20)),
+    other = configurations (planArm (1, 20, 0, 2));
+  BOOST_CHECK (first.size () > 2);
+  BOOST_REQUIRE (first.size () == second.size ());
+  for (std::size_t i = 0; i < first.size (); ++i)
+    BOOST_CHECK_MESSAGE (first [i] == second [i],
+        "Roadmap node " << i << " differs with the same seed");
+  bool differ = first.size () != other.size ();
+  for (std::size_t i = 0; !differ && i < first.size (); ++i)
+    differ = first [i] != other [i];
+  BOOST_CHECK (differ);
+}
+
+BOOST_AUTO_TEST_CASE (TimeBudget)
+{
+  using namespace hpp_test;
+  DevicePtr_t arm = createArm ();
+  GraphPtr_t g = createArmGraph (arm);
+
+  // No path reaches the goal.
+  ConfigurationPtr_t qInit (new Configuration_t
+      (Configuration_t::Zero (arm->configSize ())));
+  ConfigurationPtr_t qGoal (new Configuration_t (*qInit));
+  (*qGoal) [1] = 1;
+  Problem problem (arm);
+  problem.pathValidation (GraphPathValidation::create
+      (hpp::core::PathValidationPtr_t (new AvoidConfiguration (*qGoal, .1))));
+  problem.constraintGraph (g);
+  problem.initConfig (qInit);
+  problem.addGoalConfig (qGoal);
+  RoadmapPtr_t roadmap = Roadmap::create (problem.distance (), arm);
+  roadmap->constraintGraph (g);
+  ManipulationPlannerPtr_t planner =
+    ManipulationPlanner::create (problem, roadmap);
+  BOOST_CHECK_THROW (planner->timeBudget (-1), std::invalid_argument);
+  BOOST_CHECK (planner->timeBudget () == 0);
+
+  // solve stops soon after the time budget.
+  planner->timeBudget (.5);
+  const boost::posix_time::ptime start =
+    boost::posix_time::microsec_clock::universal_time ();
+  BOOST_CHECK_THROW (planner->solve (), std::runtime_error);
+  const value_type elapsed = 1e-6 * (value_type)
+    (boost::posix_time::microsec_clock::universal_time () - start)
+    .total_microseconds ();
+  BOOST_CHECK (elapsed >= .5);
+  BOOST_CHECK_MESSAGE (elapsed < 1.5, "solve took " << elapsed << " s");
+  BOOST_CHECK (roadmap->nodes ().size () > 2);
+}
+
+BOOST_AUTO_TEST_CASE (AdaptiveEdgeWeights)
+{
+  using namespace hpp_test;
+  DevicePtr_t arm = createArm ();
+  GraphPtr_t g = Graph::create ("adaptive", arm,
+      SteeringMethodStraight::create (arm));
+  g->maxIterations (20);
+  g->errorThreshold (1e-4);
+  // The projection onto unreachable always fails, the extensions along
+  // loop succeed.
+  NodeSelectorPtr_t selector = g->createNodeSelector ("selector");
+  NodePtr_t unreachable = selector->createNode ("unreachable");
+  NodePtr_t freeState = selector->createNode ("free");
+  unreachable->addNumericalConstraint
+    (GraphComponent::NumericalConstraintFactory_t
+     (boost::bind (&tipHeight, _1, 5.)));
+  const EdgePtr_t loop = freeState->linkTo ("loop", freeState, 1);
+  const EdgePtr_t fail = freeState->linkTo ("fail", unreachable, 1);
+
+  Problem problem (arm);
+  problem.pathValidation (collisionChecking (arm));
+  problem.constraintGraph (g);
+  ConfigurationPtr_t qInit (new Configuration_t
+      (Configuration_t::Zero (arm->configSize ())));
+  ConfigurationPtr_t qGoal (new Configuration_t (*qInit));
+  (*qGoal) [1] = M_PI / 2;
+  problem.initConfig (qInit);
+  problem.addGoalConfig (qGoal);
+  RoadmapPtr_t roadmap = Roadmap::create (problem.distance (), arm);
+  roadmap->constraintGraph (g);
+  ManipulationPlannerPtr_t planner =
+    ManipulationPlanner::create (problem, roadmap);
+  planner->seed (1);
+  planner->explorationFactor (0);
+  planner->adaptiveEdgeWeights (true);
+  planner->startSolve ();
+  for (std::size_t i = 0; i < 50; ++i) planner->oneStep ();
+
+  // The weights move toward the edge that succeeds.
+  std::map <EdgePtr_t, Weight_t> weights;
+  for (Neighbors_t::const_iterator it = freeState->neighbors ().begin ();
+      it != freeState->neighbors ().end (); ++it)
+    weights [it->second] = it->first;
+  BOOST_CHECK_MESSAGE (weights [loop] > weights [fail], "Weights "
+      << weights [loop] << " of loop and " << weights [fail] << " of fail");
+
+  // Disabling restores the initial weights.
+  planner->adaptiveEdgeWeights (false);
+  BOOST_CHECK (!planner->adaptiveEdgeWeights ());
+  for (Neighbors_t::const_iterator it = freeState->neighbors ().begin ();
+      it != freeState->neighbors ().end (); ++it)
+    BOOST_CHECK (it->first == 1);
+}
+
+BOOST_AUTO_TEST_CASE (GoalDirectedEdgeChoice)
+{
+  using namespace hpp_test;
+  DevicePtr_t arm = createArm ();
+  GraphPtr_t g = createArmGraph (arm);
+  const NodePtr_t grasp = g->nodeSelector ()->getNodes () [0],
+        freeState = g->nodeSelector ()->getNodes () [1];
+  EdgePtr_t loopFree, freeGrasp;
+  for (Neighbors_t::const_iterator it = freeState->neighbors ().begin ();
+      it != freeState->neighbors ().end (); ++it) {
+    if (it->second->name () == "loop-free") loopFree = it->second;
+    if (it->second->name () == "free-grasp") freeGrasp = it->second;
+  }
+  BOOST_REQUIRE (loopFree && freeGrasp);
+
+  // From free to a goal in grasp.
+  Problem problem (arm);
+  problem.pathValidation (collisionChecking (arm));
+  problem.constraintGraph (g);
+  ConfigurationPtr_t qInit (new Configuration_t (2));
+  *qInit << .3, .2;
+  ConfigurationPtr_t qGoal (new Configuration_t (*qInit));
+  BOOST_REQUIRE (g->configConstraint (grasp)->apply (*qGoal));
+  BOOST_REQUIRE (g->getNode (*qInit) == freeState);
+  problem.initConfig (qInit);
+  problem.addGoalConfig (qGoal);
+  RoadmapPtr_t roadmap = Roadmap::create (problem.distance (), arm);
+  roadmap->constraintGraph (g);
+  ManipulationPlannerPtr_t planner =
+    ManipulationPlanner::create (problem, roadmap);
+  planner->seed (1);
+  planner->measureLatencies (true);
+  planner->goalDirectedEdgeChoice (true);
+  planner->startSolve ();
+  BOOST_CHECK (planner->costToGoal (grasp) == 0);
+  BOOST_CHECK (planner->costToGoal (freeState) > 0);
+
+  // Without exploration, the nodes of free are only extended along the
+  // edge reducing the cost to the goal.
+  planner->explorationRatio (0);
+  for (std::size_t i = 0; i < 20; ++i) planner->oneStep ();
+  BOOST_CHECK (planner->latency (ManipulationPlanner::APPLY_CONSTRAINTS,
+        freeGrasp).count () > 0);
+  BOOST_CHECK (planner->latency (ManipulationPlanner::APPLY_CONSTRAINTS,
+        loopFree).count () == 0);
+
+  // With exploration only, the edges are chosen by the graph.
+  planner->clearLatencies ();
+  planner->explorationRatio (1);
+  for (std::size_t i = 0; i < 20; ++i) planner->oneStep ();
+  BOOST_CHECK (planner->latency (ManipulationPlanner::APPLY_CONSTRAINTS,
+        loopFree).count () > 0);
+}
+
+BOOST_AUTO_TEST_CASE (Latencies)
+{
+  using namespace hpp_test;
+  DevicePtr_t arm = createArm ();
+  GraphPtr_t g = createArmGraph (arm);
+  Problem problem (arm);
+  problem.pathValidation (collisionChecking (arm));
+  problem.constraintGraph (g);
+  ConfigurationPtr_t qInit (new Configuration_t
+      (Configuration_t::Zero (arm->configSize ())));
+  ConfigurationPtr_t qGoal (new Configuration_t (*qInit));
+  (*qGoal) [1] = M_PI / 2;
+  problem.initConfig (qInit);
+  problem.addGoalConfig (qGoal);
+  RoadmapPtr_t roadmap = Roadmap::create (problem.distance (), arm);
+  roadmap->constraintGraph (g);
+  ManipulationPlannerPtr_t planner =
+    ManipulationPlanner::create (problem, roadmap);
+  planner->numberOfThreads (3);
+  planner->pathValidationFactory (&collisionChecking);
+  planner->measureLatencies (true);
+  planner->seed (1);
+  planner->startSolve ();
+  for (std::size_t i = 0; i < 10; ++i) planner->oneStep ();
+
+  // The durations recorded by the threads are merged: each projection is
+  // counted once for all the edges and once for its edge.
+  std::vector <EdgePtr_t> edges;
+  const Nodes_t& states = g->nodeSelector ()->getNodes ();
+  for (std::size_t i = 0; i < states.size (); ++i)
+    for (Neighbors_t::const_iterator it = states [i]->neighbors ().begin ();
+        it != states [i]->neighbors ().end (); ++it)
+      edges.push_back (it->second);
+  const std::size_t total = planner->latency
+    (ManipulationPlanner::APPLY_CONSTRAINTS).count ();
+  std::size_t sum = 0;
+  for (std::size_t i = 0; i < edges.size (); ++i)
+    sum += planner->latency (ManipulationPlanner::APPLY_CONSTRAINTS,
+        edges [i]).count ();
+  BOOST_CHECK (total > 0);
+  BOOST_CHECK (sum == total);
+
+  // The JSON object has every stage and the edges with durations.
+  std::ostringstream oss;
+  planner->printLatenciesJSON (oss);
+  const std::string json = oss.str ();
+  BOOST_CHECK (json.compare (0, 12, "{\"stages\": {") == 0);
+  BOOST_CHECK (std::count (json.begin (), json.end (), '{')
+      == std::count (json.begin (), json.end (), '}'));
+  for (std::size_t i = 0; i < ManipulationPlanner::NB_STAGES; ++i)
+    BOOST_CHECK (json.find (std::string ("\"") + ManipulationPlanner::stageName
+          ((ManipulationPlanner::Stage) i) + "\": ") != std::string::npos);
+  for (std::size_t i = 0; i < edges.size (); ++i) {
+    const bool recorded = planner->latency
+      (ManipulationPlanner::APPLY_CONSTRAINTS, edges [i]).count () > 0;
+    BOOST_CHECK ((json.find ("\"" + edges [i]->name () + "\": {")
+          != std::string::npos) == recorded);
+  }
+
+  planner->clearLatencies ();
+  BOOST_CHECK (planner->latency
+      (ManipulationPlanner::APPLY_CONSTRAINTS).count () == 0);
+  std::ostringstream cleared;
+  planner->printLatenciesJSON (cleared);
+  BOOST_CHECK (cleared.str ().find ("\"edges\": {}}") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE (PipelinedExtension)
+{
+  using namespace hpp_test;
+  // The order of the extensions depends on the workers, but all of them
+  // link configurations of the states of the graph.
+  const RoadmapPtr_t r = planArm (1, 20, 8);
+  BOOST_CHECK (r->nodes ().size () > 2);
+  BOOST_CHECK (r->edges ().size () > 0);
+  for (hpp::core::Edges_t::const_iterator it = r->edges ().begin ();
+      it != r->edges ().end (); ++it) {
+    const hpp::core::PathPtr_t& path = (*it)->path ();
+    BOOST_CHECK ((path->initial () - *(*it)->from ()->configuration ())
+        .norm () < 1e-4);
+    BOOST_CHECK ((path->end () - *(*it)->to ()->configuration ()).norm ()
+        < 1e-4);
+    BOOST_CHECK (roadmapNode ((*it)->to ())->graphNode ());
+  }
+}
+
+BOOST_AUTO_TEST_CASE (ThreadChanges)
+{
+  using namespace hpp_test;
+  DevicePtr_t arm = createArm ();
+  GraphPtr_t g = createArmGraph (arm);
+  Problem problem (arm);
+  problem.pathValidation (collisionChecking (arm));
+  problem.constraintGraph (g);
+  ConfigurationPtr_t qInit (new Configuration_t
+      (Configuration_t::Zero (arm->configSize ())));
+  ConfigurationPtr_t qGoal (new Configuration_t (*qInit));
+  (*qGoal) [1] = M_PI / 2;
+  problem.initConfig (qInit);
+  problem.addGoalConfig (qGoal);
+
+  // The threads change between the steps.
+  RoadmapPtr_t roadmap = Roadmap::create (problem.distance (), arm);
+  roadmap->constraintGraph (g);
+  ManipulationPlannerPtr_t planner =
+    ManipulationPlanner::create (problem, roadmap);
+  planner->pathValidationFactory (&collisionChecking);
+  planner->seed (1);
+  planner->startSolve ();
+  const std::size_t nbThreads [] = { 2, 3, 1, 2 };
+  for (std::size_t i = 0; i < 4; ++i) {
+    planner->numberOfThreads (nbThreads [i]);
+    BOOST_CHECK_NO_THROW (planner->oneStep ());
+    const std::vector <std::size_t> slots = planner->threadSlots ();
+    for (std::size_t j = 0; j < slots.size (); ++j)
+      BOOST_CHECK (std::binary_search (g->threadSlots ().begin (),
+            g->threadSlots ().end (), slots [j]));
+  }
+  planner->pipeline (1, 1, 1, 4);
+  BOOST_CHECK_NO_THROW (planner->oneStep ());
+  // Jobs are in the pipeline when the threads change.
+  planner->numberOfThreads (3);
+  BOOST_CHECK_NO_THROW (planner->oneStep ());
+
+  // A second planner uses the graph, as a ProblemSolver creates one per
+  // resolution.
+  RoadmapPtr_t other = Roadmap::create (problem.distance (), arm);
+  other->constraintGraph (g);
+  ManipulationPlannerPtr_t second =
+    ManipulationPlanner::create (problem, other);
+  second->numberOfThreads (2);
+  second->pathValidationFactory (&collisionChecking);
+  second->seed (2);
+  second->startSolve ();
+  for (std::size_t i = 0; i < 5; ++i) {
+    BOOST_CHECK_NO_THROW (second->oneStep ());
+    BOOST_CHECK_NO_THROW (planner->oneStep ());
+  }
+}
+
+BOOST_AUTO_TEST_CASE (SaveLoad)
+{
+  using namespace hpp_test;
+  const std::string filename ("test-constraintgraph-roadmap.bin");
+
+  // The edges of the roadmap must have been built by the constraint graph.
+  DevicePtr_t arm = createArm ();
+  RoadmapPtr_t r = Roadmap::create
+    (hpp::core::WeighedDistance::create (arm), arm);
+  r->constraintGraph (createArmGraph (arm));
+  fillRoadmap (r, arm, 10);
+  BOOST_CHECK_THROW (r->save (filename), std::runtime_error);
+
+  // The roadmap is loaded in another constraint graph with the same names.
+  const RoadmapPtr_t saved = planArm (1, 20);
+  BOOST_REQUIRE (saved->edges ().size () > 0);
+  saved->save (filename);
+  arm = createArm ();
+  r = Roadmap::create (hpp::core::WeighedDistance::create (arm), arm);
+  GraphPtr_t g = createArmGraph (arm);
+  r->constraintGraph (g);
+  r->load (filename, collisionChecking (arm));
+  std::remove (filename.c_str ());
+
+  BOOST_CHECK (configurations (r) == configurations (saved));
+  hpp::core::Nodes_t::const_iterator it = r->nodes ().begin ();
+  for (hpp::core::Nodes_t::const_iterator itSaved = saved->nodes ().begin ();
+      itSaved != saved->nodes ().end (); ++itSaved, ++it)
+    BOOST_CHECK (roadmapNode (*it)->graphNode ()->name ()
+        == roadmapNode (*itSaved)->graphNode ()->name ());
+  BOOST_CHECK (r->connectedComponents ().size ()
+      == saved->connectedComponents ().size ());
+  BOOST_REQUIRE (r->edges ().size () == saved->edges ().size ());
+  for (hpp::core::Edges_t::const_iterator itE = r->edges ().begin ();
+      itE != r->edges ().end (); ++itE) {
+    const hpp::core::PathPtr_t& path = (*itE)->path ();
+    BOOST_CHECK ((path->initial () - *(*itE)->from ()->configuration ())
+        .norm () < 1e-4);
+    BOOST_CHECK ((path->end () - *(*itE)->to ()->configuration ()).norm ()
+        < 1e-4);
+    bool found = false;
+    for (hpp::core::Edges_t::const_iterator itSaved = saved->edges ().begin ();
+        itSaved != saved->edges ().end () && !found; ++itSaved)
+      found = *(*itSaved)->from ()->configuration ()
+        == *(*itE)->from ()->configuration ()
+        && *(*itSaved)->to ()->configuration ()
+        == *(*itE)->to ()->configuration ()
+        && (*itSaved)->path ()->constraints ()->name ()
+        == path->constraints ()->name ();
+    BOOST_CHECK (found);
+  }
+}
+
+BOOST_AUTO_TEST_CASE (SavePathVectors)
+{
+  using namespace hpp_test;
+  const std::string filename ("test-constraintgraph-vectors.bin");
+  DevicePtr_t arm = createArm ();
+  GraphPtr_t g = createArmGraph (arm);
+  const Nodes_t& states = g->nodeSelector ()->getNodes ();
+  const NodePtr_t graspState = states [0], freeState = states [1];
+  WaypointEdgePtr_t waypoint = HPP_DYNAMIC_PTR_CAST (WaypointEdge,
+      freeState->linkTo ("free-grasp-waypoint", graspState, 1, false,
+        WaypointEdge::create));
+  BOOST_REQUIRE (waypoint);
+  waypoint->createWaypoint (0, "free-grasp-waypoint");
+  const EdgePtr_t loopGrasp = g->getEdges (graspState, graspState).front ();
+
+  // The path of a waypoint edge and a projected path are path vectors.
+  hpp::core::WeighedDistancePtr_t distance =
+    hpp::core::WeighedDistance::create (arm);
+  RoadmapPtr_t r = Roadmap::create (distance, arm);
+  r->constraintGraph (g);
+  ConfigurationPtr_t qFree (new Configuration_t (Configuration_t::Zero (2))),
+    qGrasp (new Configuration_t (2)), qGrasp2 (new Configuration_t (2));
+  *qGrasp << 0, M_PI / 2;
+  *qGrasp2 << .3, 1.;
+  BOOST_REQUIRE (g->configConstraint (graspState)->apply (*qGrasp2));
+  const hpp::core::NodePtr_t nFree = r->addNode (qFree),
+        nGrasp = r->addNode (qGrasp), nGrasp2 = r->addNode (qGrasp2);
+  hpp::core::PathPtr_t path, projected;
+  BOOST_REQUIRE (waypoint->build (path, *qFree, *qGrasp, *distance));
+  BOOST_CHECK (HPP_DYNAMIC_PTR_CAST (hpp::core::PathVector, path));
+  r->addEdge (nFree, nGrasp, path);
+  BOOST_REQUIRE (loopGrasp->build (path, *qGrasp, *qGrasp2, *distance));
+  PathProjectorPtr_t projector = hpp::core::pathProjector::Progressive::create
+    (distance, SteeringMethodStraight::create (arm), .1);
+  BOOST_REQUIRE (projector->apply (path, projected));
+  BOOST_CHECK (HPP_DYNAMIC_PTR_CAST (hpp::core::PathVector, projected));
+  r->addEdge (nGrasp, nGrasp2, projected);
+  BOOST_CHECK_NO_THROW (r->save (filename));
+
+  // Both edges are rebuilt by the same edges of the constraint graph.
+  RoadmapPtr_t loaded = Roadmap::create (distance, arm);
+  loaded->constraintGraph (g);
+  loaded->load (filename, GraphPathValidationPtr_t (), projector);
+  std::remove (filename.c_str ());
+  BOOST_REQUIRE (loaded->edges ().size () == 2);
+  BOOST_CHECK (configurations (loaded) == configurations (r));
+  loaded->save (filename);
+  std::remove (filename.c_str ());
+}
+
+BOOST_AUTO_TEST_CASE (MultiQuery)
+{
+  using namespace hpp_test;
+  DevicePtr_t arm = createArm ();
+  ProblemSolver ps;
+  ps.robot (arm);
+  GraphPtr_t g = createArmGraph (arm);
+  ps.constraintGraph (g);
+  ps.problem ()->pathValidation (collisionChecking (arm));
+  ps.problem ()->constraintGraph (g);
+  ps.multiQuery (true);
+  ps.resetRoadmap ();
+  const hpp::core::RoadmapPtr_t roadmap = ps.roadmap ();
+
+  // Two queries with the same initial configuration and different goals.
+  ConfigurationPtr_t qInit (new Configuration_t
+      (Configuration_t::Zero (arm->configSize ())));
+  std::size_t nbNodes = 0;
+  for (std::size_t i = 0; i < 2; ++i) {
+    ps.resetRoadmap ();
+    BOOST_CHECK (ps.roadmap () == roadmap);
+    BOOST_CHECK (ps.roadmap ()->goalNodes ().empty ());
+    BOOST_CHECK (ps.roadmap ()->nodes ().size () >= nbNodes);
+    ConfigurationPtr_t qGoal (new Configuration_t (*qInit));
+    (*qGoal) [1] = (i == 0 ? 1 : -1) * M_PI / 2;
+    ps.problem ()->initConfig (qInit);
+    ps.problem ()->resetGoalConfigs ();
+    ps.problem ()->addGoalConfig (qGoal);
+    ManipulationPlannerPtr_t planner =
+      ManipulationPlanner::create (*ps.problem (), ps.roadmap ());
+    planner->seed (seed);
+    planner->startSolve ();
+    for (std::size_t j = 0; j < 20; ++j) planner->oneStep ();
+    nbNodes = ps.roadmap ()->nodes ().size ();
+  }
+
+  // The roadmap is dropped when the path validation or the graph changes.
+  ps.problem ()->pathValidation (collisionChecking (arm));
+  ps.resetRoadmap ();
+  BOOST_CHECK (ps.roadmap () != roadmap);
+  const hpp::core::RoadmapPtr_t second = ps.roadmap ();
+  ps.resetRoadmap ();
+  BOOST_CHECK (ps.roadmap () == second);
+  ps.constraintGraph (createArmGraph (arm));
+  ps.resetRoadmap ();
+  BOOST_CHECK (ps.roadmap () != second);
+}
+
+BOOST_AUTO_TEST_CASE (LazyConnection)
+{
+  using namespace hpp_test;
+  DevicePtr_t arm = createArm ();
+  GraphPtr_t g = createArmGraph (arm);
+
+  // The straight path from init to goal passes through blocked, whereas
+  // the ones through detour do not. All of them are in the state free.
+  Configuration_t qBlocked (2), qDetour (2);
+  qBlocked << 0, .5;
+  qDetour << .5, .5;
+  hpp::core::PathValidationPtr_t avoid (new AvoidConfiguration (qBlocked, .2));
+  Problem problem (arm);
+  problem.pathValidation (GraphPathValidation::create (avoid));
+  problem.constraintGraph (g);
+  ConfigurationPtr_t qInit (new Configuration_t
+      (Configuration_t::Zero (arm->configSize ())));
+  ConfigurationPtr_t qGoal (new Configuration_t (*qInit));
+  (*qGoal) [1] = 1;
+  problem.initConfig (qInit);
+  problem.addGoalConfig (qGoal);
+  RoadmapPtr_t roadmap = Roadmap::create (problem.distance (), arm);
+  roadmap->constraintGraph (g);
+  const hpp::core::NodePtr_t blocked =
+    roadmap->addNode (ConfigurationPtr_t (new Configuration_t (qBlocked)));
+  const hpp::core::NodePtr_t detour =
+    roadmap->addNode (ConfigurationPtr_t (new Configuration_t (qDetour)));
+
+  ManipulationPlannerPtr_t planner =
+    ManipulationPlanner::create (problem, roadmap);
+  planner->lazyConnection (true);
+  planner->startSolve ();
+
+  // The connections to blocked and the direct one are rejected, the ones
+  // through detour solve the query.
+  BOOST_CHECK (roadmap->pathExists ());
+  const hpp::core::ConnectedComponentPtr_t cc =
+    roadmap->initNode ()->connectedComponent ();
+  BOOST_CHECK (detour->connectedComponent () == cc);
+  BOOST_CHECK (blocked->connectedComponent () != cc);
+  hpp::core::PathPtr_t validPart;
+  for (hpp::core::Edges_t::const_iterator it = roadmap->edges ().begin ();
+      it != roadmap->edges ().end (); ++it)
+    BOOST_CHECK (avoid->validate ((*it)->path (), false, validPart));
+
+  // The connections kept aside are deleted with the nodes of the roadmap,
+  // and only the latest ones are kept.
+  roadmap->clear ();
+  const hpp::core::NodePtr_t alone =
+    roadmap->addNode (ConfigurationPtr_t (new Configuration_t (qBlocked)));
+  planner->maxLazyEdges (1);
+  planner->startSolve ();
+  BOOST_CHECK (!roadmap->pathExists ());
+  BOOST_CHECK (alone->connectedComponent ()
+      != roadmap->initNode ()->connectedComponent ());
+}
+
 #ifdef TEST_UR5
 BOOST_AUTO_TEST_CASE (ConstraintSets)
 {
@@ -0,0 +1,88 @@
+// Copyright (c) 2014, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_TESTS_TOY_ROBOT_HH
+# define HPP_MANIPULATION_TESTS_TOY_ROBOT_HH
+
+# include <hpp/model/device.hh>
+# include <hpp/model/joint.hh>
+# include <hpp/model/body.hh>
+# include <hpp/model/object-factory.hh>
+
+# define ARM_LENGTH 1
+# define FOREARM_LENGTH 1
+
+namespace hpp_test {
+  /// Factory of the joints and bodies of the toy robots.
+  inline hpp::model::ObjectFactory& objectFactory ()
+  {
+    static hpp::model::ObjectFactory factory;
+    return factory;
+  }
+
+  /// Add a planar arm to a robot.
+  ///
+  /// The arm has two bounded rotation joints, ARM and FOREARM, and an end
+  /// effector EE at the end of the forearm. In the zero configuration, the
+  /// arm is along the y axis.
+  inline void addArm (const hpp::model::DevicePtr_t& robot)
+  {
+    using hpp::model::JointPtr_t;
+    using hpp::model::BodyPtr_t;
+    BodyPtr_t body;
+    fcl::Transform3f pos;
+    fcl::Matrix3f orient;
+    orient (0,0) = 1; orient (0,1) = 0; orient (0,2) = 0;
+    orient (1,0) = 0; orient (1,1) = 1; orient (1,2) = 0;
+    orient (2,0) = 0; orient (2,1) = 0; orient (2,2) = 1;
+    pos.setRotation (orient);
+    // Arm joint
+    pos.setTranslation (fcl::Vec3f (0, 0, 0));
+    JointPtr_t arm = objectFactory ().createBoundedJointRotation (pos);
+    robot->rootJoint (arm);
+    arm->name ("ARM");
+    body = objectFactory ().createBody ();
+    body->name ("ARM_BODY");
+    arm->setLinkedBody (body);
+    // Forearm joint
+    pos.setTranslation (fcl::Vec3f (0, ARM_LENGTH, 0));
+    JointPtr_t forearm = objectFactory ().createBoundedJointRotation (pos);
+    forearm->name ("FOREARM");
+    arm->addChildJoint (forearm);
+    body = objectFactory ().createBody ();
+    body->name ("FOREARM_BODY");
+    forearm->setLinkedBody (body);
+    // End effector joint
+    pos.setTranslation (fcl::Vec3f (0, FOREARM_LENGTH, 0));
+    JointPtr_t ee = objectFactory ().createJointAnchor (pos);
+    ee->name ("EE");
+    body = objectFactory ().createBody ();
+    body->name ("EE");
+    ee->setLinkedBody (body);
+    forearm->addChildJoint (ee);
+  }
+
+  /// Create a robot made of the planar arm.
+  /// \sa addArm
+  inline hpp::model::DevicePtr_t createRobot ()
+  {
+    hpp::model::DevicePtr_t robot = hpp::model::Device::create ("test");
+    addArm (robot);
+    return robot;
+  }
+} // namespace hpp_test
+
+#endif // HPP_MANIPULATION_TESTS_TOY_ROBOT_HH